@@ -108,8 +108,8 @@ bool fido2_app_init(Fido2App* app) {
         debug_log("Credentials exist, loading...");
         
         if(!fido2_data_load_credentials(app->credential_store)) {
-            FURI_LOG_W(TAG, "Failed to load credentials, starting fresh");
-            debug_log("Failed to load credentials, starting fresh");
+            FURI_LOG_W(TAG, "Failed to load credentials, leaving their files untouched");
+            debug_log("Failed to load credentials, leaving their files untouched");
         } else {
             FURI_LOG_I(TAG, "Loaded existing credentials");
             debug_log("Loaded existing credentials");
@@ -117,6 +117,8 @@ bool fido2_app_init(Fido2App* app) {
     } else {
         FURI_LOG_I(TAG, "No existing credentials, starting fresh");
         debug_log("No existing credentials, starting fresh");
+        // Still attach the store to its page file, which creates it with new keys
+        fido2_data_load_credentials(app->credential_store);
     }
 
     // Allocate CTAP2 module
@@ -157,20 +159,24 @@ void fido2_app_free(Fido2App* app) {
         app->hid = NULL;
     }
 
+    // Before the store: freeing CTAP rolls back an unfinished backup import,
+    // so its unverified records are neither saved nor left dangling
+    if(app->ctap) {
+        fido2_ctap_free(app->ctap);
+    }
+
     if(app->credential_store) {
+        // Saved even when empty: a rolled-back import may have deleted
+        // records that page eviction had already written
         size_t count = fido2_credential_count(app->credential_store);
-        if(count > 0) {
-            FURI_LOG_I(TAG, "Saving %u credentials", count);
-            debug_log("Saving credentials");
-            fido2_data_save_credentials(app->credential_store);
-        }
+        FURI_LOG_I(TAG, "Saving %u credentials", count);
+        debug_log("Saving credentials");
+        // Clean shutdown: record exact counters instead of lease ceilings
+        fido2_credential_release_counter_leases(app->credential_store);
+        fido2_data_save_credentials(app->credential_store);
         fido2_credential_store_free(app->credential_store);
     }
 
-    if(app->ctap) {
-        fido2_ctap_free(app->ctap);
-    }
-
     free(app);
     FURI_LOG_I(TAG, "FIDO2 app freed");
     debug_log("FIDO2 app freed");
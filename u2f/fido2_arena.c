@@ -0,0 +1,66 @@
+#include "fido2_arena.h"
+#include <furi.h>
+#include <string.h>
+
+#define TAG "FIDO2_ARENA"
+
+#define FIDO2_ARENA_ALIGN 4
+
+struct Fido2Arena {
+    uint8_t* buffer;
+    size_t size;
+    size_t used;
+    size_t high_water;
+};
+
+Fido2Arena* fido2_arena_alloc(size_t size) {
+    Fido2Arena* arena = malloc(sizeof(Fido2Arena));
+    arena->buffer = malloc(size);
+    arena->size = size;
+    arena->used = 0;
+    arena->high_water = 0;
+    memset(arena->buffer, 0, size);
+    return arena;
+}
+
+void fido2_arena_free(Fido2Arena* arena) {
+    if(!arena) return;
+    memset(arena->buffer, 0, arena->size);
+    free(arena->buffer);
+    free(arena);
+}
+
+void* fido2_arena_get(Fido2Arena* arena, size_t size) {
+    furi_check(arena);
+
+    size_t aligned = (size + FIDO2_ARENA_ALIGN - 1) & ~(size_t)(FIDO2_ARENA_ALIGN - 1);
+    if(aligned > arena->size - arena->used) {
+        FURI_LOG_E(TAG, "Exhausted: %u + %u > %u", arena->used, aligned, arena->size);
+        furi_crash("FIDO2 arena exhausted");
+    }
+
+    void* ptr = arena->buffer + arena->used;
+    arena->used += aligned;
+    if(arena->used > arena->high_water) arena->high_water = arena->used;
+
+    // The used region is wiped on reset, so the block is already zeroed
+    return ptr;
+}
+
+void fido2_arena_reset(Fido2Arena* arena) {
+    if(!arena) return;
+    memset(arena->buffer, 0, arena->used);
+    arena->used = 0;
+}
+
+size_t fido2_arena_used(const Fido2Arena* arena) {
+    return arena ? arena->used : 0;
+}
+
+size_t fido2_arena_high_water(const Fido2Arena* arena) {
+    return arena ? arena->high_water : 0;
+}
+
+size_t fido2_arena_size(const Fido2Arena* arena) {
+    return arena ? arena->size : 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fixed-size bump allocator for per-transaction scratch memory
+ *
+ * Allocated once and reset after every CTAP transaction, so command
+ * handlers do not keep large buffers on the HID worker stack.
+ */
+typedef struct Fido2Arena Fido2Arena;
+
+/**
+ * @brief Allocate arena
+ *
+ * @param size Capacity in bytes
+ */
+Fido2Arena* fido2_arena_alloc(size_t size);
+
+/**
+ * @brief Free arena
+ */
+void fido2_arena_free(Fido2Arena* arena);
+
+/**
+ * @brief Take zero-initialized, 4-byte aligned scratch memory
+ *
+ * Sizes are fixed per command, so exhaustion is a programming error and
+ * crashes instead of failing the request.
+ */
+void* fido2_arena_get(Fido2Arena* arena, size_t size);
+
+/**
+ * @brief Release all allocations and wipe the used region
+ */
+void fido2_arena_reset(Fido2Arena* arena);
+
+/**
+ * @brief Bytes currently allocated
+ */
+size_t fido2_arena_used(const Fido2Arena* arena);
+
+/**
+ * @brief Largest number of bytes ever allocated between two resets
+ */
+size_t fido2_arena_high_water(const Fido2Arena* arena);
+
+/**
+ * @brief Arena capacity in bytes
+ */
+size_t fido2_arena_size(const Fido2Arena* arena);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,291 @@
+#include "fido2_backup.h"
+#include "fido_hmac.h"
+#include "fido_drbg.h"
+#include <furi.h>
+#include <furi_hal.h>
+#include <string.h>
+
+#define TAG "FIDO2_BACKUP"
+
+typedef enum {
+    Fido2BackupStateIdle,
+    Fido2BackupStateExport,
+    Fido2BackupStateImport,
+    Fido2BackupStateImportVerified, // final tag checked, waiting for the commit
+} Fido2BackupState;
+
+struct Fido2Backup {
+    Fido2CredentialStore* store;
+    Fido2BackupState state;
+    uint8_t nonce[FIDO2_BACKUP_NONCE_SIZE];
+    uint8_t enc_key[32];
+    FidoHmacKey mac_key; // midstates, reused for every chunk MAC
+    uint32_t seq; // next expected/produced sequence number
+    size_t slot; // next store slot to export
+    uint8_t imported[FIDO2_MAX_CREDENTIALS / 8]; // bitmap of slots added by the import
+    uint32_t imported_count;
+    uint8_t record[FIDO2_CREDENTIAL_RECORD_SIZE];
+};
+
+static void backup_hmac(
+    const FidoHmacKey* key,
+    const uint8_t* a,
+    size_t a_len,
+    const uint8_t* b,
+    size_t b_len,
+    const uint8_t* c,
+    size_t c_len,
+    uint8_t* out) {
+    FidoHmac hmac;
+    fido_hmac_start(&hmac, key);
+    fido_hmac_update(&hmac, a, a_len);
+    fido_hmac_update(&hmac, b, b_len);
+    fido_hmac_update(&hmac, c, c_len);
+    fido_hmac_finish(&hmac, out);
+}
+
+static void backup_store_be32(uint8_t* out, uint32_t value) {
+    out[0] = (value >> 24) & 0xFF;
+    out[1] = (value >> 16) & 0xFF;
+    out[2] = (value >> 8) & 0xFF;
+    out[3] = value & 0xFF;
+}
+
+/**
+ * @brief Derive per-session encryption and MAC keys from the transport key
+ */
+static void backup_derive_keys(Fido2Backup* backup, const uint8_t* transport_key) {
+    static const uint8_t enc_label[] = "fido2-backup-enc";
+    static const uint8_t mac_label[] = "fido2-backup-mac";
+
+    FidoHmacKey transport;
+    uint8_t mac_secret[32];
+
+    fido_hmac_key_init(&transport, transport_key, 32);
+    backup_hmac(
+        &transport,
+        enc_label,
+        sizeof(enc_label) - 1,
+        backup->nonce,
+        sizeof(backup->nonce),
+        NULL,
+        0,
+        backup->enc_key);
+    backup_hmac(
+        &transport,
+        mac_label,
+        sizeof(mac_label) - 1,
+        backup->nonce,
+        sizeof(backup->nonce),
+        NULL,
+        0,
+        mac_secret);
+    fido_hmac_key_init(&backup->mac_key, mac_secret, sizeof(mac_secret));
+
+    fido_hmac_key_wipe(&transport);
+    memset(mac_secret, 0, sizeof(mac_secret));
+}
+
+/**
+ * @brief Per-chunk MAC over nonce || seq || ciphertext
+ */
+static void backup_chunk_mac(Fido2Backup* backup, uint32_t seq, const uint8_t* ct, uint8_t* mac) {
+    uint8_t seq_be[4];
+    backup_store_be32(seq_be, seq);
+    backup_hmac(
+        &backup->mac_key,
+        backup->nonce,
+        sizeof(backup->nonce),
+        seq_be,
+        sizeof(seq_be),
+        ct,
+        FIDO2_CREDENTIAL_RECORD_SIZE,
+        mac);
+}
+
+/**
+ * @brief Final MAC over nonce || "end" || record count
+ */
+static void backup_final_tag(Fido2Backup* backup, uint32_t count, uint8_t* tag) {
+    static const uint8_t end_label[] = "end";
+    uint8_t count_be[4];
+    backup_store_be32(count_be, count);
+    backup_hmac(
+        &backup->mac_key,
+        backup->nonce,
+        sizeof(backup->nonce),
+        end_label,
+        sizeof(end_label) - 1,
+        count_be,
+        sizeof(count_be),
+        tag);
+}
+
+/**
+ * @brief AES-256-CTR with IV = nonce[0..7] || seq || block counter
+ */
+static bool backup_crypt(Fido2Backup* backup, uint32_t seq, const uint8_t* in, uint8_t* out) {
+    uint8_t iv[16] = {0};
+    memcpy(iv, backup->nonce, 8);
+    backup_store_be32(iv + 8, seq);
+    return furi_hal_crypto_ctr(backup->enc_key, iv, in, out, FIDO2_CREDENTIAL_RECORD_SIZE);
+}
+
+static bool backup_tag_equal(const uint8_t* a, const uint8_t* b) {
+    uint8_t diff = 0;
+    for(size_t i = 0; i < FIDO2_BACKUP_MAC_SIZE; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static void backup_wipe_session(Fido2Backup* backup) {
+    Fido2CredentialStore* store = backup->store;
+    memset(backup, 0, sizeof(Fido2Backup));
+    backup->store = store;
+}
+
+Fido2Backup* fido2_backup_alloc(Fido2CredentialStore* store) {
+    Fido2Backup* backup = malloc(sizeof(Fido2Backup));
+    memset(backup, 0, sizeof(Fido2Backup));
+    backup->store = store;
+    return backup;
+}
+
+void fido2_backup_free(Fido2Backup* backup) {
+    if(!backup) return;
+    fido2_backup_abort(backup);
+    free(backup);
+}
+
+uint32_t fido2_backup_export_begin(Fido2Backup* backup, const uint8_t* transport_key, uint8_t* nonce) {
+    fido2_backup_abort(backup);
+
+    fido_drbg_fill(backup->nonce, sizeof(backup->nonce));
+    backup_derive_keys(backup, transport_key);
+    backup->state = Fido2BackupStateExport;
+    memcpy(nonce, backup->nonce, sizeof(backup->nonce));
+
+    uint32_t count = fido2_credential_count(backup->store);
+    FURI_LOG_I(TAG, "Export started, %lu records", count);
+    return count;
+}
+
+Fido2BackupExportResult
+    fido2_backup_export_next(Fido2Backup* backup, uint32_t* seq, uint8_t* chunk) {
+    if(backup->state != Fido2BackupStateExport) return Fido2BackupExportInvalid;
+
+    // Skip empty slots; slots are visited in page order, so each page is read once
+    Fido2Credential* cred = NULL;
+    while(backup->slot < FIDO2_MAX_CREDENTIALS && !cred) {
+        cred = fido2_credential_get_slot(backup->store, backup->slot++);
+    }
+
+    if(!cred) {
+        backup_final_tag(backup, backup->seq, chunk);
+        FURI_LOG_I(TAG, "Export finished, %lu records", backup->seq);
+        backup_wipe_session(backup);
+        return Fido2BackupExportDone;
+    }
+
+    *seq = backup->seq;
+    fido2_credential_serialize(cred, backup->record);
+    furi_check(backup_crypt(backup, backup->seq, backup->record, chunk));
+    backup_chunk_mac(backup, backup->seq, chunk, chunk + FIDO2_CREDENTIAL_RECORD_SIZE);
+    memset(backup->record, 0, sizeof(backup->record));
+
+    backup->seq++;
+    return Fido2BackupExportChunk;
+}
+
+void fido2_backup_import_begin(Fido2Backup* backup, const uint8_t* transport_key, const uint8_t* nonce) {
+    fido2_backup_abort(backup);
+
+    memcpy(backup->nonce, nonce, sizeof(backup->nonce));
+    backup_derive_keys(backup, transport_key);
+    backup->state = Fido2BackupStateImport;
+    FURI_LOG_I(TAG, "Import started");
+}
+
+Fido2BackupImportResult fido2_backup_import_record(
+    Fido2Backup* backup,
+    uint32_t seq,
+    const uint8_t* chunk,
+    size_t chunk_len) {
+    if(backup->state != Fido2BackupStateImport || chunk_len != FIDO2_BACKUP_CHUNK_SIZE ||
+       seq != backup->seq) {
+        return Fido2BackupImportInvalid;
+    }
+
+    // Encrypt-then-MAC: authenticate before decrypting anything
+    uint8_t mac[FIDO2_BACKUP_MAC_SIZE];
+    backup_chunk_mac(backup, seq, chunk, mac);
+    if(!backup_tag_equal(mac, chunk + FIDO2_CREDENTIAL_RECORD_SIZE)) {
+        FURI_LOG_W(TAG, "Chunk %lu: MAC mismatch", seq);
+        return Fido2BackupImportInvalid;
+    }
+
+    Fido2Credential cred;
+    bool ok = backup_crypt(backup, seq, chunk, backup->record) &&
+              fido2_credential_deserialize(backup->record, &cred);
+    memset(backup->record, 0, sizeof(backup->record));
+    if(!ok) return Fido2BackupImportInvalid;
+
+    backup->seq++;
+
+    Fido2BackupImportResult result;
+    if(fido2_credential_find_by_id(
+           backup->store, cred.credential_id, sizeof(cred.credential_id))) {
+        result = Fido2BackupImportDuplicate;
+    } else {
+        Fido2Credential* stored = fido2_credential_import(backup->store, &cred);
+        if(stored) {
+            size_t slot = fido2_credential_get_slot_index(backup->store, stored);
+            backup->imported[slot / 8] |= 1 << (slot % 8);
+            backup->imported_count++;
+            result = Fido2BackupImportOk;
+        } else {
+            result = Fido2BackupImportFull;
+        }
+    }
+
+    memset(&cred, 0, sizeof(cred));
+    return result;
+}
+
+bool fido2_backup_import_finish(Fido2Backup* backup, const uint8_t* tag, uint32_t* imported) {
+    if(backup->state != Fido2BackupStateImport) return false;
+
+    uint8_t expected[FIDO2_BACKUP_MAC_SIZE];
+    backup_final_tag(backup, backup->seq, expected);
+    if(!backup_tag_equal(expected, tag)) {
+        FURI_LOG_W(TAG, "Final tag mismatch, rolling back");
+        fido2_backup_abort(backup);
+        return false;
+    }
+
+    *imported = backup->imported_count;
+    FURI_LOG_I(TAG, "Import finished, %lu/%lu records added", backup->imported_count, backup->seq);
+    backup->state = Fido2BackupStateImportVerified;
+    return true;
+}
+
+void fido2_backup_import_commit(Fido2Backup* backup) {
+    if(backup->state != Fido2BackupStateImportVerified) return;
+    backup_wipe_session(backup);
+}
+
+void fido2_backup_abort(Fido2Backup* backup) {
+    if(!backup) return;
+
+    if(backup->state == Fido2BackupStateImport ||
+       backup->state == Fido2BackupStateImportVerified) {
+        for(size_t slot = 0; slot < FIDO2_MAX_CREDENTIALS; slot++) {
+            if(!(backup->imported[slot / 8] & (1 << (slot % 8)))) continue;
+            fido2_credential_delete(
+                backup->store, fido2_credential_get_slot(backup->store, slot));
+        }
+    }
+
+    backup_wipe_session(backup);
+}
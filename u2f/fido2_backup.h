@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "fido2_credential.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIDO2_BACKUP_KEY_SIZE   32
+#define FIDO2_BACKUP_NONCE_SIZE 16
+#define FIDO2_BACKUP_MAC_SIZE   32
+#define FIDO2_BACKUP_CHUNK_SIZE (FIDO2_CREDENTIAL_RECORD_SIZE + FIDO2_BACKUP_MAC_SIZE)
+
+/**
+ * @brief Streaming encrypted backup/restore session
+ *
+ * The credential store is exported one record per chunk, never as a
+ * whole. Each chunk is the AES-256-CTR encrypted record followed by an
+ * HMAC-SHA256 over (nonce || seq || ciphertext), keyed from the
+ * host-supplied transport key and a per-session device nonce. A final
+ * tag over the record count detects truncation.
+ */
+typedef struct Fido2Backup Fido2Backup;
+
+typedef enum {
+    Fido2BackupImportOk,
+    Fido2BackupImportDuplicate, // Credential already present, skipped
+    Fido2BackupImportInvalid, // Bad sequence, MAC or record
+    Fido2BackupImportFull,
+} Fido2BackupImportResult;
+
+typedef enum {
+    Fido2BackupExportChunk, // Next record written to the chunk
+    Fido2BackupExportDone, // Final tag written, session ended
+    Fido2BackupExportInvalid, // No export session
+} Fido2BackupExportResult;
+
+Fido2Backup* fido2_backup_alloc(Fido2CredentialStore* store);
+
+void fido2_backup_free(Fido2Backup* backup);
+
+/**
+ * @brief Start an export session
+ *
+ * @param transport_key Host-supplied FIDO2_BACKUP_KEY_SIZE key
+ * @param nonce Output session nonce to hand to the restoring device
+ * @return number of records that will be exported
+ */
+uint32_t fido2_backup_export_begin(Fido2Backup* backup, const uint8_t* transport_key, uint8_t* nonce);
+
+/**
+ * @brief Produce the next chunk of an export session
+ *
+ * @param seq Output sequence number of the chunk
+ * @param chunk Output FIDO2_BACKUP_CHUNK_SIZE bytes
+ * @return Fido2BackupExportDone when the store is exhausted; the final tag
+ *         is then written to chunk (FIDO2_BACKUP_MAC_SIZE bytes) and the
+ *         session ends
+ */
+Fido2BackupExportResult
+    fido2_backup_export_next(Fido2Backup* backup, uint32_t* seq, uint8_t* chunk);
+
+/**
+ * @brief Start an import session for a blob produced by another device
+ */
+void fido2_backup_import_begin(Fido2Backup* backup, const uint8_t* transport_key, const uint8_t* nonce);
+
+/**
+ * @brief Verify, decrypt and append one chunk
+ */
+Fido2BackupImportResult fido2_backup_import_record(
+    Fido2Backup* backup,
+    uint32_t seq,
+    const uint8_t* chunk,
+    size_t chunk_len);
+
+/**
+ * @brief Verify the final tag of the import
+ *
+ * On failure every credential appended in this session is removed. On
+ * success they stay revocable by fido2_backup_abort until
+ * fido2_backup_import_commit, so a failed save can still undo them.
+ *
+ * @param imported Output number of credentials added to the store
+ */
+bool fido2_backup_import_finish(Fido2Backup* backup, const uint8_t* tag, uint32_t* imported);
+
+/**
+ * @brief End a verified import once its credentials are persisted
+ */
+void fido2_backup_import_commit(Fido2Backup* backup);
+
+/**
+ * @brief Abort any session, rolling back an unfinished import
+ */
+void fido2_backup_abort(Fido2Backup* backup);
+
+#ifdef __cplusplus
+}
+#endif
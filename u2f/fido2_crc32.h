@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief CRC-32 (IEEE 802.3) of a buffer, for checksummed storage records
+ */
+uint32_t fido2_crc32(const uint8_t* data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
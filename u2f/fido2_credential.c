@@ -1,40 +1,109 @@
-#include "fido2_credential.h"
+#include "fido2_credential_i.h"
 #include "fido2_app.h"
+#include "fido2_ed25519.h"
+#include "fido_drbg.h"
 #include <furi.h>
-#include <furi_hal_random.h>
-#include <mbedtls/ecdsa.h>
 #include <mbedtls/sha256.h>
-#include <mbedtls/ecp.h>
 #include <string.h>
 
 #define TAG "FIDO2_CRED"
 
 /**
- * @brief Complete definition of credential store
- * This is only in the .c file, not in the header
+ * @brief Generate a P-256 key pair into the credential
  */
-struct Fido2CredentialStore {
-    Fido2Credential credentials[FIDO2_MAX_CREDENTIALS];
-};
+static bool generate_p256_key(Fido2CredentialStore* store, Fido2Credential* cred) {
+    uint8_t public_key[FIDO_P256_PUBLIC_KEY_SIZE];
+    if(!fido_keypair_pool_keygen(store->keypair_pool, cred->private_key, public_key)) {
+        FURI_LOG_E(TAG, "Failed to generate key pair");
+        return false;
+    }
+
+    memcpy(cred->public_key_x, public_key, 32);
+    memcpy(cred->public_key_y, public_key + 32, 32);
+    return true;
+}
 
 /**
- * @brief Random number generator callback for mbedTLS
+ * @brief Generate an Ed25519 key pair into the credential
  */
-static int rng_callback(void* ctx, unsigned char* buf, size_t len) {
-    UNUSED(ctx);
-    furi_hal_random_fill_buf(buf, len);
-    return 0;
+static bool generate_ed25519_key(Fido2Credential* cred) {
+    fido_drbg_fill(cred->private_key, FIDO2_ED25519_SEED_SIZE);
+    fido2_ed25519_public_key(cred->private_key, cred->public_key_x);
+    return true;
+}
+
+/**
+ * @brief Drop cached signing keys of a credential, or of all credentials if NULL
+ *
+ * Matches the slot pointer and the credential id: a paged-out credential
+ * comes back at another address, and its old address may hold another one.
+ */
+static void signing_key_forget(Fido2CredentialStore* store, const Fido2Credential* cred) {
+    for(size_t i = 0; i < FIDO2_SIGNING_KEY_CACHE_SIZE; i++) {
+        Fido2SigningKeyCacheEntry* entry = &store->key_cache[i];
+        if(!entry->cred) continue;
+        if(!cred || entry->cred == cred ||
+           memcmp(entry->credential_id, cred->credential_id, sizeof(entry->credential_id)) == 0) {
+            fido_p256_key_wipe(&entry->key);
+            memset(entry, 0, sizeof(Fido2SigningKeyCacheEntry));
+        }
+    }
+}
+
+/**
+ * @brief Get the parsed signing key of an ES256 credential, loading it on a miss
+ *
+ * Repeated assertions for one RP then sign on warm state.
+ */
+static const FidoP256Key*
+    signing_key_get(Fido2CredentialStore* store, const Fido2Credential* cred) {
+    uint32_t now = furi_get_tick();
+    Fido2SigningKeyCacheEntry* slot = &store->key_cache[0];
+
+    for(size_t i = 0; i < FIDO2_SIGNING_KEY_CACHE_SIZE; i++) {
+        Fido2SigningKeyCacheEntry* entry = &store->key_cache[i];
+        if(entry->cred &&
+           memcmp(entry->credential_id, cred->credential_id, sizeof(entry->credential_id)) == 0) {
+            // Same credential, possibly paged back in at another address
+            entry->cred = cred;
+            entry->used = now;
+            return &entry->key;
+        }
+        // Prefer a free entry, otherwise evict the least recently used one
+        if(!entry->cred) {
+            slot = entry;
+        } else if(slot->cred && now - entry->used > now - slot->used) {
+            slot = entry;
+        }
+    }
+
+    fido_p256_key_wipe(&slot->key);
+    memset(slot, 0, sizeof(Fido2SigningKeyCacheEntry));
+    if(!fido_p256_key_load(store->p256, cred->private_key, &slot->key)) return NULL;
+    slot->cred = cred;
+    memcpy(slot->credential_id, cred->credential_id, sizeof(slot->credential_id));
+    slot->used = now;
+    return &slot->key;
 }
 
 Fido2CredentialStore* fido2_credential_store_alloc() {
     Fido2CredentialStore* store = malloc(sizeof(struct Fido2CredentialStore));
     memset(store, 0, sizeof(struct Fido2CredentialStore));
+    store->p256 = fido_p256_alloc();
+    store->nonce_pool = fido_nonce_pool_alloc(store->p256);
+    store->keypair_pool = fido_keypair_pool_alloc(store->p256);
+    store->pages = fido2_page_store_alloc();
     FURI_LOG_I(TAG, "Credential store initialized");
     return store;
 }
 
 void fido2_credential_store_free(Fido2CredentialStore* store) {
     if(!store) return;
+    signing_key_forget(store, NULL);
+    fido2_page_store_free(store->pages);
+    fido_keypair_pool_free(store->keypair_pool);
+    fido_nonce_pool_free(store->nonce_pool);
+    fido_p256_free(store->p256);
     // Zero out sensitive data
     memset(store, 0, sizeof(struct Fido2CredentialStore));
     free(store);
@@ -46,72 +115,39 @@ Fido2Credential* fido2_credential_create(
     const uint8_t* user_id,
     size_t user_id_len,
     const char* user_name,
-    const char* user_display_name) {
-    
+    const char* user_display_name,
+    int32_t algorithm) {
+
     if(!store || !rp_id || !user_id) return NULL;
 
-    // Find empty slot
-    Fido2Credential* cred = NULL;
-    for(size_t i = 0; i < FIDO2_MAX_CREDENTIALS; i++) {
-        if(!store->credentials[i].valid) {
-            cred = &store->credentials[i];
-            break;
-        }
+    if(algorithm != COSE_ALG_ECDSA_WITH_SHA256 && algorithm != COSE_ALG_EDDSA) {
+        FURI_LOG_E(TAG, "Unsupported algorithm: %ld", algorithm);
+        return NULL;
     }
 
+    // Find empty slot
+    Fido2Credential* cred = fido2_page_store_add(store->pages);
     if(!cred) {
         FURI_LOG_W(TAG, "No free credential slots");
         return NULL;
     }
 
     // Clear credential
+    signing_key_forget(store, cred);
     memset(cred, 0, sizeof(Fido2Credential));
 
     // Generate credential ID (random)
-    furi_hal_random_fill_buf(cred->credential_id, sizeof(cred->credential_id));
-
-    // Generate ECDSA key pair (P-256)
-    mbedtls_ecdsa_context ctx;
-    mbedtls_ecdsa_init(&ctx);
-
-    int ret = mbedtls_ecdsa_genkey(&ctx, MBEDTLS_ECP_DP_SECP256R1, rng_callback, store);
-    if(ret != 0) {
-        FURI_LOG_E(TAG, "Failed to generate key pair: %d", ret);
-        mbedtls_ecdsa_free(&ctx);
+    fido_drbg_fill(cred->credential_id, sizeof(cred->credential_id));
+
+    // Generate key pair for the negotiated algorithm
+    uint32_t keygen_start = furi_get_tick();
+    bool generated = (algorithm == COSE_ALG_EDDSA) ? generate_ed25519_key(cred) :
+                                                     generate_p256_key(store, cred);
+    if(!generated) {
+        memset(cred, 0, sizeof(Fido2Credential));
         return NULL;
     }
 
-    // Extract private key
-    ret = mbedtls_mpi_write_binary(&ctx.MBEDTLS_PRIVATE(d), cred->private_key, 32);
-    if(ret != 0) {
-        FURI_LOG_E(TAG, "Failed to extract private key: %d", ret);
-        mbedtls_ecdsa_free(&ctx);
-        return NULL;
-    }
-
-    // Extract public key coordinates
-    ret = mbedtls_mpi_write_binary(
-        &ctx.MBEDTLS_PRIVATE(Q).MBEDTLS_PRIVATE(X),
-        cred->public_key_x,
-        32);
-    if(ret != 0) {
-        FURI_LOG_E(TAG, "Failed to extract public key X: %d", ret);
-        mbedtls_ecdsa_free(&ctx);
-        return NULL;
-    }
-
-    ret = mbedtls_mpi_write_binary(
-        &ctx.MBEDTLS_PRIVATE(Q).MBEDTLS_PRIVATE(Y),
-        cred->public_key_y,
-        32);
-    if(ret != 0) {
-        FURI_LOG_E(TAG, "Failed to extract public key Y: %d", ret);
-        mbedtls_ecdsa_free(&ctx);
-        return NULL;
-    }
-
-    mbedtls_ecdsa_free(&ctx);
-
     // Copy metadata
     strncpy(cred->rp_id, rp_id, sizeof(cred->rp_id) - 1);
     cred->rp_id[sizeof(cred->rp_id) - 1] = '\0';
@@ -130,22 +166,18 @@ Fido2Credential* fido2_credential_create(
     }
 
     cred->sign_count = 0;
+    cred->algorithm = algorithm;
     cred->valid = true;
+    fido2_page_store_update(store->pages, cred);
 
-    FURI_LOG_I(TAG, "Created credential for RP: %s", rp_id);
+    FURI_LOG_I(
+        TAG, "Created credential for RP: %s (keygen %lu ms)", rp_id, furi_get_tick() - keygen_start);
     return cred;
 }
 
 Fido2Credential* fido2_credential_find_by_rp(Fido2CredentialStore* store, const char* rp_id) {
     if(!store || !rp_id) return NULL;
-
-    for(size_t i = 0; i < FIDO2_MAX_CREDENTIALS; i++) {
-        if(store->credentials[i].valid && strcmp(store->credentials[i].rp_id, rp_id) == 0) {
-            return &store->credentials[i];
-        }
-    }
-
-    return NULL;
+    return fido2_page_store_find_by_rp(store->pages, rp_id);
 }
 
 Fido2Credential* fido2_credential_find_by_id(
@@ -154,140 +186,232 @@ Fido2Credential* fido2_credential_find_by_id(
     size_t credential_id_len) {
     
     if(!store || !credential_id || credential_id_len != 32) return NULL;
-
-    for(size_t i = 0; i < FIDO2_MAX_CREDENTIALS; i++) {
-        if(store->credentials[i].valid &&
-           memcmp(store->credentials[i].credential_id, credential_id, 32) == 0) {
-            return &store->credentials[i];
-        }
-    }
-
-    return NULL;
+    return fido2_page_store_find_by_id(store->pages, credential_id);
 }
 
 bool fido2_credential_sign(
+    Fido2CredentialStore* store,
     Fido2Credential* cred,
-    const uint8_t* data,
-    size_t data_len,
+    const uint8_t* auth_data,
+    size_t auth_data_len,
+    const uint8_t* client_data_hash,
     uint8_t* signature,
     size_t* signature_len) {
     
-    if(!cred || !data || !signature || !signature_len) return false;
-
-    // Hash the data with SHA-256
-    uint8_t hash[32];
-    mbedtls_sha256(data, data_len, hash, 0);
-
-    // Initialize ECDSA context and load private key
-    mbedtls_ecdsa_context ctx;
-    mbedtls_ecdsa_init(&ctx);
-
-    int ret = mbedtls_ecp_group_load(&ctx.MBEDTLS_PRIVATE(grp), MBEDTLS_ECP_DP_SECP256R1);
-    if(ret != 0) {
-        FURI_LOG_E(TAG, "Failed to load curve: %d", ret);
-        mbedtls_ecdsa_free(&ctx);
+    if(!store || !cred || !auth_data || !client_data_hash || !signature || !signature_len) {
         return false;
     }
 
-    ret = mbedtls_mpi_read_binary(&ctx.MBEDTLS_PRIVATE(d), cred->private_key, 32);
-    if(ret != 0) {
-        FURI_LOG_E(TAG, "Failed to load private key: %d", ret);
-        mbedtls_ecdsa_free(&ctx);
-        return false;
+    // EdDSA signs the message itself and produces a raw 64-byte R || S
+    if(cred->algorithm == COSE_ALG_EDDSA) {
+        fido2_ed25519_sign(
+            cred->private_key,
+            cred->public_key_x,
+            auth_data,
+            auth_data_len,
+            client_data_hash,
+            32,
+            signature);
+        *signature_len = FIDO2_ED25519_SIGNATURE_SIZE;
+        return true;
     }
 
-    // Sign the hash
-    mbedtls_mpi r, s;
-    mbedtls_mpi_init(&r);
-    mbedtls_mpi_init(&s);
-
-    ret = mbedtls_ecdsa_sign(
-        &ctx.MBEDTLS_PRIVATE(grp),
-        &r,
-        &s,
-        &ctx.MBEDTLS_PRIVATE(d),
-        hash,
-        32,
-        rng_callback,
-        NULL);
-
-    if(ret != 0) {
-        FURI_LOG_E(TAG, "Failed to sign: %d", ret);
-        mbedtls_mpi_free(&r);
-        mbedtls_mpi_free(&s);
-        mbedtls_ecdsa_free(&ctx);
+    // Hash authData || clientDataHash with SHA-256, streamed from the caller's buffers
+    uint8_t hash[32];
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    mbedtls_sha256_update(&sha, auth_data, auth_data_len);
+    mbedtls_sha256_update(&sha, client_data_hash, 32);
+    mbedtls_sha256_finish(&sha, hash);
+    mbedtls_sha256_free(&sha);
+
+    uint8_t raw_signature[FIDO_P256_SIGNATURE_SIZE];
+    const FidoP256Key* key = signing_key_get(store, cred);
+    bool signed_ok = key && fido_nonce_pool_sign_key(store->nonce_pool, key, hash, raw_signature);
+    memset(hash, 0, sizeof(hash));
+    if(!signed_ok) {
+        FURI_LOG_E(TAG, "Failed to sign");
         return false;
     }
+    *signature_len = fido_p256_der_encode(raw_signature, signature);
+    memset(raw_signature, 0, sizeof(raw_signature));
 
-    // Encode signature in DER format
-    size_t offset = 0;
-    
-    // Get signature size
-    size_t r_len = mbedtls_mpi_size(&r);
-    size_t s_len = mbedtls_mpi_size(&s);
-    
-    // Build DER signature: 30 <len> 02 <r_len> <r> 02 <s_len> <s>
-    signature[offset++] = 0x30; // SEQUENCE
-    signature[offset++] = 2 + r_len + 2 + s_len; // Total length
-    signature[offset++] = 0x02; // INTEGER
-    signature[offset++] = r_len;
-    
-    // Write r
-    ret = mbedtls_mpi_write_binary(&r, signature + offset, r_len);
-    if(ret != 0) {
-        FURI_LOG_E(TAG, "Failed to write r");
-        mbedtls_mpi_free(&r);
-        mbedtls_mpi_free(&s);
-        mbedtls_ecdsa_free(&ctx);
-        return false;
+    FURI_LOG_D(TAG, "Signed data, signature length: %d", *signature_len);
+    return true;
+}
+
+bool fido2_credential_precompute(Fido2CredentialStore* store) {
+    if(!store) return false;
+    // Nonces first: assertions are far more frequent than registrations
+    return fido_nonce_pool_refill(store->nonce_pool) ||
+           fido_keypair_pool_refill(store->keypair_pool);
+}
+
+void fido2_credential_set_yield_callback(
+    Fido2CredentialStore* store,
+    FidoP256YieldCallback callback,
+    void* context) {
+    if(!store) return;
+    fido_p256_set_yield_callback(store->p256, callback, context);
+}
+
+bool fido2_credential_counter_needs_lease(const Fido2Credential* cred) {
+    furi_check(cred);
+    return cred->sign_count >= cred->sign_count_ceiling;
+}
+
+uint32_t fido2_credential_persisted_sign_count(const Fido2Credential* cred) {
+    furi_check(cred);
+    return cred->sign_count_ceiling > cred->sign_count ? cred->sign_count_ceiling :
+                                                         cred->sign_count;
+}
+
+void fido2_credential_release_counter_leases(Fido2CredentialStore* store) {
+    if(!store) return;
+
+    for(size_t i = 0; i < FIDO2_PAGE_CACHE_SIZE * FIDO2_PAGE_RECORDS; i++) {
+        Fido2Credential* cred = fido2_page_store_get_cached(store->pages, i);
+        if(cred && cred->sign_count_ceiling != cred->sign_count) {
+            cred->sign_count_ceiling = cred->sign_count;
+            fido2_page_store_update(store->pages, cred);
+        }
     }
-    offset += r_len;
-    
-    signature[offset++] = 0x02; // INTEGER
-    signature[offset++] = s_len;
-    
-    // Write s
-    ret = mbedtls_mpi_write_binary(&s, signature + offset, s_len);
-    if(ret != 0) {
-        FURI_LOG_E(TAG, "Failed to write s");
-        mbedtls_mpi_free(&r);
-        mbedtls_mpi_free(&s);
-        mbedtls_ecdsa_free(&ctx);
-        return false;
+}
+
+Fido2Credential* fido2_credential_get_slot(Fido2CredentialStore* store, size_t index) {
+    if(!store || index >= FIDO2_MAX_CREDENTIALS) return NULL;
+    return fido2_page_store_get(store->pages, index);
+}
+
+size_t fido2_credential_get_slot_index(Fido2CredentialStore* store, const Fido2Credential* cred) {
+    furi_check(store && cred);
+    return fido2_page_store_slot(store->pages, cred);
+}
+
+Fido2Credential* fido2_credential_import(Fido2CredentialStore* store, const Fido2Credential* cred) {
+    if(!store || !cred) return NULL;
+
+    Fido2Credential* slot = fido2_page_store_add(store->pages);
+    if(!slot) {
+        FURI_LOG_W(TAG, "No free credential slots");
+        return NULL;
     }
-    offset += s_len;
 
-    *signature_len = offset;
+    // The record may replace one with the same id but another key
+    signing_key_forget(store, slot);
+    signing_key_forget(store, cred);
+    *slot = *cred;
+    slot->valid = true;
+    fido2_page_store_update(store->pages, slot);
+    return slot;
+}
 
-    mbedtls_mpi_free(&r);
-    mbedtls_mpi_free(&s);
-    mbedtls_ecdsa_free(&ctx);
+static uint8_t* record_put(uint8_t* out, const void* data, size_t len) {
+    memcpy(out, data, len);
+    return out + len;
+}
 
-    // Increment signature counter
-    cred->sign_count++;
+static uint8_t* record_put_u32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+    return out + 4;
+}
 
-    FURI_LOG_D(TAG, "Signed data, signature length: %d", *signature_len);
+static const uint8_t* record_get(const uint8_t* in, void* data, size_t len) {
+    memcpy(data, in, len);
+    return in + len;
+}
+
+static const uint8_t* record_get_u32(const uint8_t* in, uint32_t* value) {
+    *value = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+             ((uint32_t)in[3] << 24);
+    return in + 4;
+}
+
+void fido2_credential_serialize(const Fido2Credential* cred, uint8_t* record) {
+    furi_check(cred && record);
+
+    uint8_t* out = record;
+    *out++ = FIDO2_CREDENTIAL_RECORD_VERSION;
+    out = record_put(out, cred->credential_id, sizeof(cred->credential_id));
+    out = record_put(out, cred->private_key, sizeof(cred->private_key));
+    out = record_put(out, cred->public_key_x, sizeof(cred->public_key_x));
+    out = record_put(out, cred->public_key_y, sizeof(cred->public_key_y));
+    out = record_put(out, cred->rp_id, sizeof(cred->rp_id));
+    out = record_put(out, cred->user_id, sizeof(cred->user_id));
+    *out++ = (uint8_t)cred->user_id_len;
+    out = record_put(out, cred->user_name, sizeof(cred->user_name));
+    out = record_put(out, cred->user_display_name, sizeof(cred->user_display_name));
+    out = record_put_u32(out, fido2_credential_persisted_sign_count(cred));
+    out = record_put_u32(out, (uint32_t)cred->algorithm);
+
+    furi_check(out - record == FIDO2_CREDENTIAL_RECORD_SIZE);
+}
+
+bool fido2_credential_deserialize(const uint8_t* record, Fido2Credential* cred) {
+    if(!record || !cred) return false;
+    if(record[0] != FIDO2_CREDENTIAL_RECORD_VERSION) return false;
+
+    memset(cred, 0, sizeof(Fido2Credential));
+
+    const uint8_t* in = record + 1;
+    uint32_t algorithm;
+    in = record_get(in, cred->credential_id, sizeof(cred->credential_id));
+    in = record_get(in, cred->private_key, sizeof(cred->private_key));
+    in = record_get(in, cred->public_key_x, sizeof(cred->public_key_x));
+    in = record_get(in, cred->public_key_y, sizeof(cred->public_key_y));
+    in = record_get(in, cred->rp_id, sizeof(cred->rp_id));
+    in = record_get(in, cred->user_id, sizeof(cred->user_id));
+    cred->user_id_len = *in++;
+    in = record_get(in, cred->user_name, sizeof(cred->user_name));
+    in = record_get(in, cred->user_display_name, sizeof(cred->user_display_name));
+    in = record_get_u32(in, &cred->sign_count);
+    record_get_u32(in, &algorithm);
+    cred->algorithm = (int32_t)algorithm;
+
+    // Strings must be terminated and the rest must be in range
+    bool valid = cred->rp_id[sizeof(cred->rp_id) - 1] == '\0' && cred->rp_id[0] != '\0' &&
+                 cred->user_name[sizeof(cred->user_name) - 1] == '\0' &&
+                 cred->user_display_name[sizeof(cred->user_display_name) - 1] == '\0' &&
+                 cred->user_id_len <= sizeof(cred->user_id) &&
+                 (cred->algorithm == COSE_ALG_ECDSA_WITH_SHA256 ||
+                  cred->algorithm == COSE_ALG_EDDSA);
+    if(!valid) {
+        memset(cred, 0, sizeof(Fido2Credential));
+        return false;
+    }
+
+    cred->valid = true;
     return true;
 }
 
+void fido2_credential_update(Fido2CredentialStore* store, const Fido2Credential* cred) {
+    furi_check(store && cred);
+    fido2_page_store_update(store->pages, cred);
+}
+
+void fido2_credential_delete(Fido2CredentialStore* store, Fido2Credential* cred) {
+    if(!store || !cred) return;
+
+    // Zero out sensitive data and free the slot
+    signing_key_forget(store, cred);
+    memset(cred, 0, sizeof(Fido2Credential));
+    fido2_page_store_update(store->pages, cred);
+}
+
 size_t fido2_credential_count(Fido2CredentialStore* store) {
     if(!store) return 0;
-
-    size_t count = 0;
-    for(size_t i = 0; i < FIDO2_MAX_CREDENTIALS; i++) {
-        if(store->credentials[i].valid) {
-            count++;
-        }
-    }
-    return count;
+    return fido2_page_store_count(store->pages);
 }
 
 void fido2_credential_reset(Fido2CredentialStore* store) {
     if(!store) return;
 
-    for(size_t i = 0; i < FIDO2_MAX_CREDENTIALS; i++) {
-        memset(&store->credentials[i], 0, sizeof(Fido2Credential));
-    }
+    signing_key_forget(store, NULL);
+    fido2_page_store_clear(store->pages);
 
     FURI_LOG_I(TAG, "All credentials reset");
 }
\ No newline at end of file
@@ -3,20 +3,47 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "fido_p256.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define FIDO2_MAX_CREDENTIALS 10
+// Credentials live in SD-backed pages, see fido2_page_store.h
+#define FIDO2_MAX_CREDENTIALS 1024
 #define FIDO2_CREDENTIAL_ID_SIZE 32
 #define FIDO2_RP_ID_MAX_SIZE 128
 #define FIDO2_USER_ID_MAX_SIZE 64
 #define FIDO2_USER_NAME_MAX_SIZE 64
 #define FIDO2_DISPLAY_NAME_MAX_SIZE 64
 
+/**
+ * @brief Signature counter values served from RAM per persisted lease
+ *
+ * Storage always holds a ceiling at or above every counter value ever
+ * released, so counters stay monotonic across crashes while the
+ * credential file is rewritten only once per lease.
+ */
+#define FIDO2_SIGN_COUNT_LEASE 32
+
+/**
+ * @brief Fixed binary record layout (little endian)
+ *
+ *   version(1) credential_id(32) private_key(32) public_key_x(32)
+ *   public_key_y(32) rp_id(128) user_id(64) user_id_len(1) user_name(64)
+ *   user_display_name(64) sign_count(4) algorithm(4)
+ */
+#define FIDO2_CREDENTIAL_RECORD_VERSION 1
+#define FIDO2_CREDENTIAL_RECORD_SIZE    458
+
 /**
  * @brief FIDO2 credential structure
+ *
+ * For EdDSA credentials private_key holds the Ed25519 seed and
+ * public_key_x the encoded public key; public_key_y is unused.
+ *
+ * Credentials returned by the store point into its page cache and stay
+ * valid until the next store call that may read another page in.
  */
 typedef struct {
     uint8_t credential_id[32];
@@ -29,6 +56,8 @@ typedef struct {
     char user_name[64];
     char user_display_name[64];
     uint32_t sign_count;
+    uint32_t sign_count_ceiling; // persisted lease ceiling, RAM only
+    int32_t algorithm; // COSE algorithm: ES256 (P-256) or EdDSA (Ed25519)
     bool valid;
 } Fido2Credential;
 
@@ -46,8 +75,12 @@ Fido2Credential* fido2_credential_create(
     const uint8_t* user_id,
     size_t user_id_len,
     const char* user_name,
-    const char* user_display_name);
+    const char* user_display_name,
+    int32_t algorithm);
 
+/**
+ * @brief Look up a credential; pages whose Bloom filter rules it out are not read
+ */
 Fido2Credential* fido2_credential_find_by_rp(Fido2CredentialStore* store, const char* rp_id);
 
 Fido2Credential* fido2_credential_find_by_id(
@@ -55,14 +88,117 @@ Fido2Credential* fido2_credential_find_by_id(
     const uint8_t* credential_id,
     size_t credential_id_len);
 
+/**
+ * @brief Sign authData || clientDataHash with the credential key
+ *
+ * The two segments are hashed in place, so authData can be signed where
+ * it was serialized (e.g. inside the response buffer). The signature
+ * counter is left to the caller, which embeds it in authData.
+ *
+ * @param store Credential store (owns the P-256 provider)
+ * @param cred Credential to sign with
+ * @param auth_data Authenticator data
+ * @param auth_data_len Authenticator data length
+ * @param client_data_hash 32-byte client data hash
+ * @param signature Output signature (DER for ES256, raw 64 bytes for EdDSA),
+ *                  at least FIDO_P256_DER_SIGNATURE_MAX_SIZE bytes
+ * @param signature_len Output signature length
+ */
 bool fido2_credential_sign(
+    Fido2CredentialStore* store,
     Fido2Credential* cred,
-    const uint8_t* data,
-    size_t data_len,
+    const uint8_t* auth_data,
+    size_t auth_data_len,
+    const uint8_t* client_data_hash,
     uint8_t* signature,
     size_t* signature_len);
 
+/**
+ * @brief Do one step of idle-time precomputation (ECDSA nonces, then key pairs)
+ *
+ * @return true if work was done and there may be more
+ */
+bool fido2_credential_precompute(Fido2CredentialStore* store);
+
+/**
+ * @brief Yield between slices of P-256 scalar multiplications
+ *
+ * A false return aborts the operation in progress, so key generation or
+ * signing fails (or a precompute step is dropped).
+ */
+void fido2_credential_set_yield_callback(
+    Fido2CredentialStore* store,
+    FidoP256YieldCallback callback,
+    void* context);
+
+/**
+ * @brief Check whether the next counter value needs a new persisted lease
+ *
+ * When true, the caller raises sign_count_ceiling by FIDO2_SIGN_COUNT_LEASE
+ * and saves the store before releasing sign_count + 1.
+ */
+bool fido2_credential_counter_needs_lease(const Fido2Credential* cred);
+
+/**
+ * @brief Counter value to write to storage (the lease ceiling if one is held)
+ */
+uint32_t fido2_credential_persisted_sign_count(const Fido2Credential* cred);
+
+/**
+ * @brief Drop outstanding leases so the next save records exact counters
+ *
+ * Only safe right before a final save, e.g. on a clean shutdown. Leases of
+ * credentials whose page is no longer cached were already written out.
+ */
+void fido2_credential_release_counter_leases(Fido2CredentialStore* store);
+
+/**
+ * @brief Get the credential stored in a slot
+ *
+ * @param index Slot index, below FIDO2_MAX_CREDENTIALS
+ * @return credential or NULL if the slot is empty or out of range
+ */
+Fido2Credential* fido2_credential_get_slot(Fido2CredentialStore* store, size_t index);
+
+/**
+ * @brief Slot index of a credential, the inverse of fido2_credential_get_slot
+ */
+size_t fido2_credential_get_slot_index(Fido2CredentialStore* store, const Fido2Credential* cred);
+
+/**
+ * @brief Copy an existing credential (e.g. from a backup) into a free slot
+ *
+ * @return stored credential, NULL if the store is full
+ */
+Fido2Credential* fido2_credential_import(Fido2CredentialStore* store, const Fido2Credential* cred);
+
+/**
+ * @brief Serialize a credential into a fixed FIDO2_CREDENTIAL_RECORD_SIZE record
+ */
+void fido2_credential_serialize(const Fido2Credential* cred, uint8_t* record);
+
+/**
+ * @brief Parse a fixed-size record produced by fido2_credential_serialize
+ *
+ * @return false if the record version or any field is invalid
+ */
+bool fido2_credential_deserialize(const uint8_t* record, Fido2Credential* cred);
+
+/**
+ * @brief Mark a changed credential so its page is written back
+ */
+void fido2_credential_update(Fido2CredentialStore* store, const Fido2Credential* cred);
+
+/**
+ * @brief Delete a credential and wipe its key material
+ */
+void fido2_credential_delete(Fido2CredentialStore* store, Fido2Credential* cred);
+
 size_t fido2_credential_count(Fido2CredentialStore* store);
+
+/**
+ * @brief Delete all credentials, including the page file
+ */
 void fido2_credential_reset(Fido2CredentialStore* store);
 
 #ifdef __cplusplus
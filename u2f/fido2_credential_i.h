@@ -0,0 +1,39 @@
+#pragma once
+
+#include "fido2_credential.h"
+#include "fido2_page_store.h"
+#include "fido_p256.h"
+#include "fido_nonce_pool.h"
+#include "fido_keypair_pool.h"
+
+// ES256 credentials whose parsed signing key is kept between assertions
+#define FIDO2_SIGNING_KEY_CACHE_SIZE 2
+
+// Random nonce prefix of an encrypted journal, see fido2_data.c
+#define FIDO2_JOURNAL_SALT_SIZE 8
+
+/**
+ * @brief Parsed signing key of a recently used credential
+ */
+typedef struct {
+    const Fido2Credential* cred; // where it was last used, NULL if the entry is free
+    uint8_t credential_id[32]; // identifies the credential, its slot may be reused
+    FidoP256Key key;
+    uint32_t used; // tick of the last signature, for LRU eviction
+} Fido2SigningKeyCacheEntry;
+
+/**
+ * @brief Complete definition of credential store
+ *
+ * Private to the credential and storage modules; everyone else uses the
+ * opaque handle from fido2_credential.h.
+ */
+struct Fido2CredentialStore {
+    Fido2PageStore* pages;
+    FidoP256* p256;
+    FidoNoncePool* nonce_pool;
+    FidoKeypairPool* keypair_pool;
+    Fido2SigningKeyCacheEntry key_cache[FIDO2_SIGNING_KEY_CACHE_SIZE];
+    uint32_t journal_size; // bytes in the journal, 0 if there is none
+    uint8_t journal_salt[FIDO2_JOURNAL_SALT_SIZE];
+};
@@ -2,8 +2,13 @@
 #include "fido2_app.h"
 #include "fido2_cbor.h"
 #include "fido2_credential.h"
+#include "fido2_data.h"
+#include "fido2_backup.h"
+#include "fido2_arena.h"
+#include "fido_lab.h"
+#include "fido_templates.h"
+#include "fido_drbg.h"
 #include <furi.h>
-#include <furi_hal_random.h>
 #include <mbedtls/sha256.h>
 #include <string.h>
 
@@ -11,18 +16,185 @@
 #define AAGUID_SIZE 16
 #define MAX_CREDENTIAL_ID_SIZE 32
 
+// Worst-case encoded size of one provisioning result:
+// map(2), 1: credId (bstr 32), 2: ES256 COSE key (77)
+#define PROVISION_RESULT_MAX_SIZE (1 + 1 + 2 + MAX_CREDENTIAL_ID_SIZE + 1 + 77)
+
+// Per-transaction scratch memory for command handlers
+#define SCRATCH_ARENA_SIZE    512
+#define SCRATCH_STATS_ENTRIES 8
+
+// Largest provisioning batch whose credential ids fit the scratch arena
+// next to the rpId and userName buffers
+#define PROVISION_ARENA_IDS (SCRATCH_ARENA_SIZE - FIDO2_RP_ID_MAX_SIZE - FIDO2_USER_NAME_MAX_SIZE)
+#define PROVISION_MAX_BATCH (PROVISION_ARENA_IDS / FIDO2_CREDENTIAL_ID_SIZE)
+_Static_assert(PROVISION_MAX_BATCH <= 23, "Provisioning response needs a one-byte array header");
+
+/**
+ * @brief Scratch arena high-water mark for one command code
+ */
+typedef struct {
+    uint8_t cmd;
+    size_t peak;
+} Fido2ScratchStat;
+
+// Replay cache for byte-identical retransmissions
+#define REPLAY_CACHE_ENTRIES      3
+#define REPLAY_CACHE_MAX_RESPONSE 512
+#define REPLAY_CACHE_WINDOW_MS    5000
+
+/**
+ * @brief Cached response for a (channel, request) pair
+ */
+typedef struct {
+    uint32_t cid;
+    uint8_t request_hash[32];
+    uint32_t timestamp;
+    size_t response_len; // 0 = empty slot
+    uint8_t response[REPLAY_CACHE_MAX_RESPONSE];
+} Fido2ReplayEntry;
+
+/**
+ * @brief Supported COSE algorithms in authenticator preference order
+ *
+ * Also encoded in the getInfo template; keep tools/gen_fido_templates.py in sync.
+ */
+static const int32_t supported_algorithms[] = {
+    COSE_ALG_ECDSA_WITH_SHA256,
+    COSE_ALG_EDDSA,
+};
+
 struct Fido2Ctap {
     uint8_t aaguid[16];
     Fido2CredentialStore* credential_store;
     Fido2UserPresenceCallback up_callback;
     void* up_context;
+    FidoLab* lab; // optional test-lab auto-presence policy, not owned
+    uint32_t cid; // channel of the request being processed
+    Fido2ReplayEntry replay_cache[REPLAY_CACHE_ENTRIES];
+    size_t replay_next; // round-robin insertion slot
+    Fido2Backup* backup;
+    Fido2Arena* scratch;
+    Fido2ScratchStat scratch_stats[SCRATCH_STATS_ENTRIES];
+    size_t scratch_stats_count;
 };
 
+/**
+ * @brief Reserved size of an in-place CBOR byte string header
+ *
+ * authData and signatures are always 24..255 bytes long, so their header
+ * is the two-byte form and can be reserved before the payload is written.
+ */
+#define CBOR_BSTR8_HEADER_SIZE 2
+
+/**
+ * @brief Fill a reserved byte string header once the payload length is known
+ */
+static void cbor_patch_bstr8_header(uint8_t* header, size_t len) {
+    furi_check(len >= 24 && len <= 0xFF);
+    header[0] = 0x58; // major type 2, one-byte length follows
+    header[1] = (uint8_t)len;
+}
+
+/**
+ * @brief Look up a cached response for a retransmitted request
+ *
+ * @return cached response length, 0 on miss
+ */
+static size_t replay_cache_lookup(
+    Fido2Ctap* ctap,
+    const uint8_t* request_hash,
+    uint8_t* response,
+    size_t max_len) {
+    uint32_t now = furi_get_tick();
+    uint32_t window = furi_ms_to_ticks(REPLAY_CACHE_WINDOW_MS);
+
+    for(size_t i = 0; i < REPLAY_CACHE_ENTRIES; i++) {
+        Fido2ReplayEntry* entry = &ctap->replay_cache[i];
+        if(entry->response_len == 0) continue;
+
+        if(now - entry->timestamp > window) {
+            entry->response_len = 0;
+            continue;
+        }
+
+        if(entry->cid == ctap->cid && entry->response_len <= max_len &&
+           memcmp(entry->request_hash, request_hash, sizeof(entry->request_hash)) == 0) {
+            memcpy(response, entry->response, entry->response_len);
+            return entry->response_len;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Remember a successful response so a retry can be replayed
+ */
+static void replay_cache_store(
+    Fido2Ctap* ctap,
+    const uint8_t* request_hash,
+    const uint8_t* response,
+    size_t response_len) {
+    if(response_len < 1 || response[0] != CTAP2_OK ||
+       response_len > REPLAY_CACHE_MAX_RESPONSE) {
+        return;
+    }
+
+    Fido2ReplayEntry* entry = &ctap->replay_cache[ctap->replay_next];
+    ctap->replay_next = (ctap->replay_next + 1) % REPLAY_CACHE_ENTRIES;
+
+    entry->cid = ctap->cid;
+    memcpy(entry->request_hash, request_hash, sizeof(entry->request_hash));
+    entry->timestamp = furi_get_tick();
+    memcpy(entry->response, response, response_len);
+    entry->response_len = response_len;
+}
+
+/**
+ * @brief Drop all cached responses
+ */
+static void replay_cache_clear(Fido2Ctap* ctap) {
+    memset(ctap->replay_cache, 0, sizeof(ctap->replay_cache));
+    ctap->replay_next = 0;
+}
+
+/**
+ * @brief Make sure sign_count + 1 is covered by a persisted counter lease
+ *
+ * Journals the new ceiling once every FIDO2_SIGN_COUNT_LEASE assertions
+ * instead of relying on the save at app exit, so a crash can't roll
+ * counters back.
+ */
+static bool reserve_sign_count(Fido2Ctap* ctap, Fido2Credential* cred) {
+    if(!fido2_credential_counter_needs_lease(cred)) return true;
+
+    uint32_t previous = cred->sign_count_ceiling;
+    cred->sign_count_ceiling = cred->sign_count + FIDO2_SIGN_COUNT_LEASE;
+    if(!fido2_data_log_counter(ctap->credential_store, cred)) {
+        FURI_LOG_E(TAG, "Failed to persist counter lease");
+        cred->sign_count_ceiling = previous;
+        return false;
+    }
+    FURI_LOG_D(TAG, "Counter lease up to %lu", cred->sign_count_ceiling);
+    return true;
+}
+
 /**
  * @brief Wait for user presence with timeout
  */
-static bool wait_for_user_presence(Fido2Ctap* ctap, uint32_t timeout_ms) {
+static bool wait_for_user_presence(
+    Fido2Ctap* ctap,
+    const uint8_t* rp_id_hash,
+    uint32_t timeout_ms) {
     (void)timeout_ms; // Mark as unused to avoid warning
+
+    // Lab mode decides here, without a UI round-trip
+    if(fido_lab_auto_presence(ctap->lab, rp_id_hash)) {
+        FURI_LOG_I(TAG, "User presence auto-confirmed by lab policy");
+        return true;
+    }
+
     if(!ctap->up_callback) return false;
     
     // Simple implementation - in real world, this would be async
@@ -30,6 +202,85 @@ static bool wait_for_user_presence(Fido2Ctap* ctap, uint32_t timeout_ms) {
     return ctap->up_callback(ctap->up_context);
 }
 
+/**
+ * @brief Check whether a COSE algorithm is supported
+ */
+static bool is_algorithm_supported(int64_t alg) {
+    for(size_t i = 0; i < COUNT_OF(supported_algorithms); i++) {
+        if(supported_algorithms[i] == alg) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Parse one PublicKeyCredentialParameters map
+ *
+ * @return false on malformed CBOR; alg is left at 0 if the entry is not
+ *         a supported public-key algorithm
+ */
+static bool parse_pub_key_cred_param(CborDecoder* decoder, int32_t* alg) {
+    size_t param_map_size;
+    if(!cbor_decode_map_size(decoder, &param_map_size)) return false;
+
+    int64_t param_alg = 0;
+    bool has_alg = false;
+    bool is_public_key = false;
+
+    for(size_t i = 0; i < param_map_size; i++) {
+        const char* param_key;
+        size_t param_key_len;
+        if(!cbor_decode_text(decoder, &param_key, &param_key_len)) return false;
+
+        if(param_key_len == 3 && memcmp(param_key, "alg", 3) == 0) {
+            if(!cbor_decode_int(decoder, &param_alg)) return false;
+            has_alg = true;
+        } else if(param_key_len == 4 && memcmp(param_key, "type", 4) == 0) {
+            const char* type;
+            size_t type_len;
+            if(!cbor_decode_text(decoder, &type, &type_len)) return false;
+            is_public_key = (type_len == 10 && memcmp(type, "public-key", 10) == 0);
+        } else {
+            if(!cbor_skip_value(decoder)) return false;
+        }
+    }
+
+    *alg = (has_alg && is_public_key && is_algorithm_supported(param_alg)) ? (int32_t)param_alg :
+                                                                             0;
+    return true;
+}
+
+/**
+ * @brief Encode a credential public key as a COSE key
+ *
+ * Headers come from fido_templates.h; returns the encoded length
+ * (77 bytes for ES256, 42 for EdDSA).
+ */
+static size_t encode_cose_public_key(const Fido2Credential* cred, uint8_t* output) {
+    size_t offset = 0;
+
+    if(cred->algorithm == COSE_ALG_EDDSA) {
+        // OKP: kty, alg, crv, x
+        memcpy(output + offset, FIDO2_COSE_EDDSA_KEY_X_PREFIX, sizeof(FIDO2_COSE_EDDSA_KEY_X_PREFIX));
+        offset += sizeof(FIDO2_COSE_EDDSA_KEY_X_PREFIX);
+        memcpy(output + offset, cred->public_key_x, 32);
+        offset += 32;
+        return offset;
+    }
+
+    // EC2: kty, alg, crv, x, y
+    memcpy(output + offset, FIDO2_COSE_ES256_KEY_X_PREFIX, sizeof(FIDO2_COSE_ES256_KEY_X_PREFIX));
+    offset += sizeof(FIDO2_COSE_ES256_KEY_X_PREFIX);
+    memcpy(output + offset, cred->public_key_x, 32);
+    offset += 32;
+
+    memcpy(output + offset, FIDO2_COSE_ES256_KEY_Y_PREFIX, sizeof(FIDO2_COSE_ES256_KEY_Y_PREFIX));
+    offset += sizeof(FIDO2_COSE_ES256_KEY_Y_PREFIX);
+    memcpy(output + offset, cred->public_key_y, 32);
+    offset += 32;
+
+    return offset;
+}
+
 /**
  * @brief Build authenticator data for MakeCredential
  */
@@ -75,28 +326,7 @@ static size_t build_make_credential_auth_data(
         offset += MAX_CREDENTIAL_ID_SIZE;
         
         // COSE Key (public key in COSE format)
-        // Map with 5 entries: kty, alg, crv, x, y
-        offset += cbor_encode_map_header(output + offset, 5);
-        
-        // kty (key type) = 2 (EC2)
-        offset += cbor_encode_int(output + offset, 1);  // key 1
-        offset += cbor_encode_int(output + offset, COSE_KTY_EC2);
-        
-        // alg (algorithm) = -7 (ES256)
-        offset += cbor_encode_int(output + offset, 3);  // key 3
-        offset += cbor_encode_int(output + offset, COSE_ALG_ECDSA_WITH_SHA256);
-        
-        // crv (curve) = 1 (P-256)
-        offset += cbor_encode_int(output + offset, -1); // key -1
-        offset += cbor_encode_int(output + offset, COSE_CRV_P256);
-        
-        // x coordinate (32 bytes)
-        offset += cbor_encode_int(output + offset, -2); // key -2
-        offset += cbor_encode_bytes(output + offset, cred->public_key_x, 32);
-        
-        // y coordinate (32 bytes)
-        offset += cbor_encode_int(output + offset, -3); // key -3
-        offset += cbor_encode_bytes(output + offset, cred->public_key_y, 32);
+        offset += encode_cose_public_key(cred, output + offset);
     }
     
     return offset;
@@ -136,72 +366,32 @@ static size_t build_get_assertion_auth_data(
  * extensions, AAGUID, options, and max message size.
  */
 static size_t ctap2_get_info(Fido2Ctap* ctap, uint8_t* response, size_t max_len) {
-    if(!ctap || !response || max_len < 200) {
+    if(!ctap || !response || max_len < sizeof(FIDO2_GET_INFO_TEMPLATE)) {
         FURI_LOG_E(TAG, "GetInfo: invalid params");
         if(response && max_len > 0) response[0] = CTAP1_ERR_INVALID_PARAMETER;
         return 1;
     }
 
     FURI_LOG_I(TAG, "GetInfo");
-    size_t offset = 0;
-    
-    // Status code OK
-    response[offset++] = CTAP2_OK;
-    
-    // Map with 7 entries
-    offset += cbor_encode_map_header(response + offset, 7);
-    
-    // 0x01: versions (array)
-    offset += cbor_encode_uint(response + offset, 0x01);
-    offset += cbor_encode_array_header(response + offset, 2);
-    offset += cbor_encode_text(response + offset, "FIDO_2_0");
-    offset += cbor_encode_text(response + offset, "U2F_V2");
-    
-    // 0x02: extensions (empty array)
-    offset += cbor_encode_uint(response + offset, 0x02);
-    offset += cbor_encode_array_header(response + offset, 0);
-    
-    // 0x03: aaguid (byte string)
-    offset += cbor_encode_uint(response + offset, 0x03);
-    offset += cbor_encode_bytes(response + offset, ctap->aaguid, 16);
-    
-    // 0x04: options (map)
-    offset += cbor_encode_uint(response + offset, 0x04);
-    offset += cbor_encode_map_header(response + offset, 3);
-    offset += cbor_encode_text(response + offset, "rk");
-    offset += cbor_encode_bool(response + offset, true);   // Resident keys supported
-    offset += cbor_encode_text(response + offset, "up");
-    offset += cbor_encode_bool(response + offset, true);   // User presence supported
-    offset += cbor_encode_text(response + offset, "uv");
-    offset += cbor_encode_bool(response + offset, false);  // User verification not supported
-    
-    // 0x05: maxMsgSize (unsigned)
-    offset += cbor_encode_uint(response + offset, 0x05);
-    offset += cbor_encode_uint(response + offset, 1200);
-    
-    // 0x06: pinProtocols (empty array)
-    offset += cbor_encode_uint(response + offset, 0x06);
-    offset += cbor_encode_array_header(response + offset, 0);
-    
-    // 0x07: algorithms (array of supported algorithms)
-    offset += cbor_encode_uint(response + offset, 0x07);
-    offset += cbor_encode_array_header(response + offset, 1);
-    
-    // Algorithm entry (map with 2 entries)
-    offset += cbor_encode_map_header(response + offset, 2);
-    offset += cbor_encode_text(response + offset, "alg");
-    offset += cbor_encode_int(response + offset, COSE_ALG_ECDSA_WITH_SHA256);
-    offset += cbor_encode_text(response + offset, "type");
-    offset += cbor_encode_text(response + offset, "public-key");
-    
-    if(offset > max_len) {
-        FURI_LOG_E(TAG, "GetInfo: response too large");
-        response[0] = CTAP2_ERR_REQUEST_TOO_LARGE;
-        return 1;
+
+    // Invariant response precomputed by tools/gen_fido_templates.py
+    memcpy(response, FIDO2_GET_INFO_TEMPLATE, sizeof(FIDO2_GET_INFO_TEMPLATE));
+    memcpy(response + FIDO2_GET_INFO_AAGUID_OFFSET, ctap->aaguid, AAGUID_SIZE);
+
+    return sizeof(FIDO2_GET_INFO_TEMPLATE);
+}
+
+/**
+ * @brief Delete a new credential the relying party will not learn about
+ *
+ * Its put is already in the journal, so the delete goes there too, or the
+ * next load would bring the credential back.
+ */
+static void make_credential_discard(Fido2Ctap* ctap, Fido2Credential* cred) {
+    if(!fido2_data_log_delete(ctap->credential_store, cred->credential_id)) {
+        FURI_LOG_E(TAG, "Failed to journal the discarded credential");
     }
-    
-    FURI_LOG_I(TAG, "GetInfo done, %u bytes", offset);
-    return offset;
+    fido2_credential_delete(ctap->credential_store, cred);
 }
 
 /**
@@ -242,6 +432,8 @@ static size_t ctap2_make_credential(
     size_t user_display_name_len = 0;
     bool resident_key = false;
     bool user_verification = false;
+    bool has_cred_params = false;
+    int32_t algorithm = 0; // first supported entry, in RP preference order
     
     // Mark unused variables to avoid warnings
     (void)resident_key;
@@ -378,12 +570,15 @@ static size_t ctap2_make_credential(
                     return 1;
                 }
                 
-                // Skip for now - we only support ES256
+                has_cred_params = true;
                 for(size_t j = 0; j < array_size; j++) {
-                    if(!cbor_skip_value(&decoder)) {
+                    int32_t param_alg;
+                    if(!parse_pub_key_cred_param(&decoder, &param_alg)) {
+                        FURI_LOG_E(TAG, "Invalid pubKeyCredParams entry");
                         response[0] = CTAP2_ERR_INVALID_CBOR;
                         return 1;
                     }
+                    if(algorithm == 0) algorithm = param_alg;
                 }
             }
             break;
@@ -495,9 +690,24 @@ static size_t ctap2_make_credential(
         response[0] = CTAP2_ERR_MISSING_PARAMETER;
         return 1;
     }
+
+    // The HID layer reuses the request buffer for the response, so keep
+    // clientDataHash out of the way before authData is serialized over it
+    uint8_t* client_data_hash_buf = fido2_arena_get(ctap->scratch, 32);
+    memcpy(client_data_hash_buf, client_data_hash, 32);
+    client_data_hash = client_data_hash_buf;
+
+    // Negotiate algorithm; ES256 when the RP does not express a preference
+    if(!has_cred_params) {
+        algorithm = COSE_ALG_ECDSA_WITH_SHA256;
+    } else if(algorithm == 0) {
+        FURI_LOG_W(TAG, "No supported algorithm in pubKeyCredParams");
+        response[0] = CTAP2_ERR_UNSUPPORTED_ALGORITHM;
+        return 1;
+    }
     
     // Check if credential already exists for this RP and user
-    char rp_id_str[128];
+    char* rp_id_str = fido2_arena_get(ctap->scratch, FIDO2_RP_ID_MAX_SIZE);
     size_t copy_len = rp_id_len < 127 ? rp_id_len : 127;
     memcpy(rp_id_str, rp_id, copy_len);
     rp_id_str[copy_len] = '\0';
@@ -508,21 +718,25 @@ static size_t ctap2_make_credential(
         // In a real implementation, we might want to allow multiple credentials per RP
     }
     
+    // Compute RP ID hash
+    uint8_t* rp_id_hash = fido2_arena_get(ctap->scratch, 32);
+    mbedtls_sha256((const uint8_t*)rp_id_str, strlen(rp_id_str), rp_id_hash, 0);
+    
     // Wait for user presence
-    if(!wait_for_user_presence(ctap, 30000)) { // 30 second timeout
+    if(!wait_for_user_presence(ctap, rp_id_hash, 30000)) { // 30 second timeout
         FURI_LOG_W(TAG, "User presence timeout");
         response[0] = CTAP2_ERR_USER_ACTION_TIMEOUT;
         return 1;
     }
     
     // Create user ID string
-    char user_name_str[64] = {0};
+    char* user_name_str = fido2_arena_get(ctap->scratch, FIDO2_USER_NAME_MAX_SIZE);
     if(user_name) {
         copy_len = user_name_len < 63 ? user_name_len : 63;
         memcpy(user_name_str, user_name, copy_len);
     }
     
-    char user_display_str[64] = {0};
+    char* user_display_str = fido2_arena_get(ctap->scratch, FIDO2_DISPLAY_NAME_MAX_SIZE);
     if(user_display_name) {
         copy_len = user_display_name_len < 63 ? user_display_name_len : 63;
         memcpy(user_display_str, user_display_name, copy_len);
@@ -535,20 +749,29 @@ static size_t ctap2_make_credential(
         user_id,
         user_id_len,
         user_name_str,
-        user_display_str);
+        user_display_str,
+        algorithm);
     
     if(!cred) {
         FURI_LOG_E(TAG, "Failed to create credential");
         response[0] = CTAP2_ERR_KEY_STORE_FULL;
         return 1;
     }
+
+    // Durable before the relying party learns about it
+    if(!fido2_data_log_put(ctap->credential_store, cred)) {
+        fido2_credential_delete(ctap->credential_store, cred);
+        response[0] = CTAP2_ERR_PROCESSING;
+        return 1;
+    }
     
-    // Compute RP ID hash
-    uint8_t rp_id_hash[32];
-    mbedtls_sha256((const uint8_t*)rp_id_str, strlen(rp_id_str), rp_id_hash, 0);
-    
-    // Build authenticator data
-    uint8_t auth_data[512];
+    // Build response: status, map(3), 1: fmt "packed", 2: authData
+    size_t offset = 0;
+    memcpy(response, FIDO2_MAKE_CREDENTIAL_PREFIX, sizeof(FIDO2_MAKE_CREDENTIAL_PREFIX));
+    offset += sizeof(FIDO2_MAKE_CREDENTIAL_PREFIX);
+
+    // Serialize authData in place, behind a reserved byte string header
+    uint8_t* auth_data = response + offset + CBOR_BSTR8_HEADER_SIZE;
     size_t auth_data_len = build_make_credential_auth_data(
         ctap,
         rp_id_hash,
@@ -556,45 +779,38 @@ static size_t ctap2_make_credential(
         1, // Initial signature count
         cred,
         auth_data,
-        sizeof(auth_data));
+        max_len - offset - CBOR_BSTR8_HEADER_SIZE);
+    cbor_patch_bstr8_header(response + offset, auth_data_len);
+    offset += CBOR_BSTR8_HEADER_SIZE + auth_data_len;
     
-    // Build signature data (authData + clientDataHash)
-    uint8_t signature_data[512 + 32];
-    memcpy(signature_data, auth_data, auth_data_len);
-    memcpy(signature_data + auth_data_len, client_data_hash, 32);
-    
-    // Sign
-    uint8_t signature[128];
+    // 3: attStmt (packed self attestation: alg + sig)
+    offset += cbor_encode_uint(response + offset, 3);
+    offset += cbor_encode_map_header(response + offset, 2);
+    offset += cbor_encode_text(response + offset, "alg");
+    offset += cbor_encode_int(response + offset, cred->algorithm);
+    offset += cbor_encode_text(response + offset, "sig");
+
+    // Sign authData || clientDataHash straight into the response
     size_t signature_len = 0;
-    if(!fido2_credential_sign(cred, signature_data, auth_data_len + 32, signature, &signature_len)) {
-        FURI_LOG_E(TAG, "Failed to sign");
+    if(!fido2_credential_sign(
+           ctap->credential_store,
+           cred,
+           auth_data,
+           auth_data_len,
+           client_data_hash,
+           response + offset + CBOR_BSTR8_HEADER_SIZE,
+           &signature_len)) {
+        FURI_LOG_E(TAG, "Failed to sign, discarding the credential");
+        make_credential_discard(ctap, cred);
         response[0] = CTAP2_ERR_PROCESSING;
         return 1;
     }
-    
-    // Build response
-    size_t offset = 0;
-    response[offset++] = CTAP2_OK;
-    
-    // Map with 3 entries
-    offset += cbor_encode_map_header(response + offset, 3);
-    
-    // 1: fmt (string)
-    offset += cbor_encode_uint(response + offset, 1);
-    offset += cbor_encode_text(response + offset, "packed");
-    
-    // 2: authData (byte string)
-    offset += cbor_encode_uint(response + offset, 2);
-    offset += cbor_encode_bytes(response + offset, auth_data, auth_data_len);
-    
-    // 3: attStmt (map with signature)
-    offset += cbor_encode_uint(response + offset, 3);
-    offset += cbor_encode_map_header(response + offset, 1);
-    offset += cbor_encode_text(response + offset, "sig");
-    offset += cbor_encode_bytes(response + offset, signature, signature_len);
+    cbor_patch_bstr8_header(response + offset, signature_len);
+    offset += CBOR_BSTR8_HEADER_SIZE + signature_len;
     
     if(offset > max_len) {
         FURI_LOG_E(TAG, "Response too large");
+        make_credential_discard(ctap, cred);
         response[0] = CTAP2_ERR_REQUEST_TOO_LARGE;
         return 1;
     }
@@ -750,8 +966,14 @@ static size_t ctap2_get_assertion(
         response[0] = CTAP2_ERR_MISSING_PARAMETER;
         return 1;
     }
+
+    // The HID layer reuses the request buffer for the response, so keep
+    // clientDataHash out of the way before authData is serialized over it
+    uint8_t* client_data_hash_buf = fido2_arena_get(ctap->scratch, 32);
+    memcpy(client_data_hash_buf, client_data_hash, 32);
+    client_data_hash = client_data_hash_buf;
     
-    char rp_id_str[128];
+    char* rp_id_str = fido2_arena_get(ctap->scratch, FIDO2_RP_ID_MAX_SIZE);
     size_t copy_len = rp_id_len < 127 ? rp_id_len : 127;
     memcpy(rp_id_str, rp_id, copy_len);
     rp_id_str[copy_len] = '\0';
@@ -764,37 +986,20 @@ static size_t ctap2_get_assertion(
         return 1;
     }
     
+    // Compute RP ID hash
+    uint8_t* rp_id_hash = fido2_arena_get(ctap->scratch, 32);
+    mbedtls_sha256((const uint8_t*)rp_id_str, strlen(rp_id_str), rp_id_hash, 0);
+    
     // Wait for user presence if required
     if(user_presence) {
-        if(!wait_for_user_presence(ctap, 30000)) {
+        if(!wait_for_user_presence(ctap, rp_id_hash, 30000)) {
             FURI_LOG_W(TAG, "User presence timeout");
             response[0] = CTAP2_ERR_USER_ACTION_TIMEOUT;
             return 1;
         }
     }
     
-    // Compute RP ID hash
-    uint8_t rp_id_hash[32];
-    mbedtls_sha256((const uint8_t*)rp_id_str, strlen(rp_id_str), rp_id_hash, 0);
-    
-    // Build authenticator data
-    uint8_t auth_data[512];
-    size_t auth_data_len = build_get_assertion_auth_data(
-        rp_id_hash,
-        CTAP_AUTH_DATA_FLAG_UP,
-        cred->sign_count + 1,
-        auth_data);
-    
-    // Build signature data (authData + clientDataHash)
-    uint8_t signature_data[512 + 32];
-    memcpy(signature_data, auth_data, auth_data_len);
-    memcpy(signature_data + auth_data_len, client_data_hash, 32);
-    
-    // Sign
-    uint8_t signature[128];
-    size_t signature_len = 0;
-    if(!fido2_credential_sign(cred, signature_data, auth_data_len + 32, signature, &signature_len)) {
-        FURI_LOG_E(TAG, "Failed to sign");
+    if(!reserve_sign_count(ctap, cred)) {
         response[0] = CTAP2_ERR_PROCESSING;
         return 1;
     }
@@ -812,13 +1017,34 @@ static size_t ctap2_get_assertion(
     offset += cbor_encode_text(response + offset, "id");
     offset += cbor_encode_bytes(response + offset, cred->credential_id, 32);
     
-    // 2: authData
+    // 2: authData, serialized in place behind a reserved byte string header
     offset += cbor_encode_uint(response + offset, 2);
-    offset += cbor_encode_bytes(response + offset, auth_data, auth_data_len);
+    uint8_t* auth_data = response + offset + CBOR_BSTR8_HEADER_SIZE;
+    size_t auth_data_len = build_get_assertion_auth_data(
+        rp_id_hash,
+        CTAP_AUTH_DATA_FLAG_UP,
+        cred->sign_count + 1,
+        auth_data);
+    cbor_patch_bstr8_header(response + offset, auth_data_len);
+    offset += CBOR_BSTR8_HEADER_SIZE + auth_data_len;
     
-    // 3: signature
+    // 3: signature over authData || clientDataHash, written straight into the response
     offset += cbor_encode_uint(response + offset, 3);
-    offset += cbor_encode_bytes(response + offset, signature, signature_len);
+    size_t signature_len = 0;
+    if(!fido2_credential_sign(
+           ctap->credential_store,
+           cred,
+           auth_data,
+           auth_data_len,
+           client_data_hash,
+           response + offset + CBOR_BSTR8_HEADER_SIZE,
+           &signature_len)) {
+        FURI_LOG_E(TAG, "Failed to sign");
+        response[0] = CTAP2_ERR_PROCESSING;
+        return 1;
+    }
+    cbor_patch_bstr8_header(response + offset, signature_len);
+    offset += CBOR_BSTR8_HEADER_SIZE + signature_len;
     
     if(offset > max_len) {
         FURI_LOG_E(TAG, "Response too large");
@@ -843,24 +1069,528 @@ static size_t ctap2_reset(Fido2Ctap* ctap, uint8_t* response, size_t max_len) {
     (void)max_len;
     
     FURI_LOG_I(TAG, "Reset");
-    fido2_credential_reset(ctap->credential_store);
+    fido2_backup_abort(ctap->backup);
+    bool done = fido2_data_log_reset(ctap->credential_store);
+    if(done) {
+        fido2_credential_reset(ctap->credential_store);
+        replay_cache_clear(ctap);
+        // Compact the journal, the last data under the old vault keys, then
+        // replace the keys so earlier credentials cannot be recovered
+        done = fido2_data_save_credentials(ctap->credential_store) &&
+               fido2_data_rekey(ctap->credential_store);
+    }
     
     if(response && max_len >= 1) {
-        response[0] = CTAP2_OK;
+        response[0] = done ? CTAP2_OK : CTAP2_ERR_PROCESSING;
         return 1;
     }
     return 0;
 }
 
+/**
+ * @brief One entry of a bulk provisioning request
+ */
+typedef struct {
+    const uint8_t* rp_id;
+    size_t rp_id_len;
+    const uint8_t* user_id;
+    size_t user_id_len;
+    const uint8_t* user_name;
+    size_t user_name_len;
+    int32_t algorithm;
+} Fido2ProvisionEntry;
+
+/**
+ * @brief Parse one provisioning entry {1: rpId, 2: userId, 3: userName, 4: alg}
+ *
+ * @return CTAP2_OK or a CTAP2 error code
+ */
+static uint8_t parse_provision_entry(CborDecoder* decoder, Fido2ProvisionEntry* entry) {
+    memset(entry, 0, sizeof(Fido2ProvisionEntry));
+    entry->algorithm = COSE_ALG_ECDSA_WITH_SHA256;
+
+    size_t entry_map_size;
+    if(!cbor_decode_map_size(decoder, &entry_map_size)) return CTAP2_ERR_INVALID_CBOR;
+
+    for(size_t i = 0; i < entry_map_size; i++) {
+        uint64_t key;
+        if(!cbor_decode_uint(decoder, &key)) return CTAP2_ERR_INVALID_CBOR;
+
+        bool ok;
+        switch(key) {
+        case 1: // rpId
+            ok = cbor_decode_text(decoder, (const char**)&entry->rp_id, &entry->rp_id_len);
+            break;
+        case 2: // userId
+            ok = cbor_decode_bytes(decoder, &entry->user_id, &entry->user_id_len);
+            break;
+        case 3: // userName
+            ok = cbor_decode_text(decoder, (const char**)&entry->user_name, &entry->user_name_len);
+            break;
+        case 4: { // alg (optional, ES256 by default)
+            int64_t alg;
+            ok = cbor_decode_int(decoder, &alg);
+            if(ok && !is_algorithm_supported(alg)) return CTAP2_ERR_UNSUPPORTED_ALGORITHM;
+            entry->algorithm = (int32_t)alg;
+            break;
+        }
+        default:
+            ok = cbor_skip_value(decoder);
+            break;
+        }
+        if(!ok) return CTAP2_ERR_INVALID_CBOR;
+    }
+
+    if(!entry->rp_id || !entry->user_id) return CTAP2_ERR_MISSING_PARAMETER;
+    if(entry->rp_id_len == 0 || entry->rp_id_len >= FIDO2_RP_ID_MAX_SIZE ||
+       entry->user_id_len == 0 || entry->user_id_len > FIDO2_USER_ID_MAX_SIZE) {
+        return CTAP2_ERR_INVALID_CBOR;
+    }
+
+    return CTAP2_OK;
+}
+
+/**
+ * @brief Delete the credentials created so far by a failed provisioning batch
+ */
+static void provision_rollback(Fido2Ctap* ctap, const uint8_t* created_ids, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        fido2_credential_delete(
+            ctap->credential_store,
+            fido2_credential_find_by_id(
+                ctap->credential_store,
+                created_ids + i * FIDO2_CREDENTIAL_ID_SIZE,
+                FIDO2_CREDENTIAL_ID_SIZE));
+    }
+}
+
+/**
+ * @brief Vendor bulk provisioning command handler
+ *
+ * Request:  [{1: rpId, 2: userId, 3: userName, ?4: alg}, ...]
+ * Response: [{1: credentialId, 2: COSE public key}, ...]
+ *
+ * The whole batch is validated before any key is generated, confirmed
+ * with a single user presence check and persisted with a single write.
+ */
+static size_t ctap2_vendor_provision(
+    Fido2Ctap* ctap,
+    const uint8_t* request,
+    size_t req_len,
+    uint8_t* response,
+    size_t max_len) {
+    FURI_LOG_I(TAG, "VendorProvision");
+
+    CborDecoder decoder;
+    Fido2ProvisionEntry entry;
+    size_t count;
+
+    // Pass 1: validate every entry before touching the store
+    cbor_decoder_init(&decoder, request, req_len);
+    if(!cbor_decode_array_size(&decoder, &count) || count == 0) {
+        response[0] = CTAP2_ERR_INVALID_CBOR;
+        return 1;
+    }
+    if(count > PROVISION_MAX_BATCH) {
+        FURI_LOG_W(TAG, "Batch of %u exceeds %u entries", count, PROVISION_MAX_BATCH);
+        response[0] = CTAP2_ERR_LIMIT_EXCEEDED;
+        return 1;
+    }
+    for(size_t i = 0; i < count; i++) {
+        uint8_t status = parse_provision_entry(&decoder, &entry);
+        if(status != CTAP2_OK) {
+            FURI_LOG_E(TAG, "Invalid provisioning entry %u: 0x%02X", i, status);
+            response[0] = status;
+            return 1;
+        }
+    }
+
+    if(count > FIDO2_MAX_CREDENTIALS - fido2_credential_count(ctap->credential_store)) {
+        FURI_LOG_W(TAG, "Batch of %u does not fit the store", count);
+        response[0] = CTAP2_ERR_KEY_STORE_FULL;
+        return 1;
+    }
+
+    // One-byte array header plus one result per entry
+    if(1 + 1 + count * PROVISION_RESULT_MAX_SIZE > max_len) {
+        response[0] = CTAP2_ERR_REQUEST_TOO_LARGE;
+        return 1;
+    }
+
+    // One confirmation for the whole batch
+    if(!wait_for_user_presence(ctap, NULL, 30000)) {
+        FURI_LOG_W(TAG, "User presence timeout");
+        response[0] = CTAP2_ERR_USER_ACTION_TIMEOUT;
+        return 1;
+    }
+
+    // Pass 2: generate keys. The request is fully consumed before the
+    // response is written, as both may share the same buffer. Credentials
+    // are kept by id, as a large batch pages earlier ones out of RAM.
+    uint8_t* created_ids = fido2_arena_get(ctap->scratch, count * FIDO2_CREDENTIAL_ID_SIZE);
+    char* rp_id_str = fido2_arena_get(ctap->scratch, FIDO2_RP_ID_MAX_SIZE);
+    char* user_name_str = fido2_arena_get(ctap->scratch, FIDO2_USER_NAME_MAX_SIZE);
+
+    uint32_t keygen_start = furi_get_tick();
+    cbor_decoder_init(&decoder, request, req_len);
+    cbor_decode_array_size(&decoder, &count);
+    for(size_t i = 0; i < count; i++) {
+        parse_provision_entry(&decoder, &entry);
+
+        memcpy(rp_id_str, entry.rp_id, entry.rp_id_len);
+        rp_id_str[entry.rp_id_len] = '\0';
+
+        size_t name_len = entry.user_name_len < FIDO2_USER_NAME_MAX_SIZE - 1 ?
+                              entry.user_name_len :
+                              FIDO2_USER_NAME_MAX_SIZE - 1;
+        if(entry.user_name) memcpy(user_name_str, entry.user_name, name_len);
+        user_name_str[entry.user_name ? name_len : 0] = '\0';
+
+        Fido2Credential* cred = fido2_credential_create(
+            ctap->credential_store,
+            rp_id_str,
+            entry.user_id,
+            entry.user_id_len,
+            user_name_str,
+            user_name_str,
+            entry.algorithm);
+
+        if(!cred) {
+            FURI_LOG_E(TAG, "Provisioning failed at entry %u, rolling back", i);
+            provision_rollback(ctap, created_ids, i);
+            response[0] = CTAP2_ERR_PROCESSING;
+            return 1;
+        }
+        memcpy(
+            created_ids + i * FIDO2_CREDENTIAL_ID_SIZE,
+            cred->credential_id,
+            FIDO2_CREDENTIAL_ID_SIZE);
+    }
+
+    uint32_t keygen_ms = furi_get_tick() - keygen_start;
+
+    // Persist once for the whole batch
+    if(!fido2_data_save_credentials(ctap->credential_store)) {
+        FURI_LOG_E(TAG, "Failed to persist provisioned credentials, rolling back");
+        provision_rollback(ctap, created_ids, count);
+        response[0] = CTAP2_ERR_PROCESSING;
+        return 1;
+    }
+
+    // Stream results straight from the store into the response, paging
+    // each record back in as needed
+    size_t offset = 0;
+    response[offset++] = CTAP2_OK;
+    offset += cbor_encode_array_header(response + offset, count);
+    for(size_t i = 0; i < count; i++) {
+        const Fido2Credential* cred = fido2_credential_find_by_id(
+            ctap->credential_store,
+            created_ids + i * FIDO2_CREDENTIAL_ID_SIZE,
+            FIDO2_CREDENTIAL_ID_SIZE);
+        if(!cred) {
+            response[0] = CTAP2_ERR_PROCESSING;
+            return 1;
+        }
+        offset += cbor_encode_map_header(response + offset, 2);
+        offset += cbor_encode_uint(response + offset, 1);
+        offset +=
+            cbor_encode_bytes(response + offset, cred->credential_id, MAX_CREDENTIAL_ID_SIZE);
+        offset += cbor_encode_uint(response + offset, 2);
+        offset += encode_cose_public_key(cred, response + offset);
+    }
+
+    FURI_LOG_I(TAG, "Provisioned %u credentials, key generation %lu ms", count, keygen_ms);
+    return offset;
+}
+
+/**
+ * @brief Vendor streaming backup/restore command handler
+ *
+ * Exports or imports the credential store one encrypted record per
+ * request (see fido2_backup.h). Starting either direction requires user
+ * presence; any protocol error aborts the session.
+ */
+static size_t ctap2_vendor_backup(
+    Fido2Ctap* ctap,
+    const uint8_t* request,
+    size_t req_len,
+    uint8_t* response,
+    size_t max_len) {
+    CborDecoder decoder;
+    cbor_decoder_init(&decoder, request, req_len);
+
+    uint64_t sub_command = 0;
+    const uint8_t* transport_key = NULL;
+    size_t transport_key_len = 0;
+    const uint8_t* nonce = NULL;
+    size_t nonce_len = 0;
+    uint64_t seq = 0;
+    const uint8_t* chunk = NULL;
+    size_t chunk_len = 0;
+    const uint8_t* tag = NULL;
+    size_t tag_len = 0;
+
+    size_t map_size;
+    if(!cbor_decode_map_size(&decoder, &map_size)) {
+        response[0] = CTAP2_ERR_INVALID_CBOR;
+        return 1;
+    }
+    for(size_t i = 0; i < map_size; i++) {
+        uint64_t key;
+        bool ok = cbor_decode_uint(&decoder, &key);
+        if(ok) {
+            switch(key) {
+            case 1:
+                ok = cbor_decode_uint(&decoder, &sub_command);
+                break;
+            case 2:
+                ok = cbor_decode_bytes(&decoder, &transport_key, &transport_key_len);
+                break;
+            case 3:
+                ok = cbor_decode_bytes(&decoder, &nonce, &nonce_len);
+                break;
+            case 4:
+                ok = cbor_decode_uint(&decoder, &seq);
+                break;
+            case 5:
+                ok = cbor_decode_bytes(&decoder, &chunk, &chunk_len);
+                break;
+            case 6:
+                ok = cbor_decode_bytes(&decoder, &tag, &tag_len);
+                break;
+            default:
+                ok = cbor_skip_value(&decoder);
+                break;
+            }
+        }
+        if(!ok) {
+            response[0] = CTAP2_ERR_INVALID_CBOR;
+            return 1;
+        }
+    }
+
+    if(max_len < FIDO2_BACKUP_CHUNK_SIZE + 16) {
+        response[0] = CTAP2_ERR_REQUEST_TOO_LARGE;
+        return 1;
+    }
+
+    size_t offset = 0;
+    response[offset++] = CTAP2_OK;
+
+    switch(sub_command) {
+    case CTAP2_BACKUP_EXPORT_BEGIN: {
+        if(transport_key_len != FIDO2_BACKUP_KEY_SIZE) {
+            response[0] = CTAP2_ERR_MISSING_PARAMETER;
+            return 1;
+        }
+        if(!wait_for_user_presence(ctap, NULL, 30000)) {
+            response[0] = CTAP2_ERR_USER_ACTION_TIMEOUT;
+            return 1;
+        }
+        uint8_t session_nonce[FIDO2_BACKUP_NONCE_SIZE];
+        uint32_t count = fido2_backup_export_begin(ctap->backup, transport_key, session_nonce);
+
+        offset += cbor_encode_map_header(response + offset, 2);
+        offset += cbor_encode_uint(response + offset, 1);
+        offset += cbor_encode_bytes(response + offset, session_nonce, sizeof(session_nonce));
+        offset += cbor_encode_uint(response + offset, 2);
+        offset += cbor_encode_uint(response + offset, count);
+        return offset;
+    }
+
+    case CTAP2_BACKUP_EXPORT_NEXT: {
+        uint32_t chunk_seq;
+        // Header is at most 1 + 1 + 5 + 1 + 3 bytes; the chunk is encrypted in place after it
+        uint8_t* chunk_out = response + offset + 11;
+        Fido2BackupExportResult result =
+            fido2_backup_export_next(ctap->backup, &chunk_seq, chunk_out);
+        if(result == Fido2BackupExportInvalid) {
+            // Before EXPORT_BEGIN or past the final tag
+            fido2_backup_abort(ctap->backup);
+            response[0] = CTAP2_ERR_NOT_ALLOWED;
+            return 1;
+        }
+        if(result == Fido2BackupExportDone) {
+            uint8_t final_tag[FIDO2_BACKUP_MAC_SIZE];
+            memcpy(final_tag, chunk_out, sizeof(final_tag));
+            offset += cbor_encode_map_header(response + offset, 1);
+            offset += cbor_encode_uint(response + offset, 5);
+            offset += cbor_encode_bytes(response + offset, final_tag, sizeof(final_tag));
+            return offset;
+        }
+
+        size_t header = cbor_encode_map_header(response + offset, 2);
+        header += cbor_encode_uint(response + offset + header, 3);
+        header += cbor_encode_uint(response + offset + header, chunk_seq);
+        header += cbor_encode_uint(response + offset + header, 4);
+        // Byte string header (0x59 + 16-bit length) for the chunk
+        response[offset + header++] = 0x59;
+        response[offset + header++] = (FIDO2_BACKUP_CHUNK_SIZE >> 8) & 0xFF;
+        response[offset + header++] = FIDO2_BACKUP_CHUNK_SIZE & 0xFF;
+        memmove(response + offset + header, chunk_out, FIDO2_BACKUP_CHUNK_SIZE);
+        offset += header + FIDO2_BACKUP_CHUNK_SIZE;
+        return offset;
+    }
+
+    case CTAP2_BACKUP_IMPORT_BEGIN:
+        if(transport_key_len != FIDO2_BACKUP_KEY_SIZE || nonce_len != FIDO2_BACKUP_NONCE_SIZE) {
+            response[0] = CTAP2_ERR_MISSING_PARAMETER;
+            return 1;
+        }
+        if(!wait_for_user_presence(ctap, NULL, 30000)) {
+            response[0] = CTAP2_ERR_USER_ACTION_TIMEOUT;
+            return 1;
+        }
+        fido2_backup_import_begin(ctap->backup, transport_key, nonce);
+        return offset;
+
+    case CTAP2_BACKUP_IMPORT_RECORD: {
+        if(!chunk || seq > UINT32_MAX) {
+            response[0] = CTAP2_ERR_MISSING_PARAMETER;
+            return 1;
+        }
+        Fido2BackupImportResult result =
+            fido2_backup_import_record(ctap->backup, (uint32_t)seq, chunk, chunk_len);
+        if(result == Fido2BackupImportInvalid || result == Fido2BackupImportFull) {
+            fido2_backup_abort(ctap->backup);
+            response[0] = (result == Fido2BackupImportFull) ? CTAP2_ERR_KEY_STORE_FULL :
+                                                              CTAP2_ERR_INVALID_CREDENTIAL;
+            return 1;
+        }
+        offset += cbor_encode_map_header(response + offset, 1);
+        offset += cbor_encode_uint(response + offset, 1);
+        offset += cbor_encode_bool(response + offset, result == Fido2BackupImportDuplicate);
+        return offset;
+    }
+
+    case CTAP2_BACKUP_IMPORT_FINISH: {
+        uint32_t imported = 0;
+        if(tag_len != FIDO2_BACKUP_MAC_SIZE ||
+           !fido2_backup_import_finish(ctap->backup, tag, &imported)) {
+            fido2_backup_abort(ctap->backup);
+            response[0] = CTAP2_ERR_INVALID_CREDENTIAL;
+            return 1;
+        }
+        if(imported > 0 && !fido2_data_save_credentials(ctap->credential_store)) {
+            FURI_LOG_E(TAG, "Failed to persist restored credentials, rolling back");
+            fido2_backup_abort(ctap->backup);
+            response[0] = CTAP2_ERR_PROCESSING;
+            return 1;
+        }
+        fido2_backup_import_commit(ctap->backup);
+        offset += cbor_encode_map_header(response + offset, 1);
+        offset += cbor_encode_uint(response + offset, 2);
+        offset += cbor_encode_uint(response + offset, imported);
+        return offset;
+    }
+
+    default:
+        fido2_backup_abort(ctap->backup);
+        response[0] = CTAP1_ERR_INVALID_PARAMETER;
+        return 1;
+    }
+}
+
+/**
+ * @brief Update the per-command scratch high-water mark
+ *
+ * @return peak usage recorded for this command
+ */
+static size_t scratch_record_peak(Fido2Ctap* ctap, uint8_t cmd, size_t used) {
+    for(size_t i = 0; i < ctap->scratch_stats_count; i++) {
+        Fido2ScratchStat* stat = &ctap->scratch_stats[i];
+        if(stat->cmd == cmd) {
+            if(used > stat->peak) stat->peak = used;
+            return stat->peak;
+        }
+    }
+
+    // Unknown commands beyond the table are still reported, just not tracked
+    if(ctap->scratch_stats_count < SCRATCH_STATS_ENTRIES) {
+        Fido2ScratchStat* stat = &ctap->scratch_stats[ctap->scratch_stats_count++];
+        stat->cmd = cmd;
+        stat->peak = used;
+    }
+    return used;
+}
+
+/**
+ * @brief Route a validated request to its command handler
+ */
+static size_t fido2_ctap_dispatch(
+    Fido2Ctap* ctap,
+    uint8_t cmd,
+    const uint8_t* request,
+    size_t req_len,
+    uint8_t* response,
+    size_t max_len) {
+    switch(cmd) {
+    case CTAP2_CMD_GET_INFO:
+        return ctap2_get_info(ctap, response, max_len);
+        
+    case CTAP2_CMD_MAKE_CREDENTIAL:
+    case CTAP2_CMD_GET_ASSERTION: {
+        if(req_len < 2) {
+            response[0] = CTAP2_ERR_INVALID_CBOR;
+            return 1;
+        }
+
+        // Hash before dispatch: request and response may share a buffer
+        uint8_t* request_hash = fido2_arena_get(ctap->scratch, 32);
+        mbedtls_sha256(request, req_len, request_hash, 0);
+
+        size_t resp_len = replay_cache_lookup(ctap, request_hash, response, max_len);
+        if(resp_len > 0) {
+            FURI_LOG_I(TAG, "Replaying cached response for retransmitted request");
+            return resp_len;
+        }
+
+        if(cmd == CTAP2_CMD_MAKE_CREDENTIAL) {
+            resp_len = ctap2_make_credential(ctap, request + 1, req_len - 1, response, max_len);
+        } else {
+            resp_len = ctap2_get_assertion(ctap, request + 1, req_len - 1, response, max_len);
+        }
+
+        replay_cache_store(ctap, request_hash, response, resp_len);
+        return resp_len;
+    }
+        
+    case CTAP2_CMD_RESET:
+        return ctap2_reset(ctap, response, max_len);
+
+    case CTAP2_CMD_VENDOR_PROVISION:
+        if(req_len < 2) {
+            response[0] = CTAP2_ERR_INVALID_CBOR;
+            return 1;
+        }
+        return ctap2_vendor_provision(ctap, request + 1, req_len - 1, response, max_len);
+
+    case CTAP2_CMD_VENDOR_BACKUP:
+        if(req_len < 2) {
+            response[0] = CTAP2_ERR_INVALID_CBOR;
+            return 1;
+        }
+        return ctap2_vendor_backup(ctap, request + 1, req_len - 1, response, max_len);
+        
+    default:
+        FURI_LOG_W(TAG, "Unsupported cmd: 0x%02X", cmd);
+        response[0] = CTAP1_ERR_INVALID_COMMAND;
+        return 1;
+    }
+}
+
+
 Fido2Ctap* fido2_ctap_alloc(Fido2CredentialStore* store) {
     Fido2Ctap* ctap = malloc(sizeof(Fido2Ctap));
     if(!ctap) return NULL;
     
     memset(ctap, 0, sizeof(Fido2Ctap));
-    furi_hal_random_fill_buf(ctap->aaguid, 16);
+    fido_drbg_fill(ctap->aaguid, 16);
     ctap->credential_store = store;
     ctap->up_callback = NULL;
     ctap->up_context = NULL;
+    ctap->scratch = fido2_arena_alloc(SCRATCH_ARENA_SIZE);
+    ctap->backup = fido2_backup_alloc(store);
     
     FURI_LOG_I(TAG, "CTAP2 module initialized");
     return ctap;
@@ -868,9 +1598,35 @@ Fido2Ctap* fido2_ctap_alloc(Fido2CredentialStore* store) {
 
 void fido2_ctap_free(Fido2Ctap* ctap) {
     if(!ctap) return;
+    replay_cache_clear(ctap);
+    fido2_backup_free(ctap->backup);
+    fido2_arena_free(ctap->scratch);
     free(ctap);
 }
 
+void fido2_ctap_set_lab_policy(Fido2Ctap* ctap, FidoLab* lab) {
+    if(!ctap) return;
+    ctap->lab = lab;
+}
+
+bool fido2_ctap_precompute(Fido2Ctap* ctap) {
+    if(!ctap) return false;
+    if(fido2_credential_precompute(ctap->credential_store)) return true;
+    // Fold a long journal into a new snapshot while nothing else is going on
+    return fido2_data_needs_compaction(ctap->credential_store) &&
+           fido2_data_save_credentials(ctap->credential_store);
+}
+
+void fido2_ctap_set_yield_callback(Fido2Ctap* ctap, FidoP256YieldCallback callback, void* context) {
+    if(!ctap) return;
+    fido2_credential_set_yield_callback(ctap->credential_store, callback, context);
+}
+
+void fido2_ctap_set_channel(Fido2Ctap* ctap, uint32_t cid) {
+    if(!ctap) return;
+    ctap->cid = cid;
+}
+
 void fido2_ctap_set_user_presence_callback(
     Fido2Ctap* ctap,
     Fido2UserPresenceCallback callback,
@@ -912,33 +1668,33 @@ size_t fido2_ctap_process(
     
     uint8_t cmd = request[0];
     FURI_LOG_I(TAG, "CTAP2 cmd=0x%02X len=%u", cmd, req_len);
-    
-    switch(cmd) {
-    case CTAP2_CMD_GET_INFO:
-        return ctap2_get_info(ctap, response, max_len);
-        
-    case CTAP2_CMD_MAKE_CREDENTIAL:
-        if(req_len < 2) {
-            response[0] = CTAP2_ERR_INVALID_CBOR;
-            return 1;
-        }
-        return ctap2_make_credential(ctap, request + 1, req_len - 1, response, max_len);
-        
-    case CTAP2_CMD_GET_ASSERTION:
-        if(req_len < 2) {
-            response[0] = CTAP2_ERR_INVALID_CBOR;
-            return 1;
-        }
-        return ctap2_get_assertion(ctap, request + 1, req_len - 1, response, max_len);
-        
-    case CTAP2_CMD_RESET:
-        return ctap2_reset(ctap, response, max_len);
-        
-    default:
-        FURI_LOG_W(TAG, "Unsupported cmd: 0x%02X", cmd);
-        response[0] = CTAP1_ERR_INVALID_COMMAND;
-        return 1;
+
+    size_t resp_len = fido2_ctap_dispatch(ctap, cmd, request, req_len, response, max_len);
+
+    // Transaction done: record scratch usage and release it
+    size_t scratch_used = fido2_arena_used(ctap->scratch);
+    size_t scratch_peak = scratch_record_peak(ctap, cmd, scratch_used);
+    fido2_arena_reset(ctap->scratch);
+
+    FURI_LOG_D(
+        TAG,
+        "cmd=0x%02X scratch %u/%u (peak %u), stack free %lu",
+        cmd,
+        scratch_used,
+        fido2_arena_size(ctap->scratch),
+        scratch_peak,
+        furi_thread_get_stack_space(furi_thread_get_current_id()));
+
+    return resp_len;
+}
+
+size_t fido2_ctap_get_scratch_high_water(Fido2Ctap* ctap, uint8_t cmd) {
+    if(!ctap) return 0;
+
+    for(size_t i = 0; i < ctap->scratch_stats_count; i++) {
+        if(ctap->scratch_stats[i].cmd == cmd) return ctap->scratch_stats[i].peak;
     }
+    return 0;
 }
 
 void fido2_ctap_get_aaguid(Fido2Ctap* ctap, uint8_t* aaguid) {
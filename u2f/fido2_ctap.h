@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "fido2_credential.h"
+#include "fido_lab.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -16,6 +17,17 @@ extern "C" {
 #define CTAP2_CMD_RESET            0x07
 #define CTAP2_CMD_GET_NEXT_ASSERTION 0x08
 
+// Vendor command codes (0x40-0xBF)
+#define CTAP2_CMD_VENDOR_PROVISION 0x41 // Bulk credential provisioning
+#define CTAP2_CMD_VENDOR_BACKUP    0x42 // Streaming encrypted backup/restore
+
+// CTAP2_CMD_VENDOR_BACKUP sub-commands (request key 0x01)
+#define CTAP2_BACKUP_EXPORT_BEGIN  0x01 // {2: transportKey} -> {1: nonce, 2: count}
+#define CTAP2_BACKUP_EXPORT_NEXT   0x02 // {} -> {3: seq, 4: chunk} | {5: finalTag}
+#define CTAP2_BACKUP_IMPORT_BEGIN  0x03 // {2: transportKey, 3: nonce} -> {}
+#define CTAP2_BACKUP_IMPORT_RECORD 0x04 // {4: seq, 5: chunk} -> {1: duplicate}
+#define CTAP2_BACKUP_IMPORT_FINISH 0x05 // {6: finalTag} -> {2: imported}
+
 // CTAP2 status codes (CTAP1 compatibility)
 #define CTAP2_OK                    0x00
 #define CTAP1_ERR_INVALID_COMMAND   0x01
@@ -42,6 +54,7 @@ extern "C" {
 #define CTAP2_ERR_UNSUPPORTED_ALGORITHM 0x26
 #define CTAP2_ERR_OPERATION_DENIED   0x27
 #define CTAP2_ERR_KEY_STORE_FULL     0x28
+#define CTAP2_ERR_KEEPALIVE_CANCEL   0x2D
 #define CTAP2_ERR_NO_CREDENTIALS     0x2E
 #define CTAP2_ERR_USER_ACTION_TIMEOUT 0x2F
 #define CTAP2_ERR_NOT_ALLOWED        0x30
@@ -113,6 +126,22 @@ void fido2_ctap_set_user_presence_callback(
     Fido2UserPresenceCallback callback,
     void* context);
 
+/**
+ * @brief Set test-lab auto-presence policy
+ *
+ * @param ctap CTAP2 instance
+ * @param lab Policy owned by the caller, or NULL to always ask the user
+ */
+void fido2_ctap_set_lab_policy(Fido2Ctap* ctap, FidoLab* lab);
+
+/**
+ * @brief Set the CTAPHID channel of the next request
+ *
+ * Used to key the replay cache, so a byte-identical retransmission on the
+ * same channel is answered without a new user presence prompt or signature.
+ */
+void fido2_ctap_set_channel(Fido2Ctap* ctap, uint32_t cid);
+
 /**
  * @brief Process CTAP2 command
  */
@@ -123,11 +152,39 @@ size_t fido2_ctap_process(
     uint8_t* response,
     size_t max_len);
 
+/**
+ * @brief Get the peak scratch arena usage seen for a command
+ *
+ * @param ctap CTAP2 instance
+ * @param cmd CTAP2 command code
+ * @return high-water mark in bytes, 0 if the command was never processed
+ */
+size_t fido2_ctap_get_scratch_high_water(Fido2Ctap* ctap, uint8_t cmd);
+
 /**
  * @brief Get AAGUID
  */
 void fido2_ctap_get_aaguid(Fido2Ctap* ctap, uint8_t* aaguid);
 
+/**
+ * @brief Do one step of idle-time precomputation (e.g. an ECDSA nonce)
+ *
+ * Called by the HID worker while no request is pending. Also compacts the
+ * credential journal once it has grown past FIDO2_JOURNAL_COMPACT_SIZE.
+ *
+ * @return true if work was done and there may be more
+ */
+bool fido2_ctap_precompute(Fido2Ctap* ctap);
+
+/**
+ * @brief Yield between slices of long crypto operations
+ *
+ * Lets the HID worker send keepalives and notice CTAPHID_CANCEL while a
+ * request is being processed, or drop idle precomputation as soon as a
+ * request arrives. See fido2_credential_set_yield_callback.
+ */
+void fido2_ctap_set_yield_callback(Fido2Ctap* ctap, FidoP256YieldCallback callback, void* context);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -1,12 +1,50 @@
 #include "fido2_data.h"
-#include "fido2_credential.h"
+#include "fido2_credential_i.h"
+#include "fido2_ctap.h"
+#include "fido2_crc32.h"
+#include "fido_drbg.h"
 #include <furi.h>
 #include <storage/storage.h>
 #include <flipper_format/flipper_format.h>
+#include <string.h>
 
 #define TAG "FIDO2_DATA"
-#define FIDO2_CRED_FILE_TYPE "Flipper FIDO2 Credential File"
-#define FIDO2_CRED_VERSION   1
+
+/**
+ * Credentials live in FIDO2_PAGE_FILE, see fido2_page_store.h. The
+ * FlipperFormat text file of earlier versions is migrated to the page file
+ * on first load.
+ *
+ * Journal of mutations not yet written back to the page file, replayed on
+ * load, all integers little-endian:
+ *
+ *   magic(4) salt(FIDO2_JOURNAL_SALT_SIZE)
+ *   entries: op(1) length(2) payload(length) crc(4), crc over op..payload
+ *
+ * Payloads are encrypted with the vault keys of the page file, each under
+ * the nonce salt || entry offset; salt is random for every new journal and
+ * starts with FIDO2_VAULT_DOMAIN_JOURNAL.
+ *
+ * Dirty pages may be written back at any time, so the page file can be
+ * ahead of the journal; replay is idempotent for that (counters only move
+ * up). Replay stops at the first torn or corrupt entry.
+ */
+#define FIDO2_JOURNAL_MAGIC          0x45433246 // "F2CE"
+#define FIDO2_JOURNAL_HEADER_SIZE    (4 + FIDO2_JOURNAL_SALT_SIZE)
+#define FIDO2_JOURNAL_ENTRY_OVERHEAD 7
+#define FIDO2_JOURNAL_MAX_PAYLOAD    FIDO2_CREDENTIAL_RECORD_SIZE
+
+typedef enum {
+    Fido2JournalOpPut = 1, // payload: credential record
+    Fido2JournalOpCounter = 2, // payload: credential_id(32) sign_count(4)
+    Fido2JournalOpReset = 3, // no payload
+    Fido2JournalOpDelete = 4, // payload: credential_id(32)
+} Fido2JournalOp;
+
+// FlipperFormat text files, migrated once to the page file
+#define FIDO2_CRED_FILE_TYPE  "Flipper FIDO2 Credential File"
+#define FIDO2_CRED_VERSION_V2 2
+#define FIDO2_CRED_VERSION_V1 1 // ES256 only, no Alg_ field
 
 /**
  * @brief Write debug message to SD card
@@ -25,13 +63,6 @@ static void debug_log(const char* msg) {
     furi_record_close(RECORD_STORAGE);
 }
 
-/**
- * @brief Complete definition of credential store
- */
-struct Fido2CredentialStore {
-    Fido2Credential credentials[FIDO2_MAX_CREDENTIALS];
-};
-
 bool fido2_data_init(void) {
     FURI_LOG_I(TAG, "fido2_data_init - START");
     debug_log("fido2_data_init - START");
@@ -104,12 +135,26 @@ bool fido2_data_init(void) {
 bool fido2_data_check(bool cert_only) {
     UNUSED(cert_only);
     Storage* storage = furi_record_open(RECORD_STORAGE);
-    bool exists = storage_common_stat(storage, FIDO2_CRED_FILE, NULL) == FSE_OK;
+    bool exists = storage_common_stat(storage, FIDO2_PAGE_FILE, NULL) == FSE_OK ||
+                  storage_common_stat(storage, FIDO2_CRED_LEGACY_FILE, NULL) == FSE_OK;
     furi_record_close(RECORD_STORAGE);
     FURI_LOG_I(TAG, "fido2_data_check: credentials file exists = %d", exists);
     return exists;
 }
 
+static uint8_t* put_u32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+    return out + 4;
+}
+
+static uint32_t get_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+           ((uint32_t)in[3] << 24);
+}
+
 bool fido2_data_save_credentials(void* credentials) {
     struct Fido2CredentialStore* store = (struct Fido2CredentialStore*)credentials;
     if(!store) {
@@ -117,171 +162,294 @@ bool fido2_data_save_credentials(void* credentials) {
         return false;
     }
 
-    FURI_LOG_I(TAG, "fido2_data_save_credentials - START");
     debug_log("fido2_data_save_credentials - START");
+    uint32_t start = furi_get_tick();
 
-    Storage* storage = furi_record_open(RECORD_STORAGE);
-    FlipperFormat* flipper_format = flipper_format_file_alloc(storage);
-
-    bool success = false;
-    uint32_t count = 0;
+    bool success = fido2_page_store_flush(store->pages);
+    if(success) {
+        // The page file now holds everything the journal did
+        Storage* storage = furi_record_open(RECORD_STORAGE);
+        storage_simply_remove(storage, FIDO2_CRED_JOURNAL_FILE);
+        furi_record_close(RECORD_STORAGE);
+        store->journal_size = 0;
+    }
 
-    // Count valid credentials
-    for(size_t i = 0; i < FIDO2_MAX_CREDENTIALS; i++) {
-        if(store->credentials[i].valid) {
-            count++;
-        }
+    if(success) {
+        FURI_LOG_I(
+            TAG,
+            "Saved %u credentials in %lu ms",
+            fido2_credential_count(store),
+            furi_get_tick() - start);
+        debug_log("fido2_data_save_credentials - SUCCESS");
+    } else {
+        FURI_LOG_E(TAG, "fido2_data_save_credentials - FAILED");
+        debug_log("fido2_data_save_credentials - FAILED");
     }
-    FURI_LOG_I(TAG, "Saving %lu credentials", count);
-    
-    char count_msg[32];
-    snprintf(count_msg, sizeof(count_msg), "Saving %lu credentials", count);
-    debug_log(count_msg);
-
-    if(flipper_format_file_open_always(flipper_format, FIDO2_CRED_FILE)) {
-        // Write header
-        if(!flipper_format_write_header_cstr(
-               flipper_format, FIDO2_CRED_FILE_TYPE, FIDO2_CRED_VERSION)) {
-            FURI_LOG_E(TAG, "Failed to write header");
-            debug_log("Failed to write header");
-            goto cleanup;
-        }
+    return success;
+}
 
-        // Write credential count
-        if(!flipper_format_write_uint32(flipper_format, "Count", &count, 1)) {
-            FURI_LOG_E(TAG, "Failed to write count");
-            debug_log("Failed to write count");
-            goto cleanup;
-        }
+/**
+ * @brief En- or decrypt the payload of the journal entry at an offset
+ */
+static bool fido2_data_journal_crypt(
+    struct Fido2CredentialStore* store,
+    const Fido2Vault* vault,
+    uint32_t offset,
+    const uint8_t* in,
+    uint8_t* out,
+    uint16_t len) {
+    uint8_t nonce[FIDO2_VAULT_NONCE_SIZE];
+    memcpy(nonce, store->journal_salt, FIDO2_JOURNAL_SALT_SIZE);
+    put_u32(nonce + FIDO2_JOURNAL_SALT_SIZE, offset);
+    return fido2_vault_crypt(vault, nonce, in, out, len);
+}
 
-        // Write each credential
-        uint32_t saved = 0;
-        for(size_t i = 0; i < FIDO2_MAX_CREDENTIALS; i++) {
-            Fido2Credential* cred = &store->credentials[i];
-            if(!cred->valid) continue;
+/**
+ * @brief Append one entry to the journal and sync it to the card
+ */
+static bool fido2_data_journal_append(
+    struct Fido2CredentialStore* store,
+    uint8_t op,
+    const uint8_t* payload,
+    uint16_t payload_len) {
+    furi_check(payload_len <= FIDO2_JOURNAL_MAX_PAYLOAD);
+    const Fido2Vault* vault = fido2_page_store_vault(store->pages);
+    if(!vault) {
+        FURI_LOG_E(TAG, "No vault keys for the journal");
+        return false;
+    }
 
-            char key[32];
+    // A new journal gets a new salt
+    bool fresh = store->journal_size == 0;
+    if(fresh) {
+        store->journal_salt[0] = FIDO2_VAULT_DOMAIN_JOURNAL;
+        fido_drbg_fill(store->journal_salt + 1, FIDO2_JOURNAL_SALT_SIZE - 1);
+    }
 
-            // Credential ID
-            snprintf(key, sizeof(key), "CredID_%u", (unsigned)saved);
-            if(!flipper_format_write_hex(flipper_format, key, cred->credential_id, 32)) {
-                FURI_LOG_E(TAG, "Failed to write credential ID");
-                goto cleanup;
-            }
+    // Room for the journal header in front of the first entry
+    size_t size = FIDO2_JOURNAL_HEADER_SIZE + FIDO2_JOURNAL_ENTRY_OVERHEAD + payload_len;
+    uint8_t* buffer = malloc(size);
+    uint8_t* entry = buffer + FIDO2_JOURNAL_HEADER_SIZE;
+    entry[0] = op;
+    entry[1] = payload_len & 0xFF;
+    entry[2] = payload_len >> 8;
+    uint32_t offset = fresh ? FIDO2_JOURNAL_HEADER_SIZE : store->journal_size;
+    bool sealed = true;
+    if(payload_len) {
+        sealed = fido2_data_journal_crypt(store, vault, offset, payload, entry + 3, payload_len);
+    }
+    put_u32(entry + 3 + payload_len, fido2_crc32(entry, 3 + payload_len));
 
-            // Private key
-            snprintf(key, sizeof(key), "PrivKey_%u", (unsigned)saved);
-            if(!flipper_format_write_hex(flipper_format, key, cred->private_key, 32)) {
-                FURI_LOG_E(TAG, "Failed to write private key");
-                goto cleanup;
-            }
+    uint8_t* out = fresh ? buffer : entry;
+    if(fresh) {
+        uint8_t* header = put_u32(buffer, FIDO2_JOURNAL_MAGIC);
+        memcpy(header, store->journal_salt, FIDO2_JOURNAL_SALT_SIZE);
+    }
+    size_t out_len = size - (out - buffer);
 
-            // Public key X
-            snprintf(key, sizeof(key), "PubKeyX_%u", (unsigned)saved);
-            if(!flipper_format_write_hex(flipper_format, key, cred->public_key_x, 32)) {
-                FURI_LOG_E(TAG, "Failed to write public key X");
-                goto cleanup;
-            }
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool success = false;
+    FS_OpenMode mode = fresh ? FSOM_CREATE_ALWAYS : FSOM_OPEN_APPEND;
+    if(sealed && storage_file_open(file, FIDO2_CRED_JOURNAL_FILE, FSAM_WRITE, mode)) {
+        success = storage_file_write(file, out, out_len) == out_len && storage_file_sync(file);
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
 
-            // Public key Y
-            snprintf(key, sizeof(key), "PubKeyY_%u", (unsigned)saved);
-            if(!flipper_format_write_hex(flipper_format, key, cred->public_key_y, 32)) {
-                FURI_LOG_E(TAG, "Failed to write public key Y");
-                goto cleanup;
-            }
+    memset(buffer, 0, size);
+    free(buffer);
 
-            // RP ID
-            snprintf(key, sizeof(key), "RPID_%u", (unsigned)saved);
-            if(!flipper_format_write_string_cstr(flipper_format, key, cred->rp_id)) {
-                FURI_LOG_E(TAG, "Failed to write RP ID");
-                goto cleanup;
-            }
+    if(success) {
+        store->journal_size += out_len;
+    } else {
+        FURI_LOG_E(TAG, "Journal append failed");
+    }
+    return success;
+}
 
-            // User ID
-            snprintf(key, sizeof(key), "UserID_%u", (unsigned)saved);
-            if(!flipper_format_write_hex(flipper_format, key, cred->user_id, cred->user_id_len)) {
-                FURI_LOG_E(TAG, "Failed to write user ID");
-                goto cleanup;
-            }
+/**
+ * @brief Apply one journal entry to the store
+ *
+ * The page file may already hold the entry, so counters never move down.
+ *
+ * @return false if the entry is malformed
+ */
+static bool fido2_data_journal_apply(
+    struct Fido2CredentialStore* store,
+    uint8_t op,
+    const uint8_t* payload,
+    uint16_t payload_len) {
+    switch(op) {
+    case Fido2JournalOpPut: {
+        Fido2Credential cred;
+        if(payload_len != FIDO2_CREDENTIAL_RECORD_SIZE ||
+           !fido2_credential_deserialize(payload, &cred)) {
+            return false;
+        }
+        Fido2Credential* existing = fido2_credential_find_by_id(
+            store, cred.credential_id, sizeof(cred.credential_id));
+        if(existing) {
+            if(existing->sign_count > cred.sign_count) cred.sign_count = existing->sign_count;
+            *existing = cred;
+            fido2_credential_update(store, existing);
+        } else {
+            fido2_credential_import(store, &cred);
+        }
+        memset(&cred, 0, sizeof(cred));
+        return true;
+    }
+    case Fido2JournalOpCounter: {
+        if(payload_len != FIDO2_CREDENTIAL_ID_SIZE + 4) return false;
+        Fido2Credential* cred = fido2_credential_find_by_id(
+            store, payload, FIDO2_CREDENTIAL_ID_SIZE);
+        uint32_t sign_count = get_u32(payload + FIDO2_CREDENTIAL_ID_SIZE);
+        if(cred && sign_count > cred->sign_count) {
+            cred->sign_count = sign_count;
+            cred->sign_count_ceiling = sign_count;
+            fido2_credential_update(store, cred);
+        }
+        return true;
+    }
+    case Fido2JournalOpReset:
+        fido2_credential_reset(store);
+        return payload_len == 0;
+    case Fido2JournalOpDelete:
+        if(payload_len != FIDO2_CREDENTIAL_ID_SIZE) return false;
+        fido2_credential_delete(
+            store, fido2_credential_find_by_id(store, payload, FIDO2_CREDENTIAL_ID_SIZE));
+        return true;
+    default:
+        return false;
+    }
+}
 
-            // User ID length
-            snprintf(key, sizeof(key), "UserIDLen_%u", (unsigned)saved);
-            uint32_t len = cred->user_id_len;
-            if(!flipper_format_write_uint32(flipper_format, key, &len, 1)) {
-                FURI_LOG_E(TAG, "Failed to write user ID length");
-                goto cleanup;
-            }
+/**
+ * @brief Replay the journal on top of the page file
+ *
+ * @return true if the journal ends in a torn or corrupt entry, where replay
+ * stops, and must be compacted before anything is appended behind it
+ */
+static bool fido2_data_journal_replay(struct Fido2CredentialStore* store, Storage* storage) {
+    File* file = storage_file_alloc(storage);
+    uint8_t* entry = malloc(FIDO2_JOURNAL_ENTRY_OVERHEAD + FIDO2_JOURNAL_MAX_PAYLOAD);
+    uint32_t replayed = 0;
+    bool torn = false;
+    const Fido2Vault* vault = fido2_page_store_vault(store->pages);
+    store->journal_size = 0;
+
+    do {
+        if(!storage_file_open(file, FIDO2_CRED_JOURNAL_FILE, FSAM_READ, FSOM_OPEN_EXISTING)) {
+            break;
+        }
 
-            // User name
-            snprintf(key, sizeof(key), "UserName_%u", (unsigned)saved);
-            if(!flipper_format_write_string_cstr(flipper_format, key, cred->user_name)) {
-                FURI_LOG_E(TAG, "Failed to write user name");
-                goto cleanup;
+        // Sealed entries need the vault keys and the salt of the journal
+        uint8_t header[FIDO2_JOURNAL_HEADER_SIZE];
+        if(storage_file_read(file, header, sizeof(header)) != sizeof(header) ||
+           get_u32(header) != FIDO2_JOURNAL_MAGIC || !vault) {
+            torn = true;
+            break;
+        }
+        size_t journal_size = FIDO2_JOURNAL_HEADER_SIZE;
+        memcpy(store->journal_salt, header + 4, FIDO2_JOURNAL_SALT_SIZE);
+
+        while(true) {
+            size_t read = storage_file_read(file, entry, 3);
+            if(read == 0) break;
+            uint16_t payload_len = entry[1] | (entry[2] << 8);
+            size_t rest = payload_len + 4;
+            if(read != 3 || payload_len > FIDO2_JOURNAL_MAX_PAYLOAD ||
+               storage_file_read(file, entry + 3, rest) != rest ||
+               get_u32(entry + 3 + payload_len) != fido2_crc32(entry, 3 + payload_len) ||
+               (payload_len &&
+                !fido2_data_journal_crypt(
+                    store, vault, journal_size, entry + 3, entry + 3, payload_len)) ||
+               !fido2_data_journal_apply(store, entry[0], entry + 3, payload_len)) {
+                torn = true;
+                break;
             }
+            journal_size += FIDO2_JOURNAL_ENTRY_OVERHEAD + payload_len;
+            replayed++;
+        }
+        store->journal_size = journal_size;
+    } while(false);
 
-            // User display name
-            snprintf(key, sizeof(key), "UserDisplay_%u", (unsigned)saved);
-            if(!flipper_format_write_string_cstr(flipper_format, key, cred->user_display_name)) {
-                FURI_LOG_E(TAG, "Failed to write user display name");
-                goto cleanup;
-            }
+    memset(entry, 0, FIDO2_JOURNAL_ENTRY_OVERHEAD + FIDO2_JOURNAL_MAX_PAYLOAD);
+    free(entry);
+    storage_file_close(file);
+    storage_file_free(file);
 
-            // Signature counter
-            snprintf(key, sizeof(key), "SignCount_%u", (unsigned)saved);
-            if(!flipper_format_write_uint32(flipper_format, key, &cred->sign_count, 1)) {
-                FURI_LOG_E(TAG, "Failed to write signature counter");
-                goto cleanup;
-            }
+    if(replayed || torn) {
+        FURI_LOG_I(TAG, "Replayed %lu journal entries%s", replayed, torn ? ", torn tail" : "");
+    }
+    return torn;
+}
 
-            saved++;
-        }
+bool fido2_data_log_put(void* credentials, const Fido2Credential* cred) {
+    struct Fido2CredentialStore* store = (struct Fido2CredentialStore*)credentials;
+    if(!store || !cred) return false;
 
-        success = (saved == count);
-        FURI_LOG_I(TAG, "Saved %lu/%lu credentials", saved, count);
-        
-        snprintf(count_msg, sizeof(count_msg), "Saved %lu/%lu", saved, count);
-        debug_log(count_msg);
-    } else {
-        FURI_LOG_E(TAG, "Failed to open file for writing");
-        debug_log("Failed to open file for writing");
-    }
+    uint8_t record[FIDO2_CREDENTIAL_RECORD_SIZE];
+    fido2_credential_serialize(cred, record);
+    bool ok = fido2_data_journal_append(store, Fido2JournalOpPut, record, sizeof(record));
+    memset(record, 0, sizeof(record));
+    return ok;
+}
 
-cleanup:
-    flipper_format_free(flipper_format);
-    furi_record_close(RECORD_STORAGE);
+bool fido2_data_log_counter(void* credentials, const Fido2Credential* cred) {
+    struct Fido2CredentialStore* store = (struct Fido2CredentialStore*)credentials;
+    if(!store || !cred) return false;
 
-    if(success) {
-        FURI_LOG_I(TAG, "fido2_data_save_credentials - SUCCESS");
-        debug_log("fido2_data_save_credentials - SUCCESS");
-    } else {
-        FURI_LOG_E(TAG, "fido2_data_save_credentials - FAILED");
-        debug_log("fido2_data_save_credentials - FAILED");
+    uint8_t payload[FIDO2_CREDENTIAL_ID_SIZE + 4];
+    memcpy(payload, cred->credential_id, FIDO2_CREDENTIAL_ID_SIZE);
+    put_u32(payload + FIDO2_CREDENTIAL_ID_SIZE, fido2_credential_persisted_sign_count(cred));
+    if(!fido2_data_journal_append(store, Fido2JournalOpCounter, payload, sizeof(payload))) {
+        return false;
     }
+    // The raised ceiling reaches the page file with the next write-back
+    fido2_credential_update(store, cred);
+    return true;
+}
 
-    return success;
+bool fido2_data_log_delete(void* credentials, const uint8_t* credential_id) {
+    struct Fido2CredentialStore* store = (struct Fido2CredentialStore*)credentials;
+    if(!store || !credential_id) return false;
+    return fido2_data_journal_append(
+        store, Fido2JournalOpDelete, credential_id, FIDO2_CREDENTIAL_ID_SIZE);
 }
 
-bool fido2_data_load_credentials(void* credentials) {
+bool fido2_data_log_reset(void* credentials) {
     struct Fido2CredentialStore* store = (struct Fido2CredentialStore*)credentials;
     if(!store) return false;
+    return fido2_data_journal_append(store, Fido2JournalOpReset, NULL, 0);
+}
 
-    FURI_LOG_I(TAG, "fido2_data_load_credentials - START");
-    debug_log("fido2_data_load_credentials - START");
+bool fido2_data_rekey(void* credentials) {
+    struct Fido2CredentialStore* store = (struct Fido2CredentialStore*)credentials;
+    if(!store || store->journal_size) return false;
+    return fido2_page_store_rekey(store->pages);
+}
 
-    // Clear existing credentials
-    for(size_t i = 0; i < FIDO2_MAX_CREDENTIALS; i++) {
-        memset(&store->credentials[i], 0, sizeof(Fido2Credential));
-    }
+bool fido2_data_needs_compaction(void* credentials) {
+    struct Fido2CredentialStore* store = (struct Fido2CredentialStore*)credentials;
+    return store && store->journal_size >= FIDO2_JOURNAL_COMPACT_SIZE;
+}
 
-    Storage* storage = furi_record_open(RECORD_STORAGE);
+/**
+ * @brief Load a FlipperFormat text credential file (versions 1 and 2)
+ */
+static bool fido2_data_load_legacy(struct Fido2CredentialStore* store, Storage* storage) {
     FlipperFormat* flipper_format = flipper_format_file_alloc(storage);
     FuriString* filetype = furi_string_alloc();
 
     bool success = false;
     uint32_t version = 0;
     uint32_t count = 0;
+    uint32_t loaded = 0;
+    Fido2Credential* cred = malloc(sizeof(Fido2Credential));
 
-    if(flipper_format_file_open_existing(flipper_format, FIDO2_CRED_FILE)) {
+    if(flipper_format_file_open_existing(flipper_format, FIDO2_CRED_LEGACY_FILE)) {
         // Read header
         if(!flipper_format_read_header(flipper_format, filetype, &version)) {
             FURI_LOG_E(TAG, "Missing or incorrect header");
@@ -290,7 +458,7 @@ bool fido2_data_load_credentials(void* credentials) {
         }
 
         if(strcmp(furi_string_get_cstr(filetype), FIDO2_CRED_FILE_TYPE) != 0 ||
-           version != FIDO2_CRED_VERSION) {
+           (version != FIDO2_CRED_VERSION_V2 && version != FIDO2_CRED_VERSION_V1)) {
             FURI_LOG_E(TAG, "Type or version mismatch");
             debug_log("Type or version mismatch");
             goto cleanup;
@@ -309,9 +477,8 @@ bool fido2_data_load_credentials(void* credentials) {
         }
 
         // Read each credential
-        uint32_t loaded = 0;
         for(uint32_t i = 0; i < count; i++) {
-            Fido2Credential* cred = &store->credentials[i];
+            memset(cred, 0, sizeof(Fido2Credential));
             char key[32];
 
             // Credential ID
@@ -351,10 +518,13 @@ bool fido2_data_load_credentials(void* credentials) {
             strncpy(cred->rp_id, furi_string_get_cstr(filetype), sizeof(cred->rp_id) - 1);
             cred->rp_id[sizeof(cred->rp_id) - 1] = '\0';
 
-            // User ID
+            // User ID, as many bytes as were saved: a short line fails a longer read
             snprintf(key, sizeof(key), "UserID_%u", (unsigned)i);
             uint8_t user_id_buf[64];
-            if(!flipper_format_read_hex(flipper_format, key, user_id_buf, 64)) {
+            uint32_t user_id_size = 0;
+            if(!flipper_format_get_value_count(flipper_format, key, &user_id_size) ||
+               user_id_size > sizeof(user_id_buf) ||
+               !flipper_format_read_hex(flipper_format, key, user_id_buf, user_id_size)) {
                 FURI_LOG_E(TAG, "Failed to read user ID");
                 goto cleanup;
             }
@@ -366,7 +536,7 @@ bool fido2_data_load_credentials(void* credentials) {
                 FURI_LOG_E(TAG, "Failed to read user ID length");
                 goto cleanup;
             }
-            cred->user_id_len = (len <= 64) ? len : 64;
+            cred->user_id_len = (len <= user_id_size) ? len : user_id_size;
             memcpy(cred->user_id, user_id_buf, cred->user_id_len);
 
             // User name
@@ -395,34 +565,124 @@ bool fido2_data_load_credentials(void* credentials) {
                 goto cleanup;
             }
 
-            cred->valid = true;
+            // COSE algorithm (version 1 files only hold ES256 credentials)
+            cred->algorithm = COSE_ALG_ECDSA_WITH_SHA256;
+            if(version >= FIDO2_CRED_VERSION_V2) {
+                snprintf(key, sizeof(key), "Alg_%u", (unsigned)i);
+                if(!flipper_format_read_int32(flipper_format, key, &cred->algorithm, 1)) {
+                    FURI_LOG_E(TAG, "Failed to read algorithm");
+                    goto cleanup;
+                }
+            }
+
+            if(!fido2_credential_import(store, cred)) goto cleanup;
             loaded++;
         }
 
         success = (loaded == count);
-        FURI_LOG_I(TAG, "Loaded %lu credentials", loaded);
-        
-        char load_msg[32];
-        snprintf(load_msg, sizeof(load_msg), "Loaded %lu credentials", loaded);
-        debug_log(load_msg);
-    } else {
-        FURI_LOG_I(TAG, "No existing credentials file, starting fresh");
-        debug_log("No existing credentials, starting fresh");
-        success = true; // Not an error if file doesn't exist
+        FURI_LOG_I(TAG, "Loaded %lu legacy credentials (version %lu)", loaded, version);
     }
 
 cleanup:
+    if(!success && loaded) fido2_credential_reset(store);
+    memset(cred, 0, sizeof(Fido2Credential));
+    free(cred);
     furi_string_free(filetype);
     flipper_format_free(flipper_format);
+    return success;
+}
+
+/**
+ * @brief Drop the page file a failed conversion was writing to
+ *
+ * The store is left detached, so new credentials fail instead of going to
+ * a file the retry at the next load throws away.
+ */
+static void fido2_data_detach(struct Fido2CredentialStore* store) {
+    fido2_page_store_free(store->pages);
+    store->pages = fido2_page_store_alloc();
+}
+
+/**
+ * @brief Build the page file from the FlipperFormat text file
+ *
+ * The page file is built under a temporary name and only renamed once it is
+ * complete, so an interrupted migration restarts from the text file.
+ */
+static bool fido2_data_migrate(struct Fido2CredentialStore* store, Storage* storage) {
+    storage_simply_remove(storage, FIDO2_PAGE_TEMP_FILE);
+    if(!fido2_page_store_open(store->pages, FIDO2_PAGE_TEMP_FILE, NULL, NULL)) return false;
+
+    if(!fido2_data_load_legacy(store, storage)) {
+        FURI_LOG_E(TAG, "Failed to read the text credential file");
+        fido2_data_detach(store);
+        return false;
+    }
+    if(!fido2_page_store_rename(store->pages, FIDO2_PAGE_FILE)) {
+        FURI_LOG_E(TAG, "Failed to write the page file");
+        fido2_data_detach(store);
+        return false;
+    }
+    storage_simply_remove(storage, FIDO2_CRED_LEGACY_FILE);
+    FURI_LOG_I(TAG, "Migrated %u credentials to the page file", fido2_credential_count(store));
+    return true;
+}
+
+bool fido2_data_load_credentials(void* credentials) {
+    struct Fido2CredentialStore* store = (struct Fido2CredentialStore*)credentials;
+    if(!store) return false;
+
+    debug_log("fido2_data_load_credentials - START");
+    uint32_t start = furi_get_tick();
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    bool success = false;
+    bool compact = false;
+    store->journal_size = 0;
+
+    // Finish a replacement of the page file interrupted between remove and rename
+    if(storage_common_stat(storage, FIDO2_PAGE_FILE, NULL) != FSE_OK &&
+       storage_common_stat(storage, FIDO2_PAGE_TEMP_FILE, NULL) == FSE_OK &&
+       storage_common_stat(storage, FIDO2_CRED_LEGACY_FILE, NULL) != FSE_OK) {
+        storage_common_rename(storage, FIDO2_PAGE_TEMP_FILE, FIDO2_PAGE_FILE);
+    }
+
+    if(storage_common_stat(storage, FIDO2_PAGE_FILE, NULL) == FSE_OK) {
+        success = fido2_page_store_open(
+            store->pages, FIDO2_PAGE_FILE, FIDO2_PAGE_INDEX_FILE, FIDO2_PAGE_TEMP_FILE);
+        if(success) {
+            compact = fido2_data_journal_replay(store, storage);
+            // Left over from a migration interrupted after the rename
+            storage_simply_remove(storage, FIDO2_CRED_LEGACY_FILE);
+            storage_simply_remove(storage, FIDO2_PAGE_TEMP_FILE);
+        }
+    } else {
+        // A journal without its page file cannot be decrypted any more
+        storage_simply_remove(storage, FIDO2_CRED_JOURNAL_FILE);
+        if(storage_common_stat(storage, FIDO2_CRED_LEGACY_FILE, NULL) == FSE_OK) {
+            success = fido2_data_migrate(store, storage);
+        } else {
+            // Not an error if no file exists; an empty page file is created
+            success = fido2_page_store_open(
+                store->pages, FIDO2_PAGE_FILE, FIDO2_PAGE_INDEX_FILE, FIDO2_PAGE_TEMP_FILE);
+        }
+    }
+
     furi_record_close(RECORD_STORAGE);
 
     if(success) {
-        FURI_LOG_I(TAG, "fido2_data_load_credentials - SUCCESS");
+        FURI_LOG_I(
+            TAG, "fido2_data_load_credentials - SUCCESS in %lu ms", furi_get_tick() - start);
         debug_log("fido2_data_load_credentials - SUCCESS");
     } else {
         FURI_LOG_E(TAG, "fido2_data_load_credentials - FAILED");
         debug_log("fido2_data_load_credentials - FAILED");
     }
 
+    // New entries must not land behind a torn one, where replay would never reach them
+    if(compact && !fido2_data_save_credentials(store)) {
+        FURI_LOG_E(TAG, "Failed to compact torn journal");
+    }
+
     return success;
-}
\ No newline at end of file
+}
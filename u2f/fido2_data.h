@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "fido2_credential.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,9 +11,17 @@ extern "C" {
 
 // Use existing U2F folder instead of creating a new one
 #define FIDO2_DATA_FOLDER EXT_PATH("u2f/")
-#define FIDO2_CRED_FILE   FIDO2_DATA_FOLDER "fido2_credentials.dat"
+#define FIDO2_PAGE_FILE       FIDO2_DATA_FOLDER "fido2_pages.bin"
+#define FIDO2_PAGE_TEMP_FILE  FIDO2_DATA_FOLDER "fido2_pages.tmp" // built during migration
+#define FIDO2_PAGE_INDEX_FILE FIDO2_DATA_FOLDER "fido2_pages.idx" // page table of the page file
+#define FIDO2_CRED_JOURNAL_FILE FIDO2_DATA_FOLDER "fido2_credentials.log"
+// Earlier versions, only read to migrate them to the page file
+#define FIDO2_CRED_LEGACY_FILE FIDO2_DATA_FOLDER "fido2_credentials.dat" // FlipperFormat text
 #define FIDO2_CNT_FILE    FIDO2_DATA_FOLDER "fido2_counters.dat"
 
+// Journal size at which the page file is brought up to date and the journal dropped
+#define FIDO2_JOURNAL_COMPACT_SIZE 4096
+
 /**
  * @brief Initialize FIDO2 data storage
  * 
@@ -21,7 +30,9 @@ extern "C" {
 bool fido2_data_init(void);
 
 /**
- * @brief Save credentials to persistent storage
+ * @brief Write back all changed credential pages and drop the journal
+ *
+ * Used for compaction, bulk changes and the clean save at exit.
  * 
  * @param credentials Credential store
  * @return true if successful
@@ -29,13 +40,60 @@ bool fido2_data_init(void);
 bool fido2_data_save_credentials(void* credentials);
 
 /**
- * @brief Load credentials from persistent storage
+ * @brief Attach the credential store to its page file
+ *
+ * Reads the page index, or the page headers if the index is stale, then
+ * replays the journal on top of them. No record is read at this point. A
+ * missing page file is created with new vault keys. The FlipperFormat text
+ * file of earlier versions is converted to a page file on first load.
  * 
  * @param credentials Credential store to fill
  * @return true if successful
  */
 bool fido2_data_load_credentials(void* credentials);
 
+/**
+ * @brief Durably record a new credential in the journal
+ *
+ * Appends one record, encrypted with the vault keys of the page file, and
+ * syncs it, so the credential survives a crash or
+ * unplug right away.
+ */
+bool fido2_data_log_put(void* credentials, const Fido2Credential* cred);
+
+/**
+ * @brief Durably record the persisted signature counter of a credential
+ */
+bool fido2_data_log_counter(void* credentials, const Fido2Credential* cred);
+
+/**
+ * @brief Durably record that one credential was deleted
+ *
+ * Call before deleting it from the store, as the id is read from there.
+ */
+bool fido2_data_log_delete(void* credentials, const uint8_t* credential_id);
+
+/**
+ * @brief Durably record that all credentials were deleted
+ */
+bool fido2_data_log_reset(void* credentials);
+
+/**
+ * @brief Replace the vault keys of an emptied store
+ *
+ * Credentials written before can no longer be decrypted, even from a copy
+ * of the card. Save first, so no journal under the old keys is left.
+ *
+ * @return false if the store still holds credentials or a journal, or the
+ * new page file could not be written
+ */
+bool fido2_data_rekey(void* credentials);
+
+/**
+ * @brief Check whether the journal has grown past FIDO2_JOURNAL_COMPACT_SIZE
+ */
+bool fido2_data_needs_compaction(void* credentials);
+
 /**
  * @brief Check if FIDO2 data files exist
  * 
@@ -0,0 +1,540 @@
+#include "fido2_ed25519.h"
+#include <string.h>
+
+/*
+ * Compact Ed25519 for Cortex-M.
+ *
+ * Field elements are 8 x 32-bit little-endian limbs, kept loosely reduced
+ * in [0, 2^256) and only fully reduced when encoded. Every routine that
+ * touches secret data runs a fixed instruction sequence: no branches or
+ * table lookups depend on the seed or on the nonce.
+ */
+
+typedef uint32_t Fe[8];
+
+typedef struct {
+    Fe x;
+    Fe y;
+    Fe z;
+    Fe t;
+} Ed25519Point;
+
+// 2 * d, where d = -121665 / 121666 mod p
+static const Fe ed25519_d2 = {
+    0x26b2f159,
+    0xebd69b94,
+    0x8283b156,
+    0x00e0149a,
+    0xeef3d130,
+    0x198e80f2,
+    0x56dffce7,
+    0x2406d9dc};
+
+static const Fe ed25519_base_x = {
+    0x8f25d51a,
+    0xc9562d60,
+    0x9525a7b2,
+    0x692cc760,
+    0xfdd6dc5c,
+    0xc0a4e231,
+    0xcd6e53fe,
+    0x216936d3};
+
+static const Fe ed25519_base_y = {
+    0x66666658,
+    0x66666666,
+    0x66666666,
+    0x66666666,
+    0x66666666,
+    0x66666666,
+    0x66666666,
+    0x66666666};
+
+static const Fe ed25519_base_t = {
+    0xa5b7dda3,
+    0x6dde8ab3,
+    0x775152f5,
+    0x20f09f80,
+    0x64abe37d,
+    0x66ea4e8e,
+    0xd78b7665,
+    0x67875f0f};
+
+// p = 2^255 - 19
+static const Fe ed25519_p = {
+    0xffffffed,
+    0xffffffff,
+    0xffffffff,
+    0xffffffff,
+    0xffffffff,
+    0xffffffff,
+    0xffffffff,
+    0x7fffffff};
+
+// ============================================================================
+// FIELD ARITHMETIC MOD 2^255 - 19
+// ============================================================================
+
+static void fe_copy(Fe r, const Fe a) {
+    memcpy(r, a, sizeof(Fe));
+}
+
+static void fe_set(Fe r, uint32_t v) {
+    memset(r, 0, sizeof(Fe));
+    r[0] = v;
+}
+
+// Fold a carry out of bit 256 back in: 2^256 = 38 mod p
+static void fe_fold(Fe r, uint32_t carry) {
+    for(int pass = 0; pass < 2; pass++) {
+        uint64_t acc = (uint64_t)carry * 38;
+        for(int i = 0; i < 8; i++) {
+            acc += r[i];
+            r[i] = (uint32_t)acc;
+            acc >>= 32;
+        }
+        carry = (uint32_t)acc;
+    }
+}
+
+static void fe_add(Fe r, const Fe a, const Fe b) {
+    uint64_t acc = 0;
+    for(int i = 0; i < 8; i++) {
+        acc += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    fe_fold(r, (uint32_t)acc);
+}
+
+static void fe_sub(Fe r, const Fe a, const Fe b) {
+    int64_t acc = 0;
+    for(int i = 0; i < 8; i++) {
+        acc += (int64_t)a[i] - b[i];
+        r[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    // Borrow out of bit 256 is worth -38; it can repeat at most once
+    for(int pass = 0; pass < 2; pass++) {
+        uint32_t borrow = (uint32_t)(-acc);
+        acc = -(int64_t)(borrow * 38);
+        for(int i = 0; i < 8; i++) {
+            acc += r[i];
+            r[i] = (uint32_t)acc;
+            acc >>= 32;
+        }
+    }
+}
+
+static void fe_mul(Fe r, const Fe a, const Fe b) {
+    uint32_t t[16] = {0};
+
+    for(int i = 0; i < 8; i++) {
+        uint64_t carry = 0;
+        for(int j = 0; j < 8; j++) {
+            carry += (uint64_t)a[i] * b[j] + t[i + j];
+            t[i + j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        t[i + 8] = (uint32_t)carry;
+    }
+
+    uint64_t acc = 0;
+    for(int i = 0; i < 8; i++) {
+        acc += (uint64_t)t[i + 8] * 38 + t[i];
+        r[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    fe_fold(r, (uint32_t)acc);
+}
+
+static void fe_sq(Fe r, const Fe a) {
+    fe_mul(r, a, a);
+}
+
+// r = a^(p - 2); the exponent is public so the ladder shape is fixed
+static void fe_invert(Fe r, const Fe a) {
+    Fe c;
+    fe_copy(c, a);
+    for(int i = 253; i >= 0; i--) {
+        fe_sq(c, c);
+        if(i != 2 && i != 4) fe_mul(c, c, a);
+    }
+    fe_copy(r, c);
+}
+
+// Conditionally subtract p without branching on the value
+static void fe_reduce_once(Fe r) {
+    Fe t;
+    int64_t acc = 0;
+    for(int i = 0; i < 8; i++) {
+        acc += (int64_t)r[i] - ed25519_p[i];
+        t[i] = (uint32_t)acc;
+        acc >>= 32;
+    }
+    // mask is all ones when r >= p (no borrow)
+    uint32_t mask = (uint32_t)acc + 1;
+    mask = 0U - mask;
+    for(int i = 0; i < 8; i++) {
+        r[i] = (t[i] & mask) | (r[i] & ~mask);
+    }
+}
+
+static void fe_to_bytes(uint8_t* out, const Fe a) {
+    Fe t;
+    fe_copy(t, a);
+    fe_reduce_once(t);
+    fe_reduce_once(t);
+    for(int i = 0; i < 8; i++) {
+        out[4 * i + 0] = (uint8_t)(t[i]);
+        out[4 * i + 1] = (uint8_t)(t[i] >> 8);
+        out[4 * i + 2] = (uint8_t)(t[i] >> 16);
+        out[4 * i + 3] = (uint8_t)(t[i] >> 24);
+    }
+}
+
+static void fe_cswap(Fe a, Fe b, uint32_t bit) {
+    uint32_t mask = 0U - bit;
+    for(int i = 0; i < 8; i++) {
+        uint32_t x = (a[i] ^ b[i]) & mask;
+        a[i] ^= x;
+        b[i] ^= x;
+    }
+}
+
+// ============================================================================
+// GROUP OPERATIONS (TWISTED EDWARDS, EXTENDED COORDINATES)
+// ============================================================================
+
+// Unified addition; also valid for doubling
+static void point_add(Ed25519Point* p, const Ed25519Point* q) {
+    Fe a, b, c, d, e, f, g, h, t;
+
+    fe_sub(a, p->y, p->x);
+    fe_sub(t, q->y, q->x);
+    fe_mul(a, a, t);
+    fe_add(b, p->x, p->y);
+    fe_add(t, q->x, q->y);
+    fe_mul(b, b, t);
+    fe_mul(c, p->t, q->t);
+    fe_mul(c, c, ed25519_d2);
+    fe_mul(d, p->z, q->z);
+    fe_add(d, d, d);
+    fe_sub(e, b, a);
+    fe_sub(f, d, c);
+    fe_add(g, d, c);
+    fe_add(h, b, a);
+
+    fe_mul(p->x, e, f);
+    fe_mul(p->y, h, g);
+    fe_mul(p->z, g, f);
+    fe_mul(p->t, e, h);
+}
+
+static void point_cswap(Ed25519Point* p, Ed25519Point* q, uint32_t bit) {
+    fe_cswap(p->x, q->x, bit);
+    fe_cswap(p->y, q->y, bit);
+    fe_cswap(p->z, q->z, bit);
+    fe_cswap(p->t, q->t, bit);
+}
+
+static void point_encode(uint8_t* out, const Ed25519Point* p) {
+    Fe zi, x, y;
+    uint8_t x_bytes[32];
+
+    fe_invert(zi, p->z);
+    fe_mul(x, p->x, zi);
+    fe_mul(y, p->y, zi);
+    fe_to_bytes(out, y);
+    fe_to_bytes(x_bytes, x);
+    out[31] ^= (x_bytes[0] & 1) << 7;
+}
+
+// r = s * B, ladder over all 256 bits of the scalar
+static void point_mul_base(Ed25519Point* r, const uint8_t* scalar) {
+    Ed25519Point q;
+
+    fe_set(r->x, 0);
+    fe_set(r->y, 1);
+    fe_set(r->z, 1);
+    fe_set(r->t, 0);
+
+    fe_copy(q.x, ed25519_base_x);
+    fe_copy(q.y, ed25519_base_y);
+    fe_set(q.z, 1);
+    fe_copy(q.t, ed25519_base_t);
+
+    for(int i = 255; i >= 0; i--) {
+        uint32_t bit = (scalar[i / 8] >> (i & 7)) & 1;
+        point_cswap(r, &q, bit);
+        point_add(&q, r);
+        point_add(r, r);
+        point_cswap(r, &q, bit);
+    }
+
+    memset(&q, 0, sizeof(q));
+}
+
+// ============================================================================
+// SCALAR ARITHMETIC MOD L = 2^252 + 27742317777372353535851937790883648493
+// ============================================================================
+
+static const int64_t ed25519_l[32] = {
+    0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7,
+    0xa2, 0xde, 0xf9, 0xde, 0x14, 0,    0,    0,    0,    0,    0,
+    0,    0,    0,    0,    0,    0,    0,    0,    0,    0x10};
+
+// Reduce a 512-bit little-endian value held in 64 signed radix-2^8 digits
+static void sc_reduce_digits(uint8_t* r, int64_t* x) {
+    int64_t carry;
+    int i, j;
+
+    for(i = 63; i >= 32; --i) {
+        carry = 0;
+        for(j = i - 32; j < i - 12; ++j) {
+            x[j] += carry - 16 * x[i] * ed25519_l[j - (i - 32)];
+            carry = (x[j] + 128) >> 8;
+            x[j] -= carry * 256;
+        }
+        x[j] += carry;
+        x[i] = 0;
+    }
+
+    carry = 0;
+    for(j = 0; j < 32; j++) {
+        x[j] += carry - (x[31] >> 4) * ed25519_l[j];
+        carry = x[j] >> 8;
+        x[j] &= 255;
+    }
+    for(j = 0; j < 32; j++) {
+        x[j] -= carry * ed25519_l[j];
+    }
+    for(i = 0; i < 32; i++) {
+        x[i + 1] += x[i] >> 8;
+        r[i] = (uint8_t)(x[i] & 255);
+    }
+}
+
+// r = h mod L, for a 64-byte hash output
+static void sc_reduce(uint8_t* r, const uint8_t* h) {
+    int64_t x[64];
+    for(int i = 0; i < 64; i++) x[i] = h[i];
+    sc_reduce_digits(r, x);
+    memset(x, 0, sizeof(x));
+}
+
+// r = (a + k * s) mod L
+static void sc_muladd(uint8_t* r, const uint8_t* a, const uint8_t* k, const uint8_t* s) {
+    int64_t x[64] = {0};
+    for(int i = 0; i < 32; i++) x[i] = a[i];
+    for(int i = 0; i < 32; i++) {
+        for(int j = 0; j < 32; j++) {
+            x[i + j] += (int64_t)k[i] * s[j];
+        }
+    }
+    sc_reduce_digits(r, x);
+    memset(x, 0, sizeof(x));
+}
+
+// ============================================================================
+// SHA-512
+// ============================================================================
+
+typedef struct {
+    uint64_t state[8];
+    uint64_t total;
+    uint8_t buffer[128];
+    size_t used;
+} Sha512;
+
+static const uint64_t sha512_k[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+    0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+    0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+    0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+    0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+    0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+    0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+    0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+    0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+    0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+    0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+    0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+    0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+    0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+#define SHA512_ROTR(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+static void sha512_block(Sha512* ctx, const uint8_t* block) {
+    uint64_t w[16];
+    uint64_t s[8];
+
+    for(int i = 0; i < 16; i++) {
+        w[i] = 0;
+        for(int j = 0; j < 8; j++) {
+            w[i] = (w[i] << 8) | block[8 * i + j];
+        }
+    }
+    memcpy(s, ctx->state, sizeof(s));
+
+    for(int i = 0; i < 80; i++) {
+        if(i >= 16) {
+            uint64_t w15 = w[(i - 15) & 15];
+            uint64_t w2 = w[(i - 2) & 15];
+            uint64_t s0 = SHA512_ROTR(w15, 1) ^ SHA512_ROTR(w15, 8) ^ (w15 >> 7);
+            uint64_t s1 = SHA512_ROTR(w2, 19) ^ SHA512_ROTR(w2, 61) ^ (w2 >> 6);
+            w[i & 15] += s0 + s1 + w[(i - 7) & 15];
+        }
+        uint64_t e = s[4];
+        uint64_t a = s[0];
+        uint64_t t1 = s[7] + (SHA512_ROTR(e, 14) ^ SHA512_ROTR(e, 18) ^ SHA512_ROTR(e, 41)) +
+                      ((e & s[5]) ^ (~e & s[6])) + sha512_k[i] + w[i & 15];
+        uint64_t t2 = (SHA512_ROTR(a, 28) ^ SHA512_ROTR(a, 34) ^ SHA512_ROTR(a, 39)) +
+                      ((a & s[1]) ^ (a & s[2]) ^ (s[1] & s[2]));
+        s[7] = s[6];
+        s[6] = s[5];
+        s[5] = s[4];
+        s[4] = s[3] + t1;
+        s[3] = s[2];
+        s[2] = s[1];
+        s[1] = s[0];
+        s[0] = t1 + t2;
+    }
+
+    for(int i = 0; i < 8; i++) ctx->state[i] += s[i];
+}
+
+static void sha512_init(Sha512* ctx) {
+    static const uint64_t iv[8] = {
+        0x6a09e667f3bcc908ULL,
+        0xbb67ae8584caa73bULL,
+        0x3c6ef372fe94f82bULL,
+        0xa54ff53a5f1d36f1ULL,
+        0x510e527fade682d1ULL,
+        0x9b05688c2b3e6c1fULL,
+        0x1f83d9abfb41bd6bULL,
+        0x5be0cd19137e2179ULL};
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->total = 0;
+    ctx->used = 0;
+}
+
+static void sha512_update(Sha512* ctx, const uint8_t* data, size_t len) {
+    ctx->total += len;
+    while(len > 0) {
+        size_t n = sizeof(ctx->buffer) - ctx->used;
+        if(n > len) n = len;
+        memcpy(ctx->buffer + ctx->used, data, n);
+        ctx->used += n;
+        data += n;
+        len -= n;
+        if(ctx->used == sizeof(ctx->buffer)) {
+            sha512_block(ctx, ctx->buffer);
+            ctx->used = 0;
+        }
+    }
+}
+
+static void sha512_finish(Sha512* ctx, uint8_t* out) {
+    uint64_t bits = ctx->total * 8;
+
+    ctx->buffer[ctx->used++] = 0x80;
+    if(ctx->used > 112) {
+        memset(ctx->buffer + ctx->used, 0, sizeof(ctx->buffer) - ctx->used);
+        sha512_block(ctx, ctx->buffer);
+        ctx->used = 0;
+    }
+    memset(ctx->buffer + ctx->used, 0, 120 - ctx->used);
+    for(int i = 0; i < 8; i++) {
+        ctx->buffer[120 + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    sha512_block(ctx, ctx->buffer);
+
+    for(int i = 0; i < 8; i++) {
+        for(int j = 0; j < 8; j++) {
+            out[8 * i + j] = (uint8_t)(ctx->state[i] >> (56 - 8 * j));
+        }
+    }
+    memset(ctx, 0, sizeof(Sha512));
+}
+
+// ============================================================================
+// ED25519
+// ============================================================================
+
+static void ed25519_expand_seed(const uint8_t* seed, uint8_t* expanded) {
+    Sha512 sha;
+    sha512_init(&sha);
+    sha512_update(&sha, seed, FIDO2_ED25519_SEED_SIZE);
+    sha512_finish(&sha, expanded);
+
+    expanded[0] &= 248;
+    expanded[31] &= 127;
+    expanded[31] |= 64;
+}
+
+void fido2_ed25519_public_key(const uint8_t* seed, uint8_t* public_key) {
+    uint8_t expanded[64];
+    Ed25519Point a;
+
+    ed25519_expand_seed(seed, expanded);
+    point_mul_base(&a, expanded);
+    point_encode(public_key, &a);
+
+    memset(expanded, 0, sizeof(expanded));
+    memset(&a, 0, sizeof(a));
+}
+
+void fido2_ed25519_sign(
+    const uint8_t* seed,
+    const uint8_t* public_key,
+    const uint8_t* msg,
+    size_t msg_len,
+    const uint8_t* msg_tail,
+    size_t msg_tail_len,
+    uint8_t* signature) {
+    uint8_t expanded[64];
+    uint8_t nonce[64];
+    uint8_t hram[64];
+    uint8_t r[32];
+    uint8_t k[32];
+    Ed25519Point big_r;
+    Sha512 sha;
+
+    ed25519_expand_seed(seed, expanded);
+
+    // r = H(prefix || M) mod L, with M = msg || msg_tail
+    sha512_init(&sha);
+    sha512_update(&sha, expanded + 32, 32);
+    sha512_update(&sha, msg, msg_len);
+    sha512_update(&sha, msg_tail, msg_tail_len);
+    sha512_finish(&sha, nonce);
+    sc_reduce(r, nonce);
+
+    // R = r * B
+    point_mul_base(&big_r, r);
+    point_encode(signature, &big_r);
+
+    // k = H(R || A || M) mod L
+    sha512_init(&sha);
+    sha512_update(&sha, signature, 32);
+    sha512_update(&sha, public_key, FIDO2_ED25519_PUBLIC_KEY_SIZE);
+    sha512_update(&sha, msg, msg_len);
+    sha512_update(&sha, msg_tail, msg_tail_len);
+    sha512_finish(&sha, hram);
+    sc_reduce(k, hram);
+
+    // S = (r + k * a) mod L
+    sc_muladd(signature + 32, r, k, expanded);
+
+    memset(expanded, 0, sizeof(expanded));
+    memset(nonce, 0, sizeof(nonce));
+    memset(r, 0, sizeof(r));
+    memset(&big_r, 0, sizeof(big_r));
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIDO2_ED25519_SEED_SIZE       32
+#define FIDO2_ED25519_PUBLIC_KEY_SIZE 32
+#define FIDO2_ED25519_SIGNATURE_SIZE  64
+
+/**
+ * @brief Derive Ed25519 public key from a 32-byte private seed (RFC 8032)
+ *
+ * @param seed Private seed
+ * @param public_key Output compressed public key
+ */
+void fido2_ed25519_public_key(const uint8_t* seed, uint8_t* public_key);
+
+/**
+ * @brief Sign a message with Ed25519 (pure EdDSA, RFC 8032)
+ *
+ * The message is given as two segments (msg || msg_tail) so callers can
+ * sign data that is not contiguous in memory without copying it.
+ *
+ * Field and scalar arithmetic are constant-time with respect to the
+ * private seed; the only data-dependent work is on public values.
+ *
+ * @param seed Private seed
+ * @param public_key Public key matching the seed
+ * @param msg First message segment
+ * @param msg_len First segment length
+ * @param msg_tail Second message segment (may be NULL if msg_tail_len is 0)
+ * @param msg_tail_len Second segment length
+ * @param signature Output signature (64 bytes: R || S)
+ */
+void fido2_ed25519_sign(
+    const uint8_t* seed,
+    const uint8_t* public_key,
+    const uint8_t* msg,
+    size_t msg_len,
+    const uint8_t* msg_tail,
+    size_t msg_tail_len,
+    uint8_t* signature);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,5 +1,6 @@
 #include "fido2_hid.h"
 #include "fido2_ctap.h"
+#include "fido_drbg.h"
 #include <furi.h>
 #include <furi_hal.h>
 #include <furi_hal_usb_hid_u2f.h>
@@ -20,6 +21,8 @@
 #define CTAPHID_INIT      (CTAPHID_TYPE_INIT | 0x06)
 #define CTAPHID_WINK      (CTAPHID_TYPE_INIT | 0x08)
 #define CTAPHID_CBOR      (CTAPHID_TYPE_INIT | 0x10)
+#define CTAPHID_CANCEL    (CTAPHID_TYPE_INIT | 0x11)
+#define CTAPHID_KEEPALIVE (CTAPHID_TYPE_INIT | 0x3b)
 #define CTAPHID_ERROR     (CTAPHID_TYPE_INIT | 0x3f)
 
 // CTAPHID error codes
@@ -34,6 +37,12 @@
 #define CTAPHID_ERR_SYNC_FAIL     0x0b
 #define CTAPHID_ERR_OTHER         0x7f
 
+// CTAPHID_KEEPALIVE status codes
+#define CTAPHID_STATUS_PROCESSING 0x01
+
+// Hosts expect a keepalive at least every 100 ms while a request is processed
+#define CTAPHID_KEEPALIVE_INTERVAL_MS 100
+
 #define CTAPHID_BROADCAST_CID 0xFFFFFFFF
 #define HID_PACKET_LEN        64
 #define CTAPHID_MAX_PAYLOAD_LEN  ((HID_PACKET_LEN - 7) + 128 * (HID_PACKET_LEN - 5))
@@ -67,6 +76,10 @@ struct Fido2Hid {
     Fido2HidConnectionCallback connection_callback;
     void* connection_context;
     volatile bool running;
+    bool busy; // a CTAP request is being processed
+    bool cancelled; // CTAPHID_CANCEL received for the request being processed
+    uint32_t keepalive_tick;
+    uint8_t frame[HID_PACKET_LEN]; // frames handled from the yield callback, off the stack
 };
 
 /**
@@ -151,6 +164,72 @@ static void fido2_hid_send_response(Fido2Hid* fido2_hid) {
     }
 }
 
+/**
+ * @brief Send a single-frame message, independent of the request packet
+ */
+static void fido2_hid_send_frame(
+    Fido2Hid* fido2_hid,
+    uint32_t cid,
+    uint8_t cmd,
+    const uint8_t* data,
+    uint8_t len) {
+    furi_assert(len <= HID_PACKET_LEN - 7);
+    memset(fido2_hid->frame, 0, HID_PACKET_LEN);
+    memcpy(fido2_hid->frame, &cid, sizeof(uint32_t));
+    fido2_hid->frame[4] = cmd;
+    fido2_hid->frame[5] = 0;
+    fido2_hid->frame[6] = len;
+    memcpy(&fido2_hid->frame[7], data, len);
+    furi_hal_hid_u2f_send_response(fido2_hid->frame, HID_PACKET_LEN);
+}
+
+/**
+ * @brief Service the transport between slices of a scalar multiplication
+ *
+ * Idle precomputation is dropped as soon as a request arrives. While a
+ * request is processed, keepalives are sent, CTAPHID_CANCEL on its channel
+ * aborts it and other channels are told the device is busy.
+ *
+ * @return false to abort the operation in progress
+ */
+static bool fido2_hid_yield_callback(void* context) {
+    Fido2Hid* fido2_hid = context;
+
+    if(!fido2_hid->running) return false;
+    uint32_t flags = furi_thread_flags_get();
+    if(flags & WorkerEvtStop) return false;
+
+    if(!fido2_hid->busy) return !(flags & WorkerEvtRequest);
+
+    uint32_t now = furi_get_tick();
+    if(now - fido2_hid->keepalive_tick >= CTAPHID_KEEPALIVE_INTERVAL_MS) {
+        const uint8_t status = CTAPHID_STATUS_PROCESSING;
+        fido2_hid_send_frame(fido2_hid, fido2_hid->packet.cid, CTAPHID_KEEPALIVE, &status, 1);
+        fido2_hid->keepalive_tick = now;
+    }
+
+    if(!(flags & WorkerEvtRequest)) return true;
+    furi_thread_flags_clear(WorkerEvtRequest);
+
+    uint32_t len = furi_hal_hid_u2f_get_request(fido2_hid->frame);
+    if(len < 7 || (fido2_hid->frame[4] & CTAPHID_TYPE_MASK) != CTAPHID_TYPE_INIT) return true;
+
+    uint32_t cid = 0;
+    memcpy(&cid, fido2_hid->frame, sizeof(uint32_t));
+    uint8_t cmd = fido2_hid->frame[4];
+
+    if(cid == fido2_hid->packet.cid) {
+        if(cmd != CTAPHID_CANCEL) return true;
+        FURI_LOG_I(WORKER_TAG, "Request cancelled");
+        fido2_hid->cancelled = true;
+        return false;
+    }
+
+    const uint8_t error = CTAPHID_ERR_CHANNEL_BUSY;
+    fido2_hid_send_frame(fido2_hid, cid, CTAPHID_ERROR, &error, 1);
+    return true;
+}
+
 /**
  * @brief Send error response
  */
@@ -179,14 +258,25 @@ static bool fido2_hid_parse_request(Fido2Hid* fido2_hid) {
 
     case CTAPHID_MSG:
     case CTAPHID_CBOR: {
+        fido2_ctap_set_channel(fido2_hid->ctap, fido2_hid->packet.cid);
+        fido2_hid->busy = true;
+        fido2_hid->cancelled = false;
+        fido2_hid->keepalive_tick = furi_get_tick();
         size_t resp_len = fido2_ctap_process(
             fido2_hid->ctap,
             fido2_hid->packet.payload,
             fido2_hid->packet.len,
             fido2_hid->packet.payload,
             sizeof(fido2_hid->packet.payload));
+        fido2_hid->busy = false;
 
-        if(resp_len > 0 && fido2_hid->running) {
+        if(fido2_hid->cancelled && fido2_hid->running) {
+            // Whatever the command made of the aborted operation, report the cancel
+            fido2_hid->packet.len = 1;
+            fido2_hid->packet.cmd = CTAPHID_CBOR;
+            fido2_hid->packet.payload[0] = CTAP2_ERR_KEEPALIVE_CANCEL;
+            fido2_hid_send_response(fido2_hid);
+        } else if(resp_len > 0 && fido2_hid->running) {
             fido2_hid->packet.len = resp_len;
             fido2_hid->packet.cmd = CTAPHID_CBOR;
             fido2_hid_send_response(fido2_hid);
@@ -222,7 +312,7 @@ static bool fido2_hid_parse_request(Fido2Hid* fido2_hid) {
             break;
         }
 
-        uint32_t random_cid = furi_hal_random_get();
+        uint32_t random_cid = fido_drbg_get();
 
         fido2_hid->packet.len = 17;
         memcpy(&(fido2_hid->packet.payload[8]), &random_cid, sizeof(uint32_t));
@@ -241,6 +331,10 @@ static bool fido2_hid_parse_request(Fido2Hid* fido2_hid) {
         fido2_hid_send_response(fido2_hid);
         break;
 
+    case CTAPHID_CANCEL:
+        // Nothing to cancel: requests in progress are cancelled from the yield callback
+        break;
+
     default:
         fido2_hid_send_error(fido2_hid, CTAPHID_ERR_INVALID_CMD);
         return false;
@@ -274,6 +368,7 @@ static int32_t fido2_hid_worker(void* context) {
         fido2_hid_lock_timeout_callback, FuriTimerTypeOnce, fido2_hid);
 
     furi_hal_hid_u2f_set_callback(fido2_hid_event_callback, fido2_hid);
+    fido2_ctap_set_yield_callback(fido2_hid->ctap, fido2_hid_yield_callback, fido2_hid);
 
     // Check initial connection state
     bool connected = furi_hal_hid_u2f_is_connected();
@@ -289,6 +384,11 @@ static int32_t fido2_hid_worker(void* context) {
             FuriFlagWaitAny,
             100); // Timeout to check running flag
 
+        if(flags == (uint32_t)FuriFlagErrorTimeout) {
+            // Idle: refill precomputed values one step at a time
+            fido2_ctap_precompute(fido2_hid->ctap);
+            continue;
+        }
         if(flags & FuriFlagError) {
             continue;
         }
@@ -388,6 +488,7 @@ static int32_t fido2_hid_worker(void* context) {
         furi_timer_free(fido2_hid->lock_timer);
     }
     
+    fido2_ctap_set_yield_callback(fido2_hid->ctap, NULL, NULL);
     furi_hal_hid_u2f_set_callback(NULL, NULL);
     furi_hal_usb_set_config(usb_mode_prev, NULL);
 
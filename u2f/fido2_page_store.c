@@ -0,0 +1,883 @@
+#include "fido2_page_store.h"
+#include "fido2_crc32.h"
+#include "fido_drbg.h"
+#include <furi.h>
+#include <storage/storage.h>
+#include <string.h>
+
+#define TAG "FIDO2_PAGES"
+
+/**
+ * Page file, all integers little-endian:
+ *
+ *   magic(4) version(4) page_records(4) record_size(4) page_size(4)
+ *   salt(4) vault(FIDO2_VAULT_WRAPPED_SIZE) header_crc(4)
+ *   pages x { copy 0, copy 1 }
+ *
+ * and each page copy, padded to FIDO2_PAGE_SIZE:
+ *
+ *   generation(4) used(4) filter(FIDO2_PAGE_FILTER_SIZE) header_crc(4)
+ *   FIDO2_PAGE_RECORDS x { record(FIDO2_CREDENTIAL_RECORD_SIZE) record_crc(4) }
+ *
+ * used has one bit per record slot. The file always holds whole pages; a
+ * copy that was never written is zeroes, which fails the header CRC.
+ *
+ * The records of a copy are one block, encrypted with the vault keys in
+ * the file header under the nonce domain || copy || page || salt ||
+ * generation. Every write raises the generation, and salt is new whenever
+ * the file is created, so no nonce is used twice. The filter holds vault
+ * tags, not the lookup keys themselves.
+ */
+#define FIDO2_PAGE_FILE_MAGIC       0x50433246 // "F2CP"
+#define FIDO2_PAGE_FILE_VERSION     2
+#define FIDO2_PAGE_FILE_HEADER_SIZE (28 + FIDO2_VAULT_WRAPPED_SIZE)
+#define FIDO2_PAGE_HEADER_SIZE      (12 + FIDO2_PAGE_FILTER_SIZE)
+#define FIDO2_PAGE_SLOT_SIZE        (FIDO2_CREDENTIAL_RECORD_SIZE + 4)
+#define FIDO2_PAGE_RECORDS_SIZE     (FIDO2_PAGE_RECORDS * FIDO2_PAGE_SLOT_SIZE)
+#define FIDO2_PAGE_FULL             ((1 << FIDO2_PAGE_RECORDS) - 1)
+#define FIDO2_PAGE_NONE             0xFFFF
+#define FIDO2_PAGE_TABLE_STEP       8 // table entries added at a time
+#define FIDO2_PAGE_FILTER_HASHES    3
+
+/**
+ * Page index, a copy of the page table in a file beside the page file:
+ *
+ *   magic(4) version(4) salt(4) pages(4)
+ *   pages x { used(1) copy(1) filter(FIDO2_PAGE_FILTER_SIZE) }
+ *   crc(4)
+ *
+ * A flush that leaves no dirty page writes it, and the next page write
+ * removes it first, so an index on the card always matches the pages. The
+ * salt ties it to one page file. Opening reads it in one block instead of
+ * the header of every page copy; without it the headers are scanned.
+ */
+#define FIDO2_PAGE_INDEX_MAGIC       0x58433246 // "F2CX"
+#define FIDO2_PAGE_INDEX_VERSION     1
+#define FIDO2_PAGE_INDEX_HEADER_SIZE 16
+#define FIDO2_PAGE_INDEX_ENTRY_SIZE  (2 + FIDO2_PAGE_FILTER_SIZE)
+
+_Static_assert(
+    FIDO2_PAGE_HEADER_SIZE + FIDO2_PAGE_RECORDS_SIZE <= FIDO2_PAGE_SIZE,
+    "Page records do not fit in a page");
+
+/**
+ * @brief RAM summary of a page, cached or not
+ */
+typedef struct {
+    uint8_t filter[FIDO2_PAGE_FILTER_SIZE];
+    uint8_t used; // one bit per record slot
+    uint8_t copy; // copy holding the newest good version; writes go to the other
+} Fido2PageInfo;
+
+typedef struct {
+    uint16_t page; // FIDO2_PAGE_NONE if the entry is free
+    bool dirty;
+    uint32_t generation; // highest generation of the page on storage
+    uint32_t last_used; // store clock of the last access, for eviction
+    Fido2Credential records[FIDO2_PAGE_RECORDS];
+} Fido2PageCacheEntry;
+
+struct Fido2PageStore {
+    const char* path; // NULL while detached
+    const char* index_path; // NULL if the page file keeps no index
+    const char* temp_path; // NULL to create the page file in place
+    bool index_valid; // the index on the card matches the pages
+    uint32_t salt;
+    uint8_t wrapped[FIDO2_VAULT_WRAPPED_SIZE];
+    Fido2Vault vault; // not ready while detached
+    Fido2PageInfo* table;
+    uint16_t table_size;
+    uint16_t page_count; // pages in use, including ones not written yet
+    uint16_t file_pages; // pages present in the file
+    uint32_t clock;
+    Fido2PageCacheEntry cache[FIDO2_PAGE_CACHE_SIZE];
+};
+
+static uint8_t* put_u32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+    return out + 4;
+}
+
+static uint32_t get_u32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+           ((uint32_t)in[3] << 24);
+}
+
+static uint32_t page_offset(Fido2PageStore* pages, uint16_t page, uint8_t copy) {
+    return FIDO2_PAGE_FILE_HEADER_SIZE + ((uint32_t)page * 2 + copy) * FIDO2_PAGE_SIZE;
+}
+
+/**
+ * @brief En- or decrypt the records of a page copy in place
+ */
+static bool page_crypt(
+    Fido2PageStore* pages,
+    uint16_t page,
+    uint8_t copy,
+    uint32_t generation,
+    uint8_t* records) {
+    uint8_t nonce[FIDO2_VAULT_NONCE_SIZE];
+    nonce[0] = FIDO2_VAULT_DOMAIN_PAGE;
+    nonce[1] = copy;
+    nonce[2] = page & 0xFF;
+    nonce[3] = page >> 8;
+    put_u32(put_u32(nonce + 4, pages->salt), generation);
+    return fido2_vault_crypt(&pages->vault, nonce, records, records, FIDO2_PAGE_RECORDS_SIZE);
+}
+
+/**
+ * @brief Bloom filter bit positions, taken straight from the key
+ *
+ * Filter keys are vault tags, so their leading bytes are already
+ * independent uniform hashes.
+ */
+static uint16_t filter_bit(const uint8_t* key, size_t hash) {
+    return (key[2 * hash] | (key[2 * hash + 1] << 8)) % (FIDO2_PAGE_FILTER_SIZE * 8);
+}
+
+static void filter_add(uint8_t* filter, const uint8_t* key) {
+    for(size_t i = 0; i < FIDO2_PAGE_FILTER_HASHES; i++) {
+        uint16_t bit = filter_bit(key, i);
+        filter[bit / 8] |= 1 << (bit % 8);
+    }
+}
+
+static bool filter_test(const uint8_t* filter, const uint8_t* key) {
+    for(size_t i = 0; i < FIDO2_PAGE_FILTER_HASHES; i++) {
+        uint16_t bit = filter_bit(key, i);
+        if(!(filter[bit / 8] & (1 << (bit % 8)))) return false;
+    }
+    return true;
+}
+
+static void filter_key(Fido2PageStore* pages, const void* key, size_t len, uint8_t* tag) {
+    fido2_vault_tag(&pages->vault, key, len, tag);
+}
+
+static void page_table_reserve(Fido2PageStore* pages, uint16_t count) {
+    if(count <= pages->table_size) return;
+    uint16_t size = (count + FIDO2_PAGE_TABLE_STEP - 1) / FIDO2_PAGE_TABLE_STEP *
+                    FIDO2_PAGE_TABLE_STEP;
+    pages->table = realloc(pages->table, size * sizeof(Fido2PageInfo));
+    memset(
+        pages->table + pages->table_size,
+        0,
+        (size - pages->table_size) * sizeof(Fido2PageInfo));
+    pages->table_size = size;
+}
+
+static void page_cache_wipe(Fido2PageCacheEntry* entry) {
+    memset(entry, 0, sizeof(Fido2PageCacheEntry));
+    entry->page = FIDO2_PAGE_NONE;
+}
+
+/**
+ * @brief Forget all pages, cached or not
+ */
+static void page_store_drop(Fido2PageStore* pages) {
+    for(size_t i = 0; i < FIDO2_PAGE_CACHE_SIZE; i++) {
+        page_cache_wipe(&pages->cache[i]);
+    }
+    free(pages->table);
+    pages->table = NULL;
+    pages->table_size = 0;
+    pages->page_count = 0;
+    pages->file_pages = 0;
+}
+
+/**
+ * @brief Recompute the filter and used bits of a cached page from its records
+ */
+static void page_refresh(Fido2PageStore* pages, const Fido2PageCacheEntry* entry) {
+    Fido2PageInfo* info = &pages->table[entry->page];
+    memset(info->filter, 0, sizeof(info->filter));
+    info->used = 0;
+    for(size_t i = 0; i < FIDO2_PAGE_RECORDS; i++) {
+        const Fido2Credential* cred = &entry->records[i];
+        if(!cred->valid) continue;
+        info->used |= 1 << i;
+        // Without vault keys there is nothing to tag, see page_store_find
+        if(!pages->vault.ready) continue;
+        uint8_t tag[FIDO_HMAC_SIZE];
+        filter_key(pages, cred->credential_id, sizeof(cred->credential_id), tag);
+        filter_add(info->filter, tag);
+        filter_key(pages, cred->rp_id, strlen(cred->rp_id), tag);
+        filter_add(info->filter, tag);
+    }
+    if(!pages->vault.ready) memset(info->filter, 0xFF, sizeof(info->filter));
+}
+
+/**
+ * @brief Check the header of a page copy
+ */
+static bool page_header_valid(const uint8_t* copy, uint32_t* generation) {
+    uint32_t crc = fido2_crc32(copy, FIDO2_PAGE_HEADER_SIZE - 4);
+    if(get_u32(copy + FIDO2_PAGE_HEADER_SIZE - 4) != crc) return false;
+    *generation = get_u32(copy);
+    return true;
+}
+
+/**
+ * @brief Parse the records of a page copy whose header was checked
+ *
+ * @param strict fail on any corrupt record instead of dropping it
+ */
+static bool page_decode(const uint8_t* copy, Fido2PageCacheEntry* entry, bool strict) {
+    uint32_t used = get_u32(copy + 4);
+    uint32_t dropped = 0;
+    for(size_t i = 0; i < FIDO2_PAGE_RECORDS; i++) {
+        memset(&entry->records[i], 0, sizeof(Fido2Credential));
+        if(!(used & (1 << i))) continue;
+        const uint8_t* record = copy + FIDO2_PAGE_HEADER_SIZE + i * FIDO2_PAGE_SLOT_SIZE;
+        if(get_u32(record + FIDO2_CREDENTIAL_RECORD_SIZE) !=
+               fido2_crc32(record, FIDO2_CREDENTIAL_RECORD_SIZE) ||
+           !fido2_credential_deserialize(record, &entry->records[i])) {
+            dropped++;
+        }
+    }
+
+    if(dropped && strict) {
+        memset(entry->records, 0, sizeof(entry->records));
+        return false;
+    }
+    if(dropped) FURI_LOG_W(TAG, "Page %u: dropped %lu damaged records", entry->page, dropped);
+    return true;
+}
+
+/**
+ * @brief Read a page into a free cache entry
+ *
+ * Takes the newest copy if all its records are intact, else the other
+ * copy, else the newest without its damaged records. A page with no
+ * usable copy, or not written yet, reads as empty.
+ */
+static bool page_read(Fido2PageStore* pages, Fido2PageCacheEntry* entry, uint16_t page) {
+    entry->page = page;
+    entry->dirty = false;
+    entry->generation = 0;
+    if(page >= pages->file_pages) return true;
+
+    Fido2PageInfo* info = &pages->table[page];
+    uint8_t* buffer = malloc(2 * FIDO2_PAGE_SIZE);
+    uint8_t* copy[2] = {buffer, buffer + FIDO2_PAGE_SIZE};
+
+    // Both copies of a page are adjacent, one read gets them
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool read = storage_file_open(file, pages->path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+                storage_file_seek(file, page_offset(pages, page, 0), true) &&
+                storage_file_read(file, buffer, 2 * FIDO2_PAGE_SIZE) == 2 * FIDO2_PAGE_SIZE;
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    if(read) {
+        uint32_t generation[2] = {0};
+        bool valid[2];
+        for(uint8_t i = 0; i < 2; i++) {
+            valid[i] = page_header_valid(copy[i], &generation[i]);
+        }
+        entry->generation = generation[0] > generation[1] ? generation[0] : generation[1];
+
+        // Each copy is decrypted once, when it is first tried
+        uint8_t newest = info->copy;
+        uint8_t order[3] = {newest, newest ^ 1, newest};
+        bool plain[2] = {false, false};
+        bool decoded = false;
+        for(size_t i = 0; i < COUNT_OF(order) && !decoded; i++) {
+            uint8_t c = order[i];
+            if(!valid[c]) continue;
+            if(!plain[c]) {
+                plain[c] = page_crypt(
+                    pages, page, c, generation[c], copy[c] + FIDO2_PAGE_HEADER_SIZE);
+                if(!plain[c]) continue;
+            }
+            decoded = page_decode(copy[c], entry, i != COUNT_OF(order) - 1);
+            if(decoded) info->copy = c;
+        }
+        if(!decoded) FURI_LOG_W(TAG, "Page %u: no usable copy", page);
+
+        // The filter from the header may describe a copy that was not taken
+        page_refresh(pages, entry);
+    } else {
+        FURI_LOG_E(TAG, "Page %u: read failed", page);
+    }
+
+    memset(buffer, 0, 2 * FIDO2_PAGE_SIZE);
+    free(buffer);
+    return read;
+}
+
+static bool page_file_write_header(Fido2PageStore* pages, File* file) {
+    uint8_t header[FIDO2_PAGE_FILE_HEADER_SIZE];
+    uint8_t* out = put_u32(header, FIDO2_PAGE_FILE_MAGIC);
+    out = put_u32(out, FIDO2_PAGE_FILE_VERSION);
+    out = put_u32(out, FIDO2_PAGE_RECORDS);
+    out = put_u32(out, FIDO2_CREDENTIAL_RECORD_SIZE);
+    out = put_u32(out, FIDO2_PAGE_SIZE);
+    out = put_u32(out, pages->salt);
+    memcpy(out, pages->wrapped, sizeof(pages->wrapped));
+    put_u32(
+        header + FIDO2_PAGE_FILE_HEADER_SIZE - 4,
+        fido2_crc32(header, FIDO2_PAGE_FILE_HEADER_SIZE - 4));
+    return storage_file_seek(file, 0, true) &&
+           storage_file_write(file, header, sizeof(header)) == sizeof(header);
+}
+
+/**
+ * @brief Create an empty page file with a new salt, or replace one by it
+ *
+ * The vault keys must be ready. The file exists from here on, so the
+ * wrapped keys are on the card before anything is encrypted with them.
+ * With a temp path, the new file is complete before it replaces the old
+ * one, so a power loss never leaves a headerless page file behind.
+ */
+static bool page_file_create(Fido2PageStore* pages) {
+    pages->salt = fido_drbg_get();
+    const char* target = pages->temp_path ? pages->temp_path : pages->path;
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool success = storage_file_open(file, target, FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+                   page_file_write_header(pages, file) && storage_file_sync(file);
+    storage_file_close(file);
+    storage_file_free(file);
+    if(success && pages->temp_path) {
+        // The credential data loader finishes the rename if it is interrupted
+        success = storage_simply_remove(storage, pages->path) &&
+                  storage_common_rename(storage, pages->temp_path, pages->path) == FSE_OK;
+    }
+    furi_record_close(RECORD_STORAGE);
+    if(!success) FURI_LOG_E(TAG, "Failed to create %s", pages->path);
+    return success;
+}
+
+static size_t page_index_size(uint16_t count) {
+    return FIDO2_PAGE_INDEX_HEADER_SIZE + count * FIDO2_PAGE_INDEX_ENTRY_SIZE + 4;
+}
+
+/**
+ * @brief Fill the page table from the index, if it describes count pages of this file
+ */
+static bool page_index_load(Fido2PageStore* pages, uint16_t count) {
+    if(!pages->index_path) return false;
+
+    size_t size = page_index_size(count);
+    uint8_t* buffer = malloc(size);
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool valid = storage_file_open(file, pages->index_path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+                 storage_file_size(file) == size &&
+                 storage_file_read(file, buffer, size) == size &&
+                 get_u32(buffer) == FIDO2_PAGE_INDEX_MAGIC &&
+                 get_u32(buffer + 4) == FIDO2_PAGE_INDEX_VERSION &&
+                 get_u32(buffer + 8) == pages->salt && get_u32(buffer + 12) == count &&
+                 get_u32(buffer + size - 4) == fido2_crc32(buffer, size - 4);
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    const uint8_t* in = buffer + FIDO2_PAGE_INDEX_HEADER_SIZE;
+    for(uint16_t page = 0; valid && page < count; page++) {
+        Fido2PageInfo* info = &pages->table[page];
+        info->used = in[0] & FIDO2_PAGE_FULL;
+        info->copy = in[1] & 1;
+        memcpy(info->filter, in + 2, sizeof(info->filter));
+        in += FIDO2_PAGE_INDEX_ENTRY_SIZE;
+    }
+    free(buffer);
+    return valid;
+}
+
+/**
+ * @brief Write the index of a page file without dirty pages
+ *
+ * Only a cache: on failure the next open scans the page headers instead.
+ */
+static void page_index_save(Fido2PageStore* pages) {
+    size_t size = page_index_size(pages->file_pages);
+    uint8_t* buffer = malloc(size);
+    uint8_t* out = put_u32(buffer, FIDO2_PAGE_INDEX_MAGIC);
+    out = put_u32(out, FIDO2_PAGE_INDEX_VERSION);
+    out = put_u32(out, pages->salt);
+    out = put_u32(out, pages->file_pages);
+    for(uint16_t page = 0; page < pages->file_pages; page++) {
+        const Fido2PageInfo* info = &pages->table[page];
+        out[0] = info->used;
+        out[1] = info->copy;
+        memcpy(out + 2, info->filter, sizeof(info->filter));
+        out += FIDO2_PAGE_INDEX_ENTRY_SIZE;
+    }
+    put_u32(out, fido2_crc32(buffer, size - 4));
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    pages->index_valid =
+        storage_file_open(file, pages->index_path, FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+        storage_file_write(file, buffer, size) == size && storage_file_sync(file);
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+    free(buffer);
+
+    if(!pages->index_valid) FURI_LOG_W(TAG, "Failed to write the page index");
+}
+
+/**
+ * @brief Remove the index before the pages change under it
+ */
+static bool page_index_invalidate(Fido2PageStore* pages) {
+    if(!pages->index_valid) return true;
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    pages->index_valid = !storage_simply_remove(storage, pages->index_path);
+    furi_record_close(RECORD_STORAGE);
+    if(pages->index_valid) FURI_LOG_E(TAG, "Failed to remove the page index");
+    return !pages->index_valid;
+}
+
+/**
+ * @brief Write a cached page to its older copy and sync it
+ *
+ * Pages between the end of the file and this page are zero-filled first,
+ * so the file always holds whole pages.
+ */
+static bool page_write(Fido2PageStore* pages, Fido2PageCacheEntry* entry) {
+    if(!pages->path) {
+        FURI_LOG_E(TAG, "No page file attached");
+        return false;
+    }
+    if(!page_index_invalidate(pages)) return false;
+
+    Fido2PageInfo* info = &pages->table[entry->page];
+    uint8_t target = info->copy ^ 1;
+    uint32_t generation = entry->generation + 1;
+    uint8_t* buffer = malloc(FIDO2_PAGE_SIZE);
+    memset(buffer, 0, FIDO2_PAGE_SIZE);
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool success = storage_file_open(file, pages->path, FSAM_READ_WRITE, FSOM_OPEN_ALWAYS);
+
+    // The header is written when the file is created; this only repairs a lost one
+    if(success && storage_file_size(file) < FIDO2_PAGE_FILE_HEADER_SIZE) {
+        success = page_file_write_header(pages, file);
+    }
+
+    uint16_t extend_to = entry->page + 1 > pages->file_pages ? entry->page + 1 : 0;
+    if(success && extend_to) {
+        success = storage_file_seek(file, page_offset(pages, pages->file_pages, 0), true);
+        for(uint32_t copy = pages->file_pages * 2; success && copy < extend_to * 2u; copy++) {
+            success = storage_file_write(file, buffer, FIDO2_PAGE_SIZE) == FIDO2_PAGE_SIZE;
+        }
+    }
+
+    if(success) {
+        uint8_t* out = put_u32(buffer, generation);
+        out = put_u32(out, info->used);
+        memcpy(out, info->filter, sizeof(info->filter));
+        put_u32(
+            buffer + FIDO2_PAGE_HEADER_SIZE - 4,
+            fido2_crc32(buffer, FIDO2_PAGE_HEADER_SIZE - 4));
+        for(size_t i = 0; i < FIDO2_PAGE_RECORDS; i++) {
+            if(!entry->records[i].valid) continue;
+            uint8_t* record = buffer + FIDO2_PAGE_HEADER_SIZE + i * FIDO2_PAGE_SLOT_SIZE;
+            fido2_credential_serialize(&entry->records[i], record);
+            put_u32(
+                record + FIDO2_CREDENTIAL_RECORD_SIZE,
+                fido2_crc32(record, FIDO2_CREDENTIAL_RECORD_SIZE));
+        }
+        success =
+            page_crypt(pages, entry->page, target, generation, buffer + FIDO2_PAGE_HEADER_SIZE) &&
+            storage_file_seek(file, page_offset(pages, entry->page, target), true) &&
+                  storage_file_write(file, buffer, FIDO2_PAGE_SIZE) == FIDO2_PAGE_SIZE &&
+                  storage_file_sync(file);
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    memset(buffer, 0, FIDO2_PAGE_SIZE);
+    free(buffer);
+
+    if(success) {
+        info->copy = target;
+        entry->generation = generation;
+        entry->dirty = false;
+        if(extend_to) pages->file_pages = extend_to;
+    } else {
+        FURI_LOG_E(TAG, "Page %u: write failed", entry->page);
+    }
+    return success;
+}
+
+/**
+ * @brief Get a page into the cache, evicting the least recently used one
+ *
+ * @return NULL if the evicted page was dirty and could not be written back
+ */
+static Fido2PageCacheEntry* page_in(Fido2PageStore* pages, uint16_t page) {
+    Fido2PageCacheEntry* victim = NULL;
+    for(size_t i = 0; i < FIDO2_PAGE_CACHE_SIZE; i++) {
+        Fido2PageCacheEntry* entry = &pages->cache[i];
+        if(entry->page == page) {
+            entry->last_used = ++pages->clock;
+            return entry;
+        }
+        if(!victim || (victim->page != FIDO2_PAGE_NONE &&
+                       (entry->page == FIDO2_PAGE_NONE || entry->last_used < victim->last_used))) {
+            victim = entry;
+        }
+    }
+
+    if(victim->page != FIDO2_PAGE_NONE) {
+        if(victim->dirty && !page_write(pages, victim)) return NULL;
+        page_cache_wipe(victim);
+    }
+    if(!page_read(pages, victim, page)) {
+        page_cache_wipe(victim);
+        return NULL;
+    }
+    victim->last_used = ++pages->clock;
+    return victim;
+}
+
+static Fido2PageCacheEntry* page_of(Fido2PageStore* pages, const Fido2Credential* cred) {
+    for(size_t i = 0; i < FIDO2_PAGE_CACHE_SIZE; i++) {
+        Fido2PageCacheEntry* entry = &pages->cache[i];
+        if(entry->page != FIDO2_PAGE_NONE && cred >= entry->records &&
+           cred < entry->records + FIDO2_PAGE_RECORDS) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+typedef bool (*Fido2PageMatch)(const Fido2Credential* cred, const void* key);
+
+static bool match_id(const Fido2Credential* cred, const void* key) {
+    return memcmp(cred->credential_id, key, sizeof(cred->credential_id)) == 0;
+}
+
+static bool match_rp(const Fido2Credential* cred, const void* key) {
+    return strcmp(cred->rp_id, key) == 0;
+}
+
+static Fido2Credential* page_entry_find(
+    Fido2PageStore* pages,
+    Fido2PageCacheEntry* entry,
+    Fido2PageMatch match,
+    const void* key) {
+    for(size_t i = 0; i < FIDO2_PAGE_RECORDS; i++) {
+        if(entry->records[i].valid && match(&entry->records[i], key)) {
+            entry->last_used = ++pages->clock;
+            return &entry->records[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Search cached pages, then the pages whose filter may hold the key
+ */
+static Fido2Credential* page_store_find(
+    Fido2PageStore* pages,
+    const void* key,
+    size_t key_len,
+    Fido2PageMatch match) {
+    uint8_t tag[FIDO_HMAC_SIZE] = {0};
+    if(pages->vault.ready) filter_key(pages, key, key_len, tag);
+
+    for(size_t i = 0; i < FIDO2_PAGE_CACHE_SIZE; i++) {
+        Fido2PageCacheEntry* entry = &pages->cache[i];
+        if(entry->page == FIDO2_PAGE_NONE) continue;
+        Fido2Credential* cred = page_entry_find(pages, entry, match, key);
+        if(cred) return cred;
+    }
+
+    for(uint16_t page = 0; page < pages->page_count; page++) {
+        if(!filter_test(pages->table[page].filter, tag)) continue;
+        bool cached = false;
+        for(size_t i = 0; i < FIDO2_PAGE_CACHE_SIZE; i++) {
+            if(pages->cache[i].page == page) cached = true;
+        }
+        if(cached) continue;
+
+        Fido2PageCacheEntry* entry = page_in(pages, page);
+        Fido2Credential* cred = entry ? page_entry_find(pages, entry, match, key) : NULL;
+        if(cred) return cred;
+    }
+    return NULL;
+}
+
+Fido2PageStore* fido2_page_store_alloc(void) {
+    Fido2PageStore* pages = malloc(sizeof(Fido2PageStore));
+    memset(pages, 0, sizeof(Fido2PageStore));
+    page_store_drop(pages);
+    return pages;
+}
+
+void fido2_page_store_free(Fido2PageStore* pages) {
+    if(!pages) return;
+    page_store_drop(pages);
+    fido2_vault_wipe(&pages->vault);
+    free(pages);
+}
+
+bool fido2_page_store_open(
+    Fido2PageStore* pages,
+    const char* path,
+    const char* index_path,
+    const char* temp_path) {
+    furi_check(pages && path);
+    page_store_drop(pages);
+    fido2_vault_wipe(&pages->vault);
+    pages->path = path;
+    pages->index_path = index_path;
+    pages->temp_path = temp_path;
+    pages->index_valid = false;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    File* file = storage_file_alloc(storage);
+    bool exists = storage_file_open(file, path, FSAM_READ, FSOM_OPEN_EXISTING);
+    bool valid = true;
+    if(exists) {
+        uint8_t header[FIDO2_PAGE_FILE_HEADER_SIZE];
+        valid = storage_file_read(file, header, sizeof(header)) == sizeof(header) &&
+                get_u32(header) == FIDO2_PAGE_FILE_MAGIC &&
+                get_u32(header + 4) == FIDO2_PAGE_FILE_VERSION &&
+                get_u32(header + 8) == FIDO2_PAGE_RECORDS &&
+                get_u32(header + 12) == FIDO2_CREDENTIAL_RECORD_SIZE &&
+                get_u32(header + 16) == FIDO2_PAGE_SIZE &&
+                get_u32(header + sizeof(header) - 4) == fido2_crc32(header, sizeof(header) - 4);
+        if(valid) {
+            pages->salt = get_u32(header + 20);
+            memcpy(pages->wrapped, header + 24, sizeof(pages->wrapped));
+        }
+
+        // A page appended by a write that did not complete is ignored
+        uint32_t count = 0;
+        if(valid) {
+            uint64_t size = storage_file_size(file) - FIDO2_PAGE_FILE_HEADER_SIZE;
+            count = size / (2 * FIDO2_PAGE_SIZE);
+        }
+        if(count > FIDO2_PAGE_MAX) {
+            FURI_LOG_W(TAG, "Ignoring %lu pages past the store size", count - FIDO2_PAGE_MAX);
+            count = FIDO2_PAGE_MAX;
+        }
+        page_table_reserve(pages, count);
+
+        // Only the index or the page headers are read here; records wait
+        // until a page is used
+        pages->index_valid = valid && page_index_load(pages, count);
+        uint8_t copy[FIDO2_PAGE_HEADER_SIZE];
+        for(uint16_t page = 0; page < count && !pages->index_valid; page++) {
+            Fido2PageInfo* info = &pages->table[page];
+            uint32_t newest = 0;
+            info->copy = 1;
+            for(uint8_t i = 0; i < 2; i++) {
+                uint32_t generation;
+                if(!storage_file_seek(file, page_offset(pages, page, i), true) ||
+                   storage_file_read(file, copy, sizeof(copy)) != sizeof(copy) ||
+                   !page_header_valid(copy, &generation) || (i == 1 && generation <= newest)) {
+                    continue;
+                }
+                newest = generation;
+                info->copy = i;
+                info->used = get_u32(copy + 4) & FIDO2_PAGE_FULL;
+                memcpy(info->filter, copy + 8, sizeof(info->filter));
+            }
+        }
+        pages->page_count = count;
+        pages->file_pages = count;
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    // The only use of the enclave until the store is opened again
+    if(!exists) {
+        valid = fido2_vault_create(&pages->vault, pages->wrapped) && page_file_create(pages);
+    } else if(valid) {
+        valid = fido2_vault_open(&pages->vault, pages->wrapped);
+    }
+
+    if(!valid) {
+        FURI_LOG_E(TAG, "Unusable page file: %s", path);
+        page_store_drop(pages);
+        fido2_vault_wipe(&pages->vault);
+        pages->path = NULL;
+        return false;
+    }
+    FURI_LOG_I(
+        TAG,
+        "%u pages, %u credentials%s",
+        pages->page_count,
+        fido2_page_store_count(pages),
+        pages->index_valid ? ", from index" : "");
+    return true;
+}
+
+bool fido2_page_store_rename(Fido2PageStore* pages, const char* path) {
+    furi_check(pages && path);
+    if(!fido2_page_store_flush(pages)) return false;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    bool success = storage_common_rename(storage, pages->path, path) == FSE_OK;
+    furi_record_close(RECORD_STORAGE);
+    if(success) {
+        // The old name is free now, for building replacements of the new one
+        pages->temp_path = pages->path;
+        pages->path = path;
+    }
+    return success;
+}
+
+const Fido2Vault* fido2_page_store_vault(Fido2PageStore* pages) {
+    furi_check(pages);
+    return pages->vault.ready ? &pages->vault : NULL;
+}
+
+Fido2Credential* fido2_page_store_find_by_id(Fido2PageStore* pages, const uint8_t* credential_id) {
+    furi_check(pages && credential_id);
+    return page_store_find(pages, credential_id, FIDO2_CREDENTIAL_ID_SIZE, match_id);
+}
+
+Fido2Credential* fido2_page_store_find_by_rp(Fido2PageStore* pages, const char* rp_id) {
+    furi_check(pages && rp_id);
+    return page_store_find(pages, rp_id, strlen(rp_id), match_rp);
+}
+
+Fido2Credential* fido2_page_store_get(Fido2PageStore* pages, size_t slot) {
+    furi_check(pages);
+    size_t page = slot / FIDO2_PAGE_RECORDS;
+    size_t record = slot % FIDO2_PAGE_RECORDS;
+    if(page >= pages->page_count || !(pages->table[page].used & (1 << record))) return NULL;
+
+    Fido2PageCacheEntry* entry = page_in(pages, page);
+    if(!entry || !entry->records[record].valid) return NULL;
+    return &entry->records[record];
+}
+
+size_t fido2_page_store_slot(Fido2PageStore* pages, const Fido2Credential* cred) {
+    Fido2PageCacheEntry* entry = page_of(pages, cred);
+    furi_check(entry);
+    return entry->page * FIDO2_PAGE_RECORDS + (cred - entry->records);
+}
+
+Fido2Credential* fido2_page_store_add(Fido2PageStore* pages) {
+    furi_check(pages);
+
+    // A cached page with room costs no I/O, then the first page with room
+    uint16_t page = FIDO2_PAGE_NONE;
+    for(size_t i = 0; i < FIDO2_PAGE_CACHE_SIZE && page == FIDO2_PAGE_NONE; i++) {
+        uint16_t cached = pages->cache[i].page;
+        if(cached != FIDO2_PAGE_NONE && pages->table[cached].used != FIDO2_PAGE_FULL) {
+            page = cached;
+        }
+    }
+    for(uint16_t i = 0; i < pages->page_count && page == FIDO2_PAGE_NONE; i++) {
+        if(pages->table[i].used != FIDO2_PAGE_FULL) page = i;
+    }
+
+    bool appended = false;
+    if(page == FIDO2_PAGE_NONE) {
+        if(pages->page_count >= FIDO2_PAGE_MAX) {
+            FURI_LOG_W(TAG, "Store full");
+            return NULL;
+        }
+        page_table_reserve(pages, pages->page_count + 1);
+        page = pages->page_count++;
+        memset(&pages->table[page], 0, sizeof(Fido2PageInfo));
+        pages->table[page].copy = 1;
+        appended = true;
+    }
+
+    Fido2PageCacheEntry* entry = page_in(pages, page);
+    if(!entry) {
+        if(appended) pages->page_count--;
+        return NULL;
+    }
+    for(size_t i = 0; i < FIDO2_PAGE_RECORDS; i++) {
+        if(!entry->records[i].valid) {
+            memset(&entry->records[i], 0, sizeof(Fido2Credential));
+            return &entry->records[i];
+        }
+    }
+    return NULL;
+}
+
+void fido2_page_store_update(Fido2PageStore* pages, const Fido2Credential* cred) {
+    furi_check(pages && cred);
+    Fido2PageCacheEntry* entry = page_of(pages, cred);
+    furi_check(entry);
+    page_refresh(pages, entry);
+    entry->dirty = true;
+}
+
+Fido2Credential* fido2_page_store_get_cached(Fido2PageStore* pages, size_t index) {
+    furi_check(pages && index < FIDO2_PAGE_CACHE_SIZE * FIDO2_PAGE_RECORDS);
+    Fido2PageCacheEntry* entry = &pages->cache[index / FIDO2_PAGE_RECORDS];
+    Fido2Credential* cred = &entry->records[index % FIDO2_PAGE_RECORDS];
+    return entry->page != FIDO2_PAGE_NONE && cred->valid ? cred : NULL;
+}
+
+bool fido2_page_store_flush(Fido2PageStore* pages) {
+    furi_check(pages);
+    // Nothing detached is durable, so callers must keep their journal
+    if(!pages->path) return false;
+
+    // Lowest page first, so the file grows in order
+    while(true) {
+        Fido2PageCacheEntry* next = NULL;
+        for(size_t i = 0; i < FIDO2_PAGE_CACHE_SIZE; i++) {
+            Fido2PageCacheEntry* entry = &pages->cache[i];
+            if(entry->dirty && (!next || entry->page < next->page)) next = entry;
+        }
+        if(!next) break;
+        if(!page_write(pages, next)) return false;
+    }
+
+    if(pages->index_path && !pages->index_valid) page_index_save(pages);
+    return true;
+}
+
+void fido2_page_store_clear(Fido2PageStore* pages) {
+    furi_check(pages);
+    page_store_drop(pages);
+    if(!pages->path) return;
+    page_index_invalidate(pages);
+
+    // The wrapped keys stay, the journal may still hold entries encrypted with them
+    if(page_file_create(pages)) FURI_LOG_I(TAG, "Page file cleared");
+}
+
+bool fido2_page_store_rekey(Fido2PageStore* pages) {
+    furi_check(pages);
+    if(!pages->path || fido2_page_store_count(pages)) return false;
+    page_store_drop(pages);
+    page_index_invalidate(pages);
+
+    fido2_vault_wipe(&pages->vault);
+    if(fido2_vault_create(&pages->vault, pages->wrapped) && page_file_create(pages)) {
+        FURI_LOG_I(TAG, "Page file created with new keys");
+        return true;
+    }
+    // The old keys are gone from RAM, so nothing can be written any more
+    FURI_LOG_E(TAG, "Failed to replace the vault keys");
+    fido2_vault_wipe(&pages->vault);
+    pages->path = NULL;
+    return false;
+}
+
+size_t fido2_page_store_count(Fido2PageStore* pages) {
+    furi_check(pages);
+    size_t count = 0;
+    for(uint16_t page = 0; page < pages->page_count; page++) {
+        for(uint8_t used = pages->table[page].used; used; used &= used - 1) {
+            count++;
+        }
+    }
+    return count;
+}
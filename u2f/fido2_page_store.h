@@ -0,0 +1,146 @@
+#pragma once
+
+#include "fido2_credential.h"
+#include "fido2_vault.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Credential records in fixed-size pages on the SD card
+ *
+ * Only the FIDO2_PAGE_CACHE_SIZE most recently used pages are held in RAM,
+ * least-recently-used evicted. For every page RAM keeps a Bloom filter over
+ * the credential ids and rpIdHashes it holds, so a lookup reads only the
+ * pages that may match and answers "not here" without any I/O. The page
+ * table is saved as an index beside the page file, so opening it reads no
+ * records and no page headers.
+ *
+ * Each page has two copies in the file. A write goes to the copy not
+ * holding the newest generation, so a torn write never damages the last
+ * good version of a page. Dirty pages are written back on eviction and by
+ * fido2_page_store_flush.
+ *
+ * Records are encrypted at rest with the vault keys wrapped in the file
+ * header (see fido2_vault.h), one AES call per page read or written.
+ *
+ * Credentials returned by the store point into the cache and stay valid
+ * until another page is read in. Not thread safe: use from the worker only.
+ */
+#define FIDO2_PAGE_RECORDS     4
+#define FIDO2_PAGE_SIZE        2048 // one page copy, whole SD sectors
+#define FIDO2_PAGE_FILTER_SIZE 32 // 256 bits, k = 3, for 8 keys a page
+#define FIDO2_PAGE_CACHE_SIZE  2
+#define FIDO2_PAGE_MAX         (FIDO2_MAX_CREDENTIALS / FIDO2_PAGE_RECORDS)
+
+typedef struct Fido2PageStore Fido2PageStore;
+
+Fido2PageStore* fido2_page_store_alloc(void);
+
+/**
+ * @brief Wipe the cached records and free the store, without writing back
+ */
+void fido2_page_store_free(Fido2PageStore* pages);
+
+/**
+ * @brief Attach to a page file and build the page table
+ *
+ * The table comes from the page index in one read if it matches the file,
+ * else from the header of every page copy. Unwraps the vault keys of the
+ * file with the secure enclave. A missing file is created empty, with new
+ * vault keys.
+ *
+ * @param index_path page index kept up to date by flushes, or NULL for none
+ * @param temp_path where a new or cleared file is built before it is renamed
+ * over path, or NULL to write it in place
+ * @return false if the file exists but is not a page file, or its keys
+ * cannot be unwrapped; the store is then left detached and every write fails
+ */
+bool fido2_page_store_open(
+    Fido2PageStore* pages,
+    const char* path,
+    const char* index_path,
+    const char* temp_path);
+
+/**
+ * @brief Write back dirty pages, then move the page file to a new path
+ *
+ * The old path becomes the temp path for later replacements of the file.
+ */
+bool fido2_page_store_rename(Fido2PageStore* pages, const char* path);
+
+/**
+ * @brief Vault keys of the attached page file
+ *
+ * @return NULL if the store is detached
+ */
+const Fido2Vault* fido2_page_store_vault(Fido2PageStore* pages);
+
+Fido2Credential* fido2_page_store_find_by_id(Fido2PageStore* pages, const uint8_t* credential_id);
+
+Fido2Credential* fido2_page_store_find_by_rp(Fido2PageStore* pages, const char* rp_id);
+
+/**
+ * @brief Get the credential in a slot, page * FIDO2_PAGE_RECORDS + record
+ *
+ * @return NULL if the slot is empty, out of range or its page unreadable
+ */
+Fido2Credential* fido2_page_store_get(Fido2PageStore* pages, size_t slot);
+
+/**
+ * @brief Slot of a credential returned by the store
+ */
+size_t fido2_page_store_slot(Fido2PageStore* pages, const Fido2Credential* cred);
+
+/**
+ * @brief Get a cleared free record, in a page with room or in a new page
+ *
+ * The caller fills it in and marks it valid, then calls
+ * fido2_page_store_update.
+ *
+ * @return NULL if the store is full or a dirty page could not be written back
+ */
+Fido2Credential* fido2_page_store_add(Fido2PageStore* pages);
+
+/**
+ * @brief Mark the page of a changed or cleared credential for write-back
+ */
+void fido2_page_store_update(Fido2PageStore* pages, const Fido2Credential* cred);
+
+/**
+ * @brief Get a credential of a cached page, for RAM-only bulk updates
+ *
+ * @param index below FIDO2_PAGE_CACHE_SIZE * FIDO2_PAGE_RECORDS
+ * @return NULL if the record is empty
+ */
+Fido2Credential* fido2_page_store_get_cached(Fido2PageStore* pages, size_t index);
+
+/**
+ * @brief Write back all dirty pages, then the page index if it is stale
+ *
+ * @return false if a page could not be written or the store is detached
+ */
+bool fido2_page_store_flush(Fido2PageStore* pages);
+
+/**
+ * @brief Drop all credentials and replace the page file by an empty one
+ */
+void fido2_page_store_clear(Fido2PageStore* pages);
+
+/**
+ * @brief Recreate the empty page file of a cleared store with new vault keys
+ *
+ * Nothing written under the old keys can be read afterwards, so the journal
+ * must be compacted away first.
+ *
+ * @return false if the store is not empty or detached, or the file could not
+ * be written, which leaves the store detached
+ */
+bool fido2_page_store_rekey(Fido2PageStore* pages);
+
+size_t fido2_page_store_count(Fido2PageStore* pages);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,109 @@
+#include "fido2_vault.h"
+#include "fido_drbg.h"
+#include <furi.h>
+#include <furi_hal.h>
+#include <string.h>
+
+#define TAG "FIDO2_VAULT"
+
+#define FIDO2_VAULT_KEY_SLOT FURI_HAL_CRYPTO_ENCLAVE_UNIQUE_KEY_SLOT
+#define FIDO2_VAULT_IV_SIZE  16
+
+/**
+ * @brief AES-CBC over the keys and check block with the enclave unique key
+ *
+ * The enclave key is loaded for this one call and always unloaded again.
+ */
+static bool vault_enclave_crypt(const uint8_t* iv, const uint8_t* in, uint8_t* out, bool encrypt) {
+    size_t len = FIDO2_VAULT_WRAPPED_SIZE - FIDO2_VAULT_IV_SIZE;
+
+    // Check if unique key exists in secure enclave and generate it if missing
+    if(!furi_hal_crypto_enclave_ensure_key(FIDO2_VAULT_KEY_SLOT)) {
+        FURI_LOG_E(TAG, "Unique key unavailable");
+        return false;
+    }
+    if(!furi_hal_crypto_enclave_load_key(FIDO2_VAULT_KEY_SLOT, iv)) {
+        FURI_LOG_E(TAG, "Unable to load encryption key");
+        return false;
+    }
+    bool success = encrypt ? furi_hal_crypto_encrypt(in, out, len) :
+                             furi_hal_crypto_decrypt(in, out, len);
+    furi_hal_crypto_enclave_unload_key(FIDO2_VAULT_KEY_SLOT);
+    if(!success) FURI_LOG_E(TAG, "%s failed", encrypt ? "Encryption" : "Decryption");
+    return success;
+}
+
+static void vault_set_keys(Fido2Vault* vault, const uint8_t* keys) {
+    memcpy(vault->data_key, keys, sizeof(vault->data_key));
+    fido_hmac_key_init(&vault->filter_key, keys + 32, 32);
+    vault->ready = true;
+}
+
+bool fido2_vault_create(Fido2Vault* vault, uint8_t* wrapped) {
+    furi_check(vault && wrapped);
+    fido2_vault_wipe(vault);
+
+    // A zero check block behind the keys tells a wrong unique key on unwrap
+    uint8_t plain[FIDO2_VAULT_WRAPPED_SIZE - FIDO2_VAULT_IV_SIZE] = {0};
+    fido_drbg_fill(plain, FIDO2_VAULT_KEYS_SIZE);
+    fido_drbg_fill(wrapped, FIDO2_VAULT_IV_SIZE);
+
+    uint32_t start = furi_get_tick();
+    bool success = vault_enclave_crypt(wrapped, plain, wrapped + FIDO2_VAULT_IV_SIZE, true);
+    if(success) {
+        vault_set_keys(vault, plain);
+        FURI_LOG_I(TAG, "Keys created in %lu ms", furi_get_tick() - start);
+    }
+    memset(plain, 0, sizeof(plain));
+    return success;
+}
+
+bool fido2_vault_open(Fido2Vault* vault, const uint8_t* wrapped) {
+    furi_check(vault && wrapped);
+    fido2_vault_wipe(vault);
+
+    uint8_t plain[FIDO2_VAULT_WRAPPED_SIZE - FIDO2_VAULT_IV_SIZE];
+    uint32_t start = furi_get_tick();
+    bool success = vault_enclave_crypt(wrapped, wrapped + FIDO2_VAULT_IV_SIZE, plain, false);
+
+    uint8_t check = 0;
+    for(size_t i = FIDO2_VAULT_KEYS_SIZE; i < sizeof(plain); i++) {
+        check |= plain[i];
+    }
+    if(success && check) {
+        FURI_LOG_E(TAG, "Keys were wrapped on another device");
+        success = false;
+    }
+    if(success) {
+        vault_set_keys(vault, plain);
+        FURI_LOG_I(TAG, "Keys unwrapped in %lu ms", furi_get_tick() - start);
+    }
+    memset(plain, 0, sizeof(plain));
+    return success;
+}
+
+void fido2_vault_wipe(Fido2Vault* vault) {
+    furi_check(vault);
+    fido_hmac_key_wipe(&vault->filter_key);
+    memset(vault, 0, sizeof(Fido2Vault));
+}
+
+bool fido2_vault_crypt(
+    const Fido2Vault* vault,
+    const uint8_t* nonce,
+    const uint8_t* in,
+    uint8_t* out,
+    size_t len) {
+    furi_check(vault && vault->ready);
+    uint8_t iv[16] = {0};
+    memcpy(iv, nonce, FIDO2_VAULT_NONCE_SIZE);
+    return furi_hal_crypto_ctr(vault->data_key, iv, in, out, len);
+}
+
+void fido2_vault_tag(const Fido2Vault* vault, const void* data, size_t len, uint8_t* tag) {
+    furi_check(vault && vault->ready);
+    FidoHmac hmac;
+    fido_hmac_start(&hmac, &vault->filter_key);
+    fido_hmac_update(&hmac, data, len);
+    fido_hmac_finish(&hmac, tag);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "fido_hmac.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Keys that encrypt FIDO2 credentials at rest
+ *
+ * A random data key and filter key, stored only wrapped with the unique
+ * key of the secure enclave, as U2F does for its key files. The enclave is
+ * used once, when a page file is created or opened; records are then
+ * encrypted in bulk with AES-256-CTR under the data key, one call per page
+ * or journal entry.
+ *
+ * The filter key turns lookup keys into Bloom filter input, so the
+ * filters on the card do not tell which relying parties are stored.
+ */
+#define FIDO2_VAULT_KEYS_SIZE    64 // data key(32) filter key(32)
+#define FIDO2_VAULT_WRAPPED_SIZE (16 + FIDO2_VAULT_KEYS_SIZE + 16) // iv, keys, check block
+#define FIDO2_VAULT_NONCE_SIZE   12 // the last 4 bytes of the CTR block count blocks
+
+// First nonce byte, so pages and journal entries never share a nonce
+#define FIDO2_VAULT_DOMAIN_PAGE    'P'
+#define FIDO2_VAULT_DOMAIN_JOURNAL 'J'
+
+typedef struct {
+    uint8_t data_key[32];
+    FidoHmacKey filter_key;
+    bool ready;
+} Fido2Vault;
+
+/**
+ * @brief Generate new keys and wrap them with the enclave unique key
+ *
+ * @param[out] wrapped FIDO2_VAULT_WRAPPED_SIZE bytes to store
+ */
+bool fido2_vault_create(Fido2Vault* vault, uint8_t* wrapped);
+
+/**
+ * @brief Unwrap stored keys
+ *
+ * @return false if the enclave fails or the keys were wrapped on another device
+ */
+bool fido2_vault_open(Fido2Vault* vault, const uint8_t* wrapped);
+
+void fido2_vault_wipe(Fido2Vault* vault);
+
+/**
+ * @brief Encrypt or decrypt a block with AES-256-CTR under the data key
+ *
+ * @param nonce FIDO2_VAULT_NONCE_SIZE bytes, never reused for other data
+ */
+bool fido2_vault_crypt(
+    const Fido2Vault* vault,
+    const uint8_t* nonce,
+    const uint8_t* in,
+    uint8_t* out,
+    size_t len);
+
+/**
+ * @brief Keyed hash of a lookup key, for Bloom filters
+ *
+ * @param[out] tag FIDO_HMAC_SIZE bytes
+ */
+void fido2_vault_tag(const Fido2Vault* vault, const void* data, size_t len, uint8_t* tag);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,138 @@
+#include "fido_drbg.h"
+#include "fido_hmac.h"
+
+#include <furi.h>
+#include <furi_hal_random.h>
+
+#include <string.h>
+
+#define TAG "FidoDrbg"
+
+typedef struct {
+    FuriMutex* mutex;
+    uint8_t key[FIDO_HMAC_SIZE];
+    uint8_t v[FIDO_HMAC_SIZE];
+    uint32_t reseed_counter;
+    bool deterministic;
+} FidoDrbg;
+
+static FidoDrbg fido_drbg;
+
+static const uint8_t fido_drbg_personalization[] = "flipper-fido-drbg";
+
+/**
+ * @brief HMAC_DRBG_Update: K = HMAC(K, V || round || data), V = HMAC(K, V)
+ *
+ * data may be split in two parts so callers need no concatenation buffer.
+ */
+static void fido_drbg_update(
+    const uint8_t* data_a,
+    size_t data_a_len,
+    const uint8_t* data_b,
+    size_t data_b_len) {
+    FidoHmacKey key;
+    FidoHmac hmac;
+    bool has_data = data_a_len + data_b_len > 0;
+
+    for(uint8_t round = 0; round < (has_data ? 2 : 1); round++) {
+        fido_hmac_key_init(&key, fido_drbg.key, sizeof(fido_drbg.key));
+        fido_hmac_start(&hmac, &key);
+        fido_hmac_update(&hmac, fido_drbg.v, sizeof(fido_drbg.v));
+        fido_hmac_update(&hmac, &round, 1);
+        fido_hmac_update(&hmac, data_a, data_a_len);
+        fido_hmac_update(&hmac, data_b, data_b_len);
+        fido_hmac_finish(&hmac, fido_drbg.key);
+
+        fido_hmac_key_init(&key, fido_drbg.key, sizeof(fido_drbg.key));
+        fido_hmac_start(&hmac, &key);
+        fido_hmac_update(&hmac, fido_drbg.v, sizeof(fido_drbg.v));
+        fido_hmac_finish(&hmac, fido_drbg.v);
+    }
+
+    fido_hmac_key_wipe(&key);
+}
+
+static void fido_drbg_instantiate(const uint8_t* seed, size_t seed_len) {
+    memset(fido_drbg.key, 0x00, sizeof(fido_drbg.key));
+    memset(fido_drbg.v, 0x01, sizeof(fido_drbg.v));
+    fido_drbg_update(
+        seed,
+        seed_len,
+        fido_drbg_personalization,
+        sizeof(fido_drbg_personalization) - 1);
+    fido_drbg.reseed_counter = 1;
+}
+
+static void fido_drbg_reseed(void) {
+    uint8_t entropy[FIDO_DRBG_SEED_SIZE];
+    furi_hal_random_fill_buf(entropy, sizeof(entropy));
+    fido_drbg_update(entropy, sizeof(entropy), NULL, 0);
+    fido_drbg.reseed_counter = 1;
+    memset(entropy, 0, sizeof(entropy));
+}
+
+void fido_drbg_init(void) {
+    uint8_t seed[FIDO_DRBG_SEED_SIZE];
+    furi_hal_random_fill_buf(seed, sizeof(seed));
+
+    if(!fido_drbg.mutex) fido_drbg.mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    furi_check(furi_mutex_acquire(fido_drbg.mutex, FuriWaitForever) == FuriStatusOk);
+    fido_drbg_instantiate(seed, sizeof(seed));
+    fido_drbg.deterministic = false;
+    furi_mutex_release(fido_drbg.mutex);
+
+    memset(seed, 0, sizeof(seed));
+}
+
+void fido_drbg_init_deterministic(const uint8_t* seed, size_t seed_len) {
+    if(!fido_drbg.mutex) fido_drbg.mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    furi_check(furi_mutex_acquire(fido_drbg.mutex, FuriWaitForever) == FuriStatusOk);
+    fido_drbg_instantiate(seed, seed_len);
+    fido_drbg.deterministic = true;
+    furi_mutex_release(fido_drbg.mutex);
+
+    FURI_LOG_W(TAG, "Deterministic seed, not for real credentials");
+}
+
+void fido_drbg_deinit(void) {
+    if(!fido_drbg.mutex) return;
+    furi_mutex_free(fido_drbg.mutex);
+    memset(&fido_drbg, 0, sizeof(fido_drbg));
+}
+
+void fido_drbg_fill(uint8_t* buf, size_t len) {
+    furi_check(fido_drbg.mutex);
+    furi_check(furi_mutex_acquire(fido_drbg.mutex, FuriWaitForever) == FuriStatusOk);
+
+    if(!fido_drbg.deterministic && fido_drbg.reseed_counter > FIDO_DRBG_RESEED_INTERVAL) {
+        fido_drbg_reseed();
+    }
+
+    // All output blocks of one request use the same K, so its midstates are reused
+    FidoHmacKey key;
+    FidoHmac hmac;
+    fido_hmac_key_init(&key, fido_drbg.key, sizeof(fido_drbg.key));
+    while(len > 0) {
+        fido_hmac_start(&hmac, &key);
+        fido_hmac_update(&hmac, fido_drbg.v, sizeof(fido_drbg.v));
+        fido_hmac_finish(&hmac, fido_drbg.v);
+
+        size_t chunk = len < sizeof(fido_drbg.v) ? len : sizeof(fido_drbg.v);
+        memcpy(buf, fido_drbg.v, chunk);
+        buf += chunk;
+        len -= chunk;
+    }
+    fido_hmac_key_wipe(&key);
+
+    // Backtracking resistance: earlier output cannot be recomputed from the new state
+    fido_drbg_update(NULL, 0, NULL, 0);
+    fido_drbg.reseed_counter++;
+
+    furi_mutex_release(fido_drbg.mutex);
+}
+
+uint32_t fido_drbg_get(void) {
+    uint32_t value;
+    fido_drbg_fill((uint8_t*)&value, sizeof(value));
+    return value;
+}
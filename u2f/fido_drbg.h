@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Shared HMAC-SHA256 DRBG (NIST SP 800-90A) for all random needs
+ *
+ * Seeded from the hardware RNG at start-up and reseeded from it every
+ * FIDO_DRBG_RESEED_INTERVAL requests, so bulk consumers (key generation,
+ * nonces, IVs, handles) run at CPU speed instead of waiting on the RNG
+ * peripheral. Thread safe: U2F, FIDO2 and UI threads share one instance.
+ *
+ * A deterministic seed (fido_drbg_init_deterministic) disables hardware
+ * reseeding so host benchmarks and tests are reproducible. Never use it
+ * on a device.
+ */
+#define FIDO_DRBG_RESEED_INTERVAL 1024
+#define FIDO_DRBG_SEED_SIZE       48 // 256-bit entropy plus 128-bit nonce
+
+/**
+ * @brief Instantiate the shared DRBG from the hardware RNG
+ *
+ * Call once at app start, before any fido_drbg_fill.
+ */
+void fido_drbg_init(void);
+
+/**
+ * @brief Instantiate the shared DRBG from a fixed seed, without reseeding
+ */
+void fido_drbg_init_deterministic(const uint8_t* seed, size_t seed_len);
+
+/**
+ * @brief Wipe the DRBG state
+ */
+void fido_drbg_deinit(void);
+
+/**
+ * @brief Fill a buffer with DRBG output
+ */
+void fido_drbg_fill(uint8_t* buf, size_t len);
+
+/**
+ * @brief One random 32-bit word
+ */
+uint32_t fido_drbg_get(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,72 @@
+#include "fido_hmac.h"
+
+#include <furi.h>
+
+#include <string.h>
+
+#define MCHECK(expr) furi_check((expr) == 0)
+
+void fido_hmac_key_init(FidoHmacKey* key, const uint8_t* secret, size_t secret_len) {
+    furi_check(key);
+    uint8_t block[FIDO_HMAC_BLOCK_SIZE] = {0};
+
+    if(secret_len > FIDO_HMAC_BLOCK_SIZE) {
+        mbedtls_sha256_context ctx;
+        mbedtls_sha256_init(&ctx);
+        MCHECK(mbedtls_sha256_starts(&ctx, 0));
+        MCHECK(mbedtls_sha256_update(&ctx, secret, secret_len));
+        MCHECK(mbedtls_sha256_finish(&ctx, block));
+        mbedtls_sha256_free(&ctx);
+    } else {
+        memcpy(block, secret, secret_len);
+    }
+
+    for(size_t i = 0; i < sizeof(block); i++) {
+        block[i] ^= 0x36;
+    }
+    mbedtls_sha256_init(&key->inner);
+    MCHECK(mbedtls_sha256_starts(&key->inner, 0));
+    MCHECK(mbedtls_sha256_update(&key->inner, block, sizeof(block)));
+
+    // 0x36 ^ 0x5C turns the ipad block into the opad block
+    for(size_t i = 0; i < sizeof(block); i++) {
+        block[i] ^= 0x36 ^ 0x5C;
+    }
+    mbedtls_sha256_init(&key->outer);
+    MCHECK(mbedtls_sha256_starts(&key->outer, 0));
+    MCHECK(mbedtls_sha256_update(&key->outer, block, sizeof(block)));
+
+    memset(block, 0, sizeof(block));
+}
+
+void fido_hmac_key_wipe(FidoHmacKey* key) {
+    if(!key) return;
+    mbedtls_sha256_free(&key->inner);
+    mbedtls_sha256_free(&key->outer);
+    memset(key, 0, sizeof(FidoHmacKey));
+}
+
+void fido_hmac_start(FidoHmac* hmac, const FidoHmacKey* key) {
+    furi_check(hmac && key);
+    hmac->key = key;
+    mbedtls_sha256_init(&hmac->ctx);
+    mbedtls_sha256_clone(&hmac->ctx, &key->inner);
+}
+
+void fido_hmac_update(FidoHmac* hmac, const uint8_t* data, size_t len) {
+    if(len == 0) return;
+    MCHECK(mbedtls_sha256_update(&hmac->ctx, data, len));
+}
+
+void fido_hmac_finish(FidoHmac* hmac, uint8_t* mac) {
+    uint8_t inner_hash[FIDO_HMAC_SIZE];
+    MCHECK(mbedtls_sha256_finish(&hmac->ctx, inner_hash));
+
+    mbedtls_sha256_clone(&hmac->ctx, &hmac->key->outer);
+    MCHECK(mbedtls_sha256_update(&hmac->ctx, inner_hash, sizeof(inner_hash)));
+    MCHECK(mbedtls_sha256_finish(&hmac->ctx, mac));
+
+    mbedtls_sha256_free(&hmac->ctx);
+    memset(inner_hash, 0, sizeof(inner_hash));
+    memset(hmac, 0, sizeof(FidoHmac));
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <mbedtls/sha256.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FIDO_HMAC_SIZE       32
+#define FIDO_HMAC_BLOCK_SIZE 64
+
+/**
+ * @brief HMAC-SHA256 key with cached inner and outer midstates
+ *
+ * The ipad/opad blocks are hashed once when the key is set, so every MAC
+ * under a long-lived key (e.g. the U2F device key) starts from a copy of
+ * the midstate: no md context setup, no heap, two compressions saved.
+ */
+typedef struct {
+    mbedtls_sha256_context inner; // SHA-256 state after (key ^ ipad)
+    mbedtls_sha256_context outer; // SHA-256 state after (key ^ opad)
+} FidoHmacKey;
+
+/**
+ * @brief One HMAC computation in progress
+ */
+typedef struct {
+    const FidoHmacKey* key;
+    mbedtls_sha256_context ctx;
+} FidoHmac;
+
+/**
+ * @brief Precompute the midstates for a key
+ *
+ * Keys longer than FIDO_HMAC_BLOCK_SIZE are hashed first, as in RFC 2104.
+ */
+void fido_hmac_key_init(FidoHmacKey* key, const uint8_t* secret, size_t secret_len);
+
+/**
+ * @brief Wipe cached midstates
+ */
+void fido_hmac_key_wipe(FidoHmacKey* key);
+
+/**
+ * @brief Start a MAC from the cached inner midstate
+ */
+void fido_hmac_start(FidoHmac* hmac, const FidoHmacKey* key);
+
+void fido_hmac_update(FidoHmac* hmac, const uint8_t* data, size_t len);
+
+/**
+ * @brief Finish the MAC and wipe the working state
+ *
+ * @param mac FIDO_HMAC_SIZE bytes
+ */
+void fido_hmac_finish(FidoHmac* hmac, uint8_t* mac);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+#include "fido_keypair_pool.h"
+
+#include <furi.h>
+
+#include <string.h>
+
+#define TAG "FidoKeypairPool"
+
+typedef struct {
+    uint8_t private_key[FIDO_P256_PRIVATE_KEY_SIZE];
+    uint8_t public_key[FIDO_P256_PUBLIC_KEY_SIZE];
+} FidoKeypair;
+
+struct FidoKeypairPool {
+    FidoP256* p256;
+    FidoKeypair keypairs[FIDO_KEYPAIR_POOL_SIZE];
+    uint8_t count;
+    FidoKeypairPoolStats stats;
+};
+
+FidoKeypairPool* fido_keypair_pool_alloc(FidoP256* p256) {
+    furi_check(p256);
+    FidoKeypairPool* pool = malloc(sizeof(FidoKeypairPool));
+    memset(pool, 0, sizeof(FidoKeypairPool));
+    pool->p256 = p256;
+    return pool;
+}
+
+void fido_keypair_pool_free(FidoKeypairPool* pool) {
+    if(!pool) return;
+
+    FURI_LOG_I(
+        TAG,
+        "%lu hits, %lu misses, %lu refills, avg %lu ms, max %lu ms",
+        pool->stats.hits,
+        pool->stats.misses,
+        pool->stats.refills,
+        pool->stats.refills ? pool->stats.refill_time_total_ms / pool->stats.refills : 0,
+        pool->stats.refill_time_max_ms);
+
+    memset(pool, 0, sizeof(FidoKeypairPool));
+    free(pool);
+}
+
+bool fido_keypair_pool_refill(FidoKeypairPool* pool) {
+    furi_check(pool);
+    if(pool->count >= FIDO_KEYPAIR_POOL_SIZE) return false;
+
+    FidoKeypair* keypair = &pool->keypairs[pool->count];
+    uint32_t start = furi_get_tick();
+    if(!fido_p256_keygen(pool->p256, keypair->private_key, keypair->public_key)) return false;
+    uint32_t elapsed = furi_get_tick() - start;
+
+    pool->count++;
+    pool->stats.refills++;
+    pool->stats.refill_time_total_ms += elapsed;
+    if(elapsed > pool->stats.refill_time_max_ms) pool->stats.refill_time_max_ms = elapsed;
+    return true;
+}
+
+bool fido_keypair_pool_keygen(FidoKeypairPool* pool, uint8_t* private_key, uint8_t* public_key) {
+    furi_check(pool);
+
+    if(pool->count == 0) {
+        pool->stats.misses++;
+        return fido_p256_keygen(pool->p256, private_key, public_key);
+    }
+
+    pool->count--;
+    pool->stats.hits++;
+    FidoKeypair* keypair = &pool->keypairs[pool->count];
+    memcpy(private_key, keypair->private_key, FIDO_P256_PRIVATE_KEY_SIZE);
+    memcpy(public_key, keypair->public_key, FIDO_P256_PUBLIC_KEY_SIZE);
+    memset(keypair, 0, sizeof(FidoKeypair));
+    return true;
+}
+
+void fido_keypair_pool_get_stats(FidoKeypairPool* pool, FidoKeypairPoolStats* stats) {
+    furi_check(pool && stats);
+    *stats = pool->stats;
+    stats->available = pool->count;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "fido_p256.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Idle-time pool of ready P-256 key pairs for new credentials
+ *
+ * makeCredential takes a pregenerated pair instead of running keygen
+ * while the host waits. Pairs stay in RAM only and are wiped once handed
+ * out or when the pool is freed. Same threading rule as the nonce pool:
+ * refill and take on the HID worker thread only.
+ */
+#define FIDO_KEYPAIR_POOL_SIZE 2
+
+typedef struct FidoKeypairPool FidoKeypairPool;
+
+typedef struct {
+    uint32_t hits; // key pairs served from the pool
+    uint32_t misses; // key pairs generated on demand
+    uint32_t refills;
+    uint32_t refill_time_total_ms;
+    uint32_t refill_time_max_ms;
+    uint8_t available;
+} FidoKeypairPoolStats;
+
+FidoKeypairPool* fido_keypair_pool_alloc(FidoP256* p256);
+
+/**
+ * @brief Wipe pending key pairs, log the statistics and free the pool
+ */
+void fido_keypair_pool_free(FidoKeypairPool* pool);
+
+/**
+ * @brief Generate one key pair if the pool is not full
+ *
+ * @return true if a key pair was added
+ */
+bool fido_keypair_pool_refill(FidoKeypairPool* pool);
+
+/**
+ * @brief Get a key pair, from the pool if possible, otherwise generated now
+ */
+bool fido_keypair_pool_keygen(FidoKeypairPool* pool, uint8_t* private_key, uint8_t* public_key);
+
+void fido_keypair_pool_get_stats(FidoKeypairPool* pool, FidoKeypairPoolStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
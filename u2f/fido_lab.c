@@ -0,0 +1,141 @@
+#include "fido_lab.h"
+#include <furi.h>
+#include <furi_hal_rtc.h>
+#include <storage/storage.h>
+#include <flipper_format/flipper_format.h>
+#include <mbedtls/sha256.h>
+#include <string.h>
+
+#define TAG "FidoLab"
+
+#define FIDO_LAB_FILE_TYPE "Flipper FIDO Lab Mode"
+#define FIDO_LAB_VERSION   1
+
+#define FIDO_LAB_RATE_WINDOW_MS 60000
+
+struct FidoLab {
+    bool enabled;
+    uint32_t expires; // UNIX timestamp
+    uint32_t max_ops_per_minute;
+    uint8_t rp_id_hashes[FIDO_LAB_MAX_RPS][32];
+    uint32_t rp_count;
+    uint32_t window_start;
+    uint32_t window_ops;
+};
+
+static bool fido_lab_load(FidoLab* lab) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    FlipperFormat* flipper_format = flipper_format_file_alloc(storage);
+    FuriString* str = furi_string_alloc();
+    bool loaded = false;
+
+    do {
+        uint32_t version = 0;
+        if(!flipper_format_file_open_existing(flipper_format, FIDO_LAB_FILE)) break;
+        if(!flipper_format_read_header(flipper_format, str, &version)) break;
+        if(furi_string_cmp_str(str, FIDO_LAB_FILE_TYPE) != 0 || version != FIDO_LAB_VERSION) {
+            FURI_LOG_E(TAG, "Type or version mismatch");
+            break;
+        }
+
+        if(!flipper_format_read_bool(flipper_format, "Enabled", &lab->enabled, 1)) break;
+        if(!flipper_format_read_uint32(flipper_format, "Expires", &lab->expires, 1)) break;
+        if(!flipper_format_read_uint32(
+               flipper_format, "Max_ops_per_minute", &lab->max_ops_per_minute, 1))
+            break;
+        if(!flipper_format_read_uint32(flipper_format, "Rp_count", &lab->rp_count, 1)) break;
+        if(lab->rp_count > FIDO_LAB_MAX_RPS) {
+            FURI_LOG_E(TAG, "Too many RPs: %lu", lab->rp_count);
+            break;
+        }
+
+        // Keep only the rpId hashes: FIDO2 and U2F both identify the RP by SHA-256
+        bool rps_ok = true;
+        for(uint32_t i = 0; i < lab->rp_count; i++) {
+            char key[16];
+            snprintf(key, sizeof(key), "Rp_%lu", i);
+            if(!flipper_format_read_string(flipper_format, key, str)) {
+                rps_ok = false;
+                break;
+            }
+            mbedtls_sha256(
+                (const uint8_t*)furi_string_get_cstr(str),
+                furi_string_size(str),
+                lab->rp_id_hashes[i],
+                0);
+        }
+        if(!rps_ok) break;
+
+        loaded = true;
+    } while(0);
+
+    furi_string_free(str);
+    flipper_format_free(flipper_format);
+    furi_record_close(RECORD_STORAGE);
+
+    return loaded;
+}
+
+FidoLab* fido_lab_alloc(void) {
+    FidoLab* lab = malloc(sizeof(FidoLab));
+    memset(lab, 0, sizeof(FidoLab));
+
+    if(!fido_lab_load(lab)) {
+        memset(lab, 0, sizeof(FidoLab));
+        return lab;
+    }
+
+    // An expiry is mandatory so a forgotten config file cannot stay armed
+    if(lab->enabled && lab->expires == 0) {
+        FURI_LOG_W(TAG, "No expiry set, lab mode disabled");
+        lab->enabled = false;
+    }
+
+    if(fido_lab_is_active(lab)) {
+        FURI_LOG_W(
+            TAG,
+            "Lab mode ACTIVE: %lu RPs, %lu ops/min, expires %lu",
+            lab->rp_count,
+            lab->max_ops_per_minute,
+            lab->expires);
+    }
+
+    return lab;
+}
+
+void fido_lab_free(FidoLab* lab) {
+    if(!lab) return;
+    free(lab);
+}
+
+bool fido_lab_is_active(FidoLab* lab) {
+    if(!lab || !lab->enabled) return false;
+    return furi_hal_rtc_get_timestamp() < lab->expires;
+}
+
+bool fido_lab_auto_presence(FidoLab* lab, const uint8_t* rp_id_hash) {
+    if(!fido_lab_is_active(lab) || !rp_id_hash) return false;
+
+    bool allowed = false;
+    for(uint32_t i = 0; i < lab->rp_count; i++) {
+        if(memcmp(lab->rp_id_hashes[i], rp_id_hash, 32) == 0) {
+            allowed = true;
+            break;
+        }
+    }
+    if(!allowed) return false;
+
+    // Fixed one-minute window
+    uint32_t now = furi_get_tick();
+    if(now - lab->window_start >= furi_ms_to_ticks(FIDO_LAB_RATE_WINDOW_MS)) {
+        lab->window_start = now;
+        lab->window_ops = 0;
+    }
+    if(lab->window_ops >= lab->max_ops_per_minute) {
+        FURI_LOG_W(TAG, "Rate limit reached, falling back to button");
+        return false;
+    }
+
+    lab->window_ops++;
+    return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Test-lab auto-presence policy
+ *
+ * Opt-in mode for unattended CI rigs: while active, user presence is
+ * confirmed automatically for allowlisted relying parties, up to a
+ * per-minute operation budget, until an absolute expiry time. Configured
+ * from FIDO_LAB_FILE on the SD card; without that file the mode is off.
+ *
+ * Example:
+ *   Filetype: Flipper FIDO Lab Mode
+ *   Version: 1
+ *   Enabled: true
+ *   Expires: 1767225600
+ *   Max_ops_per_minute: 120
+ *   Rp_count: 2
+ *   Rp_0: webauthn.io
+ *   Rp_1: localhost
+ */
+#define FIDO_LAB_FILE EXT_PATH("u2f/lab_mode.txt")
+
+#define FIDO_LAB_MAX_RPS 8
+
+typedef struct FidoLab FidoLab;
+
+/**
+ * @brief Allocate policy and load it from FIDO_LAB_FILE
+ *
+ * Always returns an instance; it is inactive if the file is missing,
+ * malformed, disabled or already expired.
+ */
+FidoLab* fido_lab_alloc(void);
+
+/**
+ * @brief Free policy
+ */
+void fido_lab_free(FidoLab* lab);
+
+/**
+ * @brief Check whether lab mode is enabled and not expired
+ */
+bool fido_lab_is_active(FidoLab* lab);
+
+/**
+ * @brief Decide whether to auto-confirm user presence for an operation
+ *
+ * Consumes one operation from the per-minute budget on success.
+ *
+ * @param lab Policy, may be NULL (never auto-confirms)
+ * @param rp_id_hash SHA-256 of the rpId (FIDO2) or the U2F application parameter
+ * @return true if presence may be confirmed without a button press
+ */
+bool fido_lab_auto_presence(FidoLab* lab, const uint8_t* rp_id_hash);
+
+#ifdef __cplusplus
+}
+#endif
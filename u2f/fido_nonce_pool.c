@@ -0,0 +1,98 @@
+#include "fido_nonce_pool.h"
+
+#include <furi.h>
+
+#include <string.h>
+
+#define TAG "FidoNoncePool"
+
+struct FidoNoncePool {
+    FidoP256* p256;
+    FidoP256Nonce nonces[FIDO_NONCE_POOL_SIZE];
+    uint8_t count;
+    FidoNoncePoolStats stats;
+};
+
+FidoNoncePool* fido_nonce_pool_alloc(FidoP256* p256) {
+    furi_check(p256);
+    FidoNoncePool* pool = malloc(sizeof(FidoNoncePool));
+    memset(pool, 0, sizeof(FidoNoncePool));
+    pool->p256 = p256;
+    return pool;
+}
+
+void fido_nonce_pool_free(FidoNoncePool* pool) {
+    if(!pool) return;
+
+    FURI_LOG_I(
+        TAG,
+        "%lu hits, %lu misses, %lu refills, avg %lu ms, max %lu ms",
+        pool->stats.hits,
+        pool->stats.misses,
+        pool->stats.refills,
+        pool->stats.refills ? pool->stats.refill_time_total_ms / pool->stats.refills : 0,
+        pool->stats.refill_time_max_ms);
+
+    memset(pool, 0, sizeof(FidoNoncePool));
+    free(pool);
+}
+
+bool fido_nonce_pool_refill(FidoNoncePool* pool) {
+    furi_check(pool);
+    if(pool->count >= FIDO_NONCE_POOL_SIZE) return false;
+
+    uint32_t start = furi_get_tick();
+    if(!fido_p256_nonce_generate(pool->p256, &pool->nonces[pool->count])) return false;
+    uint32_t elapsed = furi_get_tick() - start;
+
+    pool->count++;
+    pool->stats.refills++;
+    pool->stats.refill_time_total_ms += elapsed;
+    if(elapsed > pool->stats.refill_time_max_ms) pool->stats.refill_time_max_ms = elapsed;
+    return true;
+}
+
+bool fido_nonce_pool_sign(
+    FidoNoncePool* pool,
+    const uint8_t* private_key,
+    const uint8_t* hash,
+    uint8_t* signature) {
+    furi_check(pool);
+
+    if(pool->count == 0) {
+        pool->stats.misses++;
+        return fido_p256_sign(pool->p256, private_key, hash, signature);
+    }
+
+    // Take the newest nonce; signing wipes the slot
+    pool->count--;
+    pool->stats.hits++;
+    return fido_p256_sign_with_nonce(
+        pool->p256, private_key, hash, &pool->nonces[pool->count], signature);
+}
+
+bool fido_nonce_pool_sign_key(
+    FidoNoncePool* pool,
+    const FidoP256Key* key,
+    const uint8_t* hash,
+    uint8_t* signature) {
+    furi_check(pool);
+
+    FidoP256Nonce fresh;
+    FidoP256Nonce* nonce = &fresh;
+    if(pool->count == 0) {
+        pool->stats.misses++;
+        if(!fido_p256_nonce_generate(pool->p256, &fresh)) return false;
+    } else {
+        pool->count--;
+        pool->stats.hits++;
+        nonce = &pool->nonces[pool->count];
+    }
+    return fido_p256_sign_with_key(pool->p256, key, hash, nonce, signature);
+}
+
+void fido_nonce_pool_get_stats(FidoNoncePool* pool, FidoNoncePoolStats* stats) {
+    furi_check(pool && stats);
+    *stats = pool->stats;
+    stats->available = pool->count;
+}
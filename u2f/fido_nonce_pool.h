@@ -0,0 +1,70 @@
+#pragma once
+
+#include "fido_p256.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Idle-time pool of precomputed ECDSA nonces
+ *
+ * The HID worker calls fido_nonce_pool_refill whenever it is idle; signing
+ * then takes a ready (r, k^-1) pair and skips the scalar multiplication.
+ * Each pair is used once and wiped, and the pool lives in RAM only. With
+ * the pool empty, signing falls back to the regular path.
+ *
+ * Not thread safe: refill and sign must run on the same worker thread.
+ */
+#define FIDO_NONCE_POOL_SIZE 4
+
+typedef struct FidoNoncePool FidoNoncePool;
+
+typedef struct {
+    uint32_t hits; // signatures served from the pool
+    uint32_t misses; // signatures that fell back to a full sign
+    uint32_t refills; // nonces generated
+    uint32_t refill_time_total_ms;
+    uint32_t refill_time_max_ms;
+    uint8_t available;
+} FidoNoncePoolStats;
+
+FidoNoncePool* fido_nonce_pool_alloc(FidoP256* p256);
+
+/**
+ * @brief Wipe all pending nonces, log the statistics and free the pool
+ */
+void fido_nonce_pool_free(FidoNoncePool* pool);
+
+/**
+ * @brief Generate one nonce if the pool is not full
+ *
+ * @return true if a nonce was added, false if the pool was already full
+ */
+bool fido_nonce_pool_refill(FidoNoncePool* pool);
+
+/**
+ * @brief ECDSA sign a 32-byte hash, raw R || S output
+ *
+ * Uses a pooled nonce when one is available.
+ */
+bool fido_nonce_pool_sign(
+    FidoNoncePool* pool,
+    const uint8_t* private_key,
+    const uint8_t* hash,
+    uint8_t* signature);
+
+/**
+ * @brief fido_nonce_pool_sign for a key from fido_p256_key_load
+ */
+bool fido_nonce_pool_sign_key(
+    FidoNoncePool* pool,
+    const FidoP256Key* key,
+    const uint8_t* hash,
+    uint8_t* signature);
+
+void fido_nonce_pool_get_stats(FidoNoncePool* pool, FidoNoncePoolStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+#include "fido_p256.h"
+
+#include <string.h>
+
+static size_t fido_p256_der_encode_int(uint8_t* der, const uint8_t* val, size_t val_len) {
+    der[0] = 0x02; // Integer
+
+    size_t len = 2;
+    // Omit leading zeros, keeping at least one byte
+    while(val_len > 1 && val[0] == 0) {
+        ++val;
+        --val_len;
+    }
+
+    // Check if integer is negative
+    if(val[0] > 0x7f) der[len++] = 0;
+
+    memcpy(der + len, val, val_len);
+    len += val_len;
+
+    der[1] = len - 2;
+    return len;
+}
+
+size_t fido_p256_der_encode(const uint8_t* signature, uint8_t* der) {
+    der[0] = 0x30; // Sequence
+
+    size_t len = 2;
+    len += fido_p256_der_encode_int(der + len, signature, FIDO_P256_SIGNATURE_SIZE / 2);
+    len += fido_p256_der_encode_int(
+        der + len, signature + FIDO_P256_SIGNATURE_SIZE / 2, FIDO_P256_SIGNATURE_SIZE / 2);
+
+    der[1] = len - 2;
+    return len;
+}
+
+size_t fido_p256_sign_der(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* hash,
+    uint8_t* der) {
+    uint8_t signature[FIDO_P256_SIGNATURE_SIZE];
+    if(!fido_p256_sign(p256, private_key, hash, signature)) return 0;
+
+    size_t len = fido_p256_der_encode(signature, der);
+    memset(signature, 0, sizeof(signature));
+    return len;
+}
+
+bool fido_p256_sign_with_nonce(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* hash,
+    FidoP256Nonce* nonce,
+    uint8_t* signature) {
+    FidoP256Key key;
+    bool ok = fido_p256_key_load(p256, private_key, &key) &&
+              fido_p256_sign_with_key(p256, &key, hash, nonce, signature);
+    // sign_with_key wipes the nonce, a failed load must too
+    memset(nonce, 0, sizeof(FidoP256Nonce));
+    fido_p256_key_wipe(&key);
+    return ok;
+}
+
+void fido_p256_key_wipe(FidoP256Key* key) {
+    memset(key, 0, sizeof(FidoP256Key));
+}
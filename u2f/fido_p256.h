@@ -0,0 +1,185 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief P-256 (secp256r1) crypto provider
+ *
+ * Small interface over the ECC operations U2F and FIDO2 need, so the
+ * implementation can be swapped at build time:
+ *
+ *   FIDO_P256_BACKEND_MBEDTLS (default) - fixed-base work (keygen, public
+ *     key, nonces) on the const comb table in fido_p256_comb.c, ECDH on
+ *     firmware mbedtls
+ *   FIDO_P256_BACKEND_UECC              - micro-ecc, tuned for Cortex-M.
+ *     Add micro-ecc to fap_private_libs and build with
+ *     -DFIDO_P256_BACKEND=FIDO_P256_BACKEND_UECC -DuECC_OPTIMIZATION_LEVEL=3
+ *     -DuECC_SQUARE_FUNC=1 -DuECC_ENABLE_VLI_API=1 -DuECC_SUPPORTS_secp256r1=1
+ *     (other curves off)
+ *
+ * Keys and scalars are 32-byte big endian, public keys are raw X || Y and
+ * raw signatures are R || S. tools/p256_bench compares the backends.
+ */
+#define FIDO_P256_BACKEND_MBEDTLS 1
+#define FIDO_P256_BACKEND_UECC    2
+
+#ifndef FIDO_P256_BACKEND
+#define FIDO_P256_BACKEND FIDO_P256_BACKEND_MBEDTLS
+#endif
+
+#define FIDO_P256_PRIVATE_KEY_SIZE       32
+#define FIDO_P256_PUBLIC_KEY_SIZE        64
+#define FIDO_P256_HASH_SIZE              32
+#define FIDO_P256_SIGNATURE_SIZE         64
+#define FIDO_P256_SHARED_SECRET_SIZE     32
+#define FIDO_P256_DER_SIGNATURE_MAX_SIZE 72
+
+typedef struct FidoP256 FidoP256;
+
+/**
+ * @brief Precomputed ECDSA nonce: r = (k * G).x mod n and k^-1 mod n
+ *
+ * Single use only. fido_p256_sign_with_nonce wipes it; never persist it.
+ */
+typedef struct {
+    uint8_t r[FIDO_P256_SIGNATURE_SIZE / 2];
+    uint8_t k_inv[FIDO_P256_PRIVATE_KEY_SIZE];
+} FidoP256Nonce;
+
+/**
+ * @brief Private key parsed into the backend's signing form
+ *
+ * Lets callers that sign repeatedly with one key (e.g. the FIDO2 store's
+ * key cache) skip parsing and range checks. Secret: wipe after use.
+ */
+typedef struct {
+    uint32_t words[FIDO_P256_PRIVATE_KEY_SIZE / sizeof(uint32_t)];
+} FidoP256Key;
+
+/**
+ * @brief Called between slices of a long operation (scalar multiplication)
+ *
+ * Runs on the calling thread, so a single worker can service its transport
+ * mid-operation.
+ *
+ * @return false to abort; the operation then fails
+ */
+typedef bool (*FidoP256YieldCallback)(void* context);
+
+/**
+ * @brief Allocate provider state (curve parameters are loaded once here)
+ */
+FidoP256* fido_p256_alloc(void);
+
+void fido_p256_free(FidoP256* p256);
+
+/**
+ * @brief Set the callback invoked between slices of keygen, public key and
+ * nonce generation, or NULL to run them in one piece
+ *
+ * Only the comb-based backend slices its work; micro-ecc ignores it.
+ */
+void fido_p256_set_yield_callback(FidoP256* p256, FidoP256YieldCallback callback, void* context);
+
+/**
+ * @brief Name of the compiled-in backend, for logs and benchmarks
+ */
+const char* fido_p256_backend_name(void);
+
+/**
+ * @brief Generate a random key pair
+ */
+bool fido_p256_keygen(FidoP256* p256, uint8_t* private_key, uint8_t* public_key);
+
+/**
+ * @brief Compute the public key for a private key
+ *
+ * @return false if the private key is out of range
+ */
+bool fido_p256_public_key(FidoP256* p256, const uint8_t* private_key, uint8_t* public_key);
+
+/**
+ * @brief ECDSA sign a 32-byte hash, raw R || S output
+ */
+bool fido_p256_sign(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* hash,
+    uint8_t* signature);
+
+/**
+ * @brief Precompute a random ECDSA nonce (one scalar multiplication)
+ */
+bool fido_p256_nonce_generate(FidoP256* p256, FidoP256Nonce* nonce);
+
+/**
+ * @brief ECDSA sign a 32-byte hash with a precomputed nonce, raw R || S output
+ *
+ * Costs two modular multiplications instead of a scalar multiplication.
+ * The nonce is wiped whether or not signing succeeds.
+ */
+bool fido_p256_sign_with_nonce(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* hash,
+    FidoP256Nonce* nonce,
+    uint8_t* signature);
+
+/**
+ * @brief Parse a private key for fido_p256_sign_with_key
+ *
+ * @return false if the private key is out of range
+ */
+bool fido_p256_key_load(FidoP256* p256, const uint8_t* private_key, FidoP256Key* key);
+
+void fido_p256_key_wipe(FidoP256Key* key);
+
+/**
+ * @brief fido_p256_sign_with_nonce for a key from fido_p256_key_load
+ */
+bool fido_p256_sign_with_key(
+    FidoP256* p256,
+    const FidoP256Key* key,
+    const uint8_t* hash,
+    FidoP256Nonce* nonce,
+    uint8_t* signature);
+
+/**
+ * @brief ECDSA sign a 32-byte hash, DER (X9.62) output
+ *
+ * @param der Output, at least FIDO_P256_DER_SIGNATURE_MAX_SIZE bytes
+ * @return DER length, 0 on failure
+ */
+size_t fido_p256_sign_der(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* hash,
+    uint8_t* der);
+
+/**
+ * @brief ECDH shared secret (X coordinate of private_key * peer_public_key)
+ *
+ * @return false if the peer key is not a valid curve point
+ */
+bool fido_p256_ecdh(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* peer_public_key,
+    uint8_t* shared_secret);
+
+/**
+ * @brief Encode a raw R || S signature as DER
+ *
+ * @return DER length, at most FIDO_P256_DER_SIGNATURE_MAX_SIZE
+ */
+size_t fido_p256_der_encode(const uint8_t* signature, uint8_t* der);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,571 @@
+#include "fido_p256_comb.h"
+#include "fido_p256_comb_table.h"
+
+#include <string.h>
+
+#define FIDO_P256_LIMBS 8
+
+// Exponent bits of an inversion between yields, roughly a comb slice of work
+#define FIDO_P256_INV_SLICE_BITS 64
+
+typedef struct {
+    uint32_t x[FIDO_P256_LIMBS];
+    uint32_t y[FIDO_P256_LIMBS];
+    uint32_t z[FIDO_P256_LIMBS];
+} FidoP256Point; // projective, coordinates in the Montgomery domain mod p
+
+static const uint32_t fido_p256_one[FIDO_P256_LIMBS] = {1, 0, 0, 0, 0, 0, 0, 0};
+
+static void fe_from_bytes(uint32_t* out, const uint8_t* in) {
+    for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+        const uint8_t* b = in + 28 - 4 * i;
+        out[i] = ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+    }
+}
+
+static void fe_to_bytes(uint8_t* out, const uint32_t* in) {
+    for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+        uint8_t* b = out + 28 - 4 * i;
+        b[0] = in[i] >> 24;
+        b[1] = in[i] >> 16;
+        b[2] = in[i] >> 8;
+        b[3] = in[i];
+    }
+}
+
+/**
+ * @brief r = mask ? a : r, mask is 0 or all ones
+ */
+static void fe_cmov(uint32_t* r, const uint32_t* a, uint32_t mask) {
+    for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+        r[i] ^= mask & (r[i] ^ a[i]);
+    }
+}
+
+static uint32_t fe_is_zero_mask(const uint32_t* a) {
+    uint32_t acc = 0;
+    for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+        acc |= a[i];
+    }
+    // All ones if acc == 0
+    return (uint32_t)(((uint64_t)acc - 1) >> 32);
+}
+
+static uint32_t fe_add_raw(uint32_t* r, const uint32_t* a, const uint32_t* b) {
+    uint64_t carry = 0;
+    for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+        carry += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    return (uint32_t)carry;
+}
+
+static uint32_t fe_sub_raw(uint32_t* r, const uint32_t* a, const uint32_t* b) {
+    int64_t borrow = 0;
+    for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+        borrow += (int64_t)a[i] - b[i];
+        r[i] = (uint32_t)borrow;
+        borrow >>= 32; // arithmetic shift: 0 or -1
+    }
+    return (uint32_t)(borrow & 1);
+}
+
+static void mod_add(uint32_t* r, const uint32_t* a, const uint32_t* b, const uint32_t* m) {
+    uint32_t sum[FIDO_P256_LIMBS];
+    uint32_t reduced[FIDO_P256_LIMBS];
+    uint32_t carry = fe_add_raw(sum, a, b);
+    uint32_t borrow = fe_sub_raw(reduced, sum, m);
+    // Take the reduced value if the sum overflowed or is at least m
+    fe_cmov(sum, reduced, 0 - (carry | (borrow ^ 1)));
+    memcpy(r, sum, sizeof(sum));
+}
+
+static void mod_sub(uint32_t* r, const uint32_t* a, const uint32_t* b, const uint32_t* m) {
+    uint32_t diff[FIDO_P256_LIMBS];
+    uint32_t wrapped[FIDO_P256_LIMBS];
+    uint32_t borrow = fe_sub_raw(diff, a, b);
+    fe_add_raw(wrapped, diff, m);
+    fe_cmov(diff, wrapped, 0 - borrow);
+    memcpy(r, diff, sizeof(diff));
+}
+
+// UMAAL is there on the Cortex-M4 but stays opt-in (-DFIDO_P256_COMB_UMAAL=1)
+// until tools/p256_bench/comb_check.c has passed on an ARM build under qemu
+#ifndef FIDO_P256_COMB_UMAAL
+#define FIDO_P256_COMB_UMAAL 0
+#endif
+
+// comb_check.c defines this to count multiply-accumulate steps per operation
+#ifndef FIDO_P256_COMB_COUNT_STEP
+#define FIDO_P256_COMB_COUNT_STEP()
+#endif
+
+/**
+ * @brief (hi:lo) = a * b + lo + hi, which cannot overflow 64 bits
+ */
+static inline void mul_add_add_c(uint32_t* lo, uint32_t* hi, uint32_t a, uint32_t b) {
+    uint64_t acc = (uint64_t)a * b + *lo + *hi;
+    *lo = (uint32_t)acc;
+    *hi = (uint32_t)(acc >> 32);
+}
+
+/**
+ * @brief mul_add_add_c as a single UMAAL where available
+ *
+ * One cycle on the Cortex-M4, against UMULL plus two add-with-carry pairs
+ * (about 5 cycles) for what compilers emit from the C form.
+ */
+static inline void mul_add_add(uint32_t* lo, uint32_t* hi, uint32_t a, uint32_t b) {
+    FIDO_P256_COMB_COUNT_STEP();
+#if FIDO_P256_COMB_UMAAL
+    __asm__("umaal %0, %1, %2, %3" : "+r"(*lo), "+r"(*hi) : "r"(a), "r"(b));
+#else
+    mul_add_add_c(lo, hi, a, b);
+#endif
+}
+
+/**
+ * @brief Montgomery multiplication r = a * b * 2^-256 mod m (CIOS), inputs below m
+ */
+static void mont_mul(
+    uint32_t* r,
+    const uint32_t* a,
+    const uint32_t* b,
+    const uint32_t* m,
+    uint32_t m0inv) {
+    uint32_t t[FIDO_P256_LIMBS + 2] = {0};
+
+    for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+        uint32_t carry = 0;
+        for(size_t j = 0; j < FIDO_P256_LIMBS; j++) {
+            mul_add_add(&t[j], &carry, a[j], b[i]);
+        }
+        uint64_t acc = (uint64_t)t[FIDO_P256_LIMBS] + carry;
+        t[FIDO_P256_LIMBS] = (uint32_t)acc;
+        t[FIDO_P256_LIMBS + 1] = (uint32_t)(acc >> 32);
+
+        uint32_t u = t[0] * m0inv;
+        uint32_t low = t[0];
+        carry = 0;
+        mul_add_add(&low, &carry, u, m[0]); // low becomes 0 by choice of u
+        for(size_t j = 1; j < FIDO_P256_LIMBS; j++) {
+            low = t[j];
+            mul_add_add(&low, &carry, u, m[j]);
+            t[j - 1] = low;
+        }
+        acc = (uint64_t)t[FIDO_P256_LIMBS] + carry;
+        t[FIDO_P256_LIMBS - 1] = (uint32_t)acc;
+        t[FIDO_P256_LIMBS] = t[FIDO_P256_LIMBS + 1] + (uint32_t)(acc >> 32);
+    }
+
+    uint32_t reduced[FIDO_P256_LIMBS];
+    uint32_t borrow = fe_sub_raw(reduced, t, m);
+    fe_cmov(t, reduced, 0 - (t[FIDO_P256_LIMBS] | (borrow ^ 1)));
+    memcpy(r, t, sizeof(uint32_t) * FIDO_P256_LIMBS);
+}
+
+/**
+ * @brief Montgomery squaring r = a * a * 2^-256 mod m, input below m
+ *
+ * Computes the full square first, with each cross product a[i] * a[j]
+ * taken once and doubled, then reduces it: 100 multiply-accumulate steps
+ * against 128 for mont_mul.
+ */
+static void mont_sqr(uint32_t* r, const uint32_t* a, const uint32_t* m, uint32_t m0inv) {
+    uint32_t t[2 * FIDO_P256_LIMBS] = {0};
+
+    // Cross products, i < j
+    for(size_t i = 0; i < FIDO_P256_LIMBS - 1; i++) {
+        uint32_t carry = 0;
+        for(size_t j = i + 1; j < FIDO_P256_LIMBS; j++) {
+            mul_add_add(&t[i + j], &carry, a[i], a[j]);
+        }
+        t[i + FIDO_P256_LIMBS] = carry;
+    }
+
+    // Double them; no bit is lost, their sum is below a^2 / 2
+    for(size_t i = 2 * FIDO_P256_LIMBS - 1; i > 0; i--) {
+        t[i] = (t[i] << 1) | (t[i - 1] >> 31);
+    }
+    t[0] <<= 1;
+
+    // Add the squares a[i]^2
+    uint32_t carry = 0;
+    for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+        mul_add_add(&t[2 * i], &carry, a[i], a[i]);
+        uint64_t acc = (uint64_t)t[2 * i + 1] + carry;
+        t[2 * i + 1] = (uint32_t)acc;
+        carry = (uint32_t)(acc >> 32);
+    }
+
+    // Reduce one limb per row, carrying the row overflow into the next
+    uint32_t extra = 0;
+    for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+        uint32_t u = t[i] * m0inv;
+        carry = 0;
+        for(size_t j = 0; j < FIDO_P256_LIMBS; j++) {
+            mul_add_add(&t[i + j], &carry, u, m[j]);
+        }
+        uint64_t acc = (uint64_t)t[i + FIDO_P256_LIMBS] + carry + extra;
+        t[i + FIDO_P256_LIMBS] = (uint32_t)acc;
+        extra = (uint32_t)(acc >> 32);
+    }
+
+    uint32_t* high = t + FIDO_P256_LIMBS;
+    uint32_t reduced[FIDO_P256_LIMBS];
+    uint32_t borrow = fe_sub_raw(reduced, high, m);
+    fe_cmov(high, reduced, 0 - (extra | (borrow ^ 1)));
+    memcpy(r, high, sizeof(uint32_t) * FIDO_P256_LIMBS);
+}
+
+/**
+ * @brief r = a^(m - 2) in the Montgomery domain, i.e. the inverse for prime m
+ *
+ * The exponent is public, so plain square-and-multiply is fine. Yields
+ * every FIDO_P256_INV_SLICE_BITS exponent bits.
+ *
+ * @return false if the yield callback asked to abort
+ */
+static bool mont_inv(
+    uint32_t* r,
+    const uint32_t* a,
+    const uint32_t* m,
+    uint32_t m0inv,
+    const uint32_t* mont_one,
+    FidoP256CombYield yield,
+    void* context) {
+    uint32_t exponent[FIDO_P256_LIMBS];
+    uint32_t acc[FIDO_P256_LIMBS];
+    memcpy(exponent, m, sizeof(exponent));
+    exponent[0] -= 2; // no borrow: the low limb of p and n is above 2
+    memcpy(acc, mont_one, sizeof(acc));
+
+    for(int bit = 255; bit >= 0; bit--) {
+        mont_sqr(acc, acc, m, m0inv);
+        if((exponent[bit / 32] >> (bit % 32)) & 1) mont_mul(acc, acc, a, m, m0inv);
+        if(yield && bit % FIDO_P256_INV_SLICE_BITS == 0 && bit > 0 && !yield(context)) {
+            memset(acc, 0, sizeof(acc));
+            return false;
+        }
+    }
+    memcpy(r, acc, sizeof(acc));
+    memset(acc, 0, sizeof(acc));
+    return true;
+}
+
+static void fe_mul(uint32_t* r, const uint32_t* a, const uint32_t* b) {
+    mont_mul(r, a, b, FIDO_P256_P, FIDO_P256_P_M0INV);
+}
+
+static void fe_sqr(uint32_t* r, const uint32_t* a) {
+    mont_sqr(r, a, FIDO_P256_P, FIDO_P256_P_M0INV);
+}
+
+static void fe_add(uint32_t* r, const uint32_t* a, const uint32_t* b) {
+    mod_add(r, a, b, FIDO_P256_P);
+}
+
+static void fe_sub(uint32_t* r, const uint32_t* a, const uint32_t* b) {
+    mod_sub(r, a, b, FIDO_P256_P);
+}
+
+/**
+ * @brief r = 2 * p, complete doubling for a = -3 (Renes-Costello-Batina, alg. 6)
+ */
+static void point_double(FidoP256Point* r, const FidoP256Point* p) {
+    uint32_t t0[FIDO_P256_LIMBS], t1[FIDO_P256_LIMBS], t2[FIDO_P256_LIMBS];
+    uint32_t t3[FIDO_P256_LIMBS];
+    uint32_t x3[FIDO_P256_LIMBS], y3[FIDO_P256_LIMBS], z3[FIDO_P256_LIMBS];
+
+    fe_sqr(t0, p->x);
+    fe_sqr(t1, p->y);
+    fe_sqr(t2, p->z);
+    fe_mul(t3, p->x, p->y);
+    fe_add(t3, t3, t3);
+    fe_mul(z3, p->x, p->z);
+    fe_add(z3, z3, z3);
+    fe_mul(y3, FIDO_P256_B_MONT, t2);
+    fe_sub(y3, y3, z3);
+    fe_add(x3, y3, y3);
+    fe_add(y3, x3, y3);
+    fe_sub(x3, t1, y3);
+    fe_add(y3, t1, y3);
+    fe_mul(y3, x3, y3);
+    fe_mul(x3, x3, t3);
+    fe_add(t3, t2, t2);
+    fe_add(t2, t2, t3);
+    fe_mul(z3, FIDO_P256_B_MONT, z3);
+    fe_sub(z3, z3, t2);
+    fe_sub(z3, z3, t0);
+    fe_add(t3, z3, z3);
+    fe_add(z3, z3, t3);
+    fe_add(t3, t0, t0);
+    fe_add(t0, t3, t0);
+    fe_sub(t0, t0, t2);
+    fe_mul(t0, t0, z3);
+    fe_add(y3, y3, t0);
+    fe_mul(t0, p->y, p->z);
+    fe_add(t0, t0, t0);
+    fe_mul(z3, t0, z3);
+    fe_sub(x3, x3, z3);
+    fe_mul(z3, t0, t1);
+    fe_add(z3, z3, z3);
+    fe_add(z3, z3, z3);
+
+    memcpy(r->x, x3, sizeof(x3));
+    memcpy(r->y, y3, sizeof(y3));
+    memcpy(r->z, z3, sizeof(z3));
+}
+
+/**
+ * @brief r = p + (x2, y2), complete mixed addition for a = -3 (RCB, alg. 5)
+ *
+ * p may be the point at infinity; the affine point may not.
+ */
+static void point_add_affine(
+    FidoP256Point* r,
+    const FidoP256Point* p,
+    const uint32_t* x2,
+    const uint32_t* y2) {
+    uint32_t t0[FIDO_P256_LIMBS], t1[FIDO_P256_LIMBS], t2[FIDO_P256_LIMBS];
+    uint32_t t3[FIDO_P256_LIMBS], t4[FIDO_P256_LIMBS];
+    uint32_t x3[FIDO_P256_LIMBS], y3[FIDO_P256_LIMBS], z3[FIDO_P256_LIMBS];
+
+    fe_mul(t0, p->x, x2);
+    fe_mul(t1, p->y, y2);
+    fe_add(t3, x2, y2);
+    fe_add(t4, p->x, p->y);
+    fe_mul(t3, t3, t4);
+    fe_add(t4, t0, t1);
+    fe_sub(t3, t3, t4);
+    fe_mul(t4, y2, p->z);
+    fe_add(t4, t4, p->y);
+    fe_mul(y3, x2, p->z);
+    fe_add(y3, y3, p->x);
+    fe_mul(z3, FIDO_P256_B_MONT, p->z);
+    fe_sub(x3, y3, z3);
+    fe_add(z3, x3, x3);
+    fe_add(x3, x3, z3);
+    fe_sub(z3, t1, x3);
+    fe_add(x3, t1, x3);
+    fe_mul(y3, FIDO_P256_B_MONT, y3);
+    fe_add(t1, p->z, p->z);
+    fe_add(t2, t1, p->z);
+    fe_sub(y3, y3, t2);
+    fe_sub(y3, y3, t0);
+    fe_add(t1, y3, y3);
+    fe_add(y3, t1, y3);
+    fe_add(t1, t0, t0);
+    fe_add(t0, t1, t0);
+    fe_sub(t0, t0, t2);
+    fe_mul(t1, t4, y3);
+    fe_mul(t2, t0, y3);
+    fe_mul(y3, x3, z3);
+    fe_add(y3, y3, t2);
+    fe_mul(x3, t3, x3);
+    fe_sub(x3, x3, t1);
+    fe_mul(z3, t4, z3);
+    fe_mul(t1, t3, t0);
+    fe_add(z3, z3, t1);
+
+    memcpy(r->x, x3, sizeof(x3));
+    memcpy(r->y, y3, sizeof(y3));
+    memcpy(r->z, z3, sizeof(z3));
+}
+
+/**
+ * @brief Constant-time table lookup: every entry is read, digit 0 yields entry 1
+ */
+static void comb_lookup(uint32_t* x, uint32_t* y, uint32_t digit) {
+    memcpy(x, FIDO_P256_COMB_TABLE[0], sizeof(uint32_t) * FIDO_P256_LIMBS);
+    memcpy(y, FIDO_P256_COMB_TABLE[0] + FIDO_P256_LIMBS, sizeof(uint32_t) * FIDO_P256_LIMBS);
+    for(uint32_t i = 1; i < FIDO_P256_COMB_POINTS; i++) {
+        uint32_t mask = (uint32_t)(((uint64_t)(digit ^ (i + 1)) - 1) >> 32);
+        fe_cmov(x, FIDO_P256_COMB_TABLE[i], mask);
+        fe_cmov(y, FIDO_P256_COMB_TABLE[i] + FIDO_P256_LIMBS, mask);
+    }
+}
+
+static uint32_t scalar_is_valid_mask(const uint32_t* k) {
+    uint32_t reduced[FIDO_P256_LIMBS];
+    uint32_t below_n = fe_sub_raw(reduced, k, FIDO_P256_N);
+    return (0 - below_n) & ~fe_is_zero_mask(k);
+}
+
+bool fido_p256_comb_scalar_is_valid(const uint8_t* scalar) {
+    uint32_t k[FIDO_P256_LIMBS];
+    fe_from_bytes(k, scalar);
+    bool valid = scalar_is_valid_mask(k) != 0;
+    memset(k, 0, sizeof(k));
+    return valid;
+}
+
+/**
+ * @brief Affine x and y (normal domain) of k * G, k already validated
+ *
+ * Runs in slices of FIDO_P256_COMB_SLICE_COLUMNS columns; between slices
+ * the yield callback (if any) may service the transport or abort.
+ *
+ * @return false if aborted
+ */
+static bool comb_mul_base(
+    uint32_t* x,
+    uint32_t* y,
+    const uint32_t* k,
+    FidoP256CombYield yield,
+    void* context) {
+    FidoP256Point q;
+    FidoP256Point sum;
+    uint32_t ax[FIDO_P256_LIMBS], ay[FIDO_P256_LIMBS];
+    uint32_t z_inv[FIDO_P256_LIMBS];
+    bool ok = true;
+
+    // Start from the point at infinity (0 : 1 : 0)
+    memset(&q, 0, sizeof(q));
+    memcpy(q.y, FIDO_P256_P_ONE, sizeof(q.y));
+
+    for(int column = FIDO_P256_COMB_SPACING - 1; column >= 0 && ok; column--) {
+        point_double(&q, &q);
+
+        uint32_t digit = 0;
+        for(int tooth = 0; tooth < FIDO_P256_COMB_TEETH; tooth++) {
+            int bit = tooth * FIDO_P256_COMB_SPACING + column;
+            if(bit < 256) digit |= ((k[bit / 32] >> (bit % 32)) & 1) << tooth;
+        }
+
+        comb_lookup(ax, ay, digit);
+        point_add_affine(&sum, &q, ax, ay);
+        uint32_t take = ~(uint32_t)(((uint64_t)digit - 1) >> 32); // all ones if digit != 0
+        fe_cmov(q.x, sum.x, take);
+        fe_cmov(q.y, sum.y, take);
+        fe_cmov(q.z, sum.z, take);
+
+        if(yield && column % FIDO_P256_COMB_SLICE_COLUMNS == 0) ok = yield(context);
+    }
+
+    if(ok) {
+        ok = mont_inv(
+            z_inv, q.z, FIDO_P256_P, FIDO_P256_P_M0INV, FIDO_P256_P_ONE, yield, context);
+    }
+    if(ok) {
+        fe_mul(x, q.x, z_inv);
+        fe_mul(y, q.y, z_inv);
+        // Leave the Montgomery domain
+        fe_mul(x, x, fido_p256_one);
+        fe_mul(y, y, fido_p256_one);
+    }
+
+    memset(&q, 0, sizeof(q));
+    memset(&sum, 0, sizeof(sum));
+    memset(ax, 0, sizeof(ax));
+    memset(ay, 0, sizeof(ay));
+    return ok;
+}
+
+bool fido_p256_comb_mul_base(
+    const uint8_t* scalar,
+    uint8_t* point,
+    FidoP256CombYield yield,
+    void* context) {
+    uint32_t k[FIDO_P256_LIMBS];
+    uint32_t x[FIDO_P256_LIMBS], y[FIDO_P256_LIMBS];
+
+    fe_from_bytes(k, scalar);
+    bool ok = scalar_is_valid_mask(k) != 0 && comb_mul_base(x, y, k, yield, context);
+    if(ok) {
+        fe_to_bytes(point, x);
+        fe_to_bytes(point + 32, y);
+    }
+
+    memset(k, 0, sizeof(k));
+    return ok;
+}
+
+/**
+ * @brief r = a mod n for a < 2^256 (n > 2^255, so one subtraction is enough)
+ */
+static void scalar_reduce(uint32_t* a) {
+    uint32_t reduced[FIDO_P256_LIMBS];
+    uint32_t borrow = fe_sub_raw(reduced, a, FIDO_P256_N);
+    fe_cmov(a, reduced, borrow - 1);
+}
+
+static void scalar_mul(uint32_t* r, const uint32_t* a, const uint32_t* b) {
+    // (a * R^2 * R^-1) * b * R^-1 = a * b
+    uint32_t a_mont[FIDO_P256_LIMBS];
+    mont_mul(a_mont, a, FIDO_P256_N_R2, FIDO_P256_N, FIDO_P256_N_M0INV);
+    mont_mul(r, a_mont, b, FIDO_P256_N, FIDO_P256_N_M0INV);
+    memset(a_mont, 0, sizeof(a_mont));
+}
+
+bool fido_p256_comb_nonce(
+    const uint8_t* k,
+    uint8_t* r,
+    uint8_t* k_inv,
+    FidoP256CombYield yield,
+    void* context) {
+    uint32_t k_limbs[FIDO_P256_LIMBS];
+    uint32_t x[FIDO_P256_LIMBS], y[FIDO_P256_LIMBS];
+    uint32_t mont_one[FIDO_P256_LIMBS];
+    uint32_t k_mont[FIDO_P256_LIMBS];
+
+    fe_from_bytes(k_limbs, k);
+    bool ok = scalar_is_valid_mask(k_limbs) != 0 && comb_mul_base(x, y, k_limbs, yield, context);
+    if(ok) {
+        scalar_reduce(x);
+        ok = fe_is_zero_mask(x) == 0;
+    }
+    if(ok) {
+        mont_mul(mont_one, fido_p256_one, FIDO_P256_N_R2, FIDO_P256_N, FIDO_P256_N_M0INV);
+        mont_mul(k_mont, k_limbs, FIDO_P256_N_R2, FIDO_P256_N, FIDO_P256_N_M0INV);
+        ok = mont_inv(k_mont, k_mont, FIDO_P256_N, FIDO_P256_N_M0INV, mont_one, yield, context);
+    }
+    if(ok) {
+        fe_to_bytes(r, x);
+        mont_mul(k_limbs, k_mont, fido_p256_one, FIDO_P256_N, FIDO_P256_N_M0INV);
+        fe_to_bytes(k_inv, k_limbs);
+    }
+
+    memset(k_limbs, 0, sizeof(k_limbs));
+    memset(k_mont, 0, sizeof(k_mont));
+    return ok;
+}
+
+bool fido_p256_comb_scalar_load(const uint8_t* private_key, uint32_t* loaded) {
+    uint32_t d[FIDO_P256_LIMBS];
+    fe_from_bytes(d, private_key);
+    bool valid = scalar_is_valid_mask(d) != 0;
+    if(valid) mont_mul(loaded, d, FIDO_P256_N_R2, FIDO_P256_N, FIDO_P256_N_M0INV);
+    memset(d, 0, sizeof(d));
+    return valid;
+}
+
+bool fido_p256_comb_ecdsa_s(
+    const uint32_t* loaded,
+    const uint8_t* hash,
+    const uint8_t* r,
+    const uint8_t* k_inv,
+    uint8_t* s) {
+    uint32_t acc[FIDO_P256_LIMBS], e[FIDO_P256_LIMBS];
+    uint32_t r_limbs[FIDO_P256_LIMBS], k_inv_limbs[FIDO_P256_LIMBS];
+
+    fe_from_bytes(e, hash);
+    fe_from_bytes(r_limbs, r);
+    fe_from_bytes(k_inv_limbs, k_inv);
+    scalar_reduce(e);
+
+    bool ok = scalar_is_valid_mask(r_limbs) != 0 && scalar_is_valid_mask(k_inv_limbs) != 0;
+    if(ok) {
+        // s = k^-1 * (e + r * d) mod n; d is already in the Montgomery domain
+        mont_mul(acc, r_limbs, loaded, FIDO_P256_N, FIDO_P256_N_M0INV);
+        mod_add(acc, acc, e, FIDO_P256_N);
+        scalar_mul(acc, k_inv_limbs, acc);
+        ok = fe_is_zero_mask(acc) == 0;
+    }
+    if(ok) fe_to_bytes(s, acc);
+
+    memset(acc, 0, sizeof(acc));
+    memset(k_inv_limbs, 0, sizeof(k_inv_limbs));
+    return ok;
+}
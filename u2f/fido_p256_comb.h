@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Native P-256 fixed-base arithmetic
+ *
+ * k * G is computed with a comb over a const table generated by
+ * tools/gen_p256_comb.py (fido_p256_comb_table.h): no heap, no runtime
+ * precomputation, and all secret-dependent table lookups and selections
+ * are constant time. Field and scalar arithmetic use 32-bit Montgomery
+ * multiplication; points use complete projective formulas.
+ *
+ * All scalars and coordinates are 32-byte big endian.
+ *
+ * Base multiplications are cooperative: every FIDO_P256_COMB_SLICE_COLUMNS
+ * comb columns (and every few inversion bits) they call an optional yield
+ * callback, so a single worker thread can keep servicing its transport
+ * and abort the operation, e.g. on CTAPHID_CANCEL.
+ */
+#define FIDO_P256_COMB_SLICE_COLUMNS 4
+
+/**
+ * @brief Called between slices of a multiplication
+ *
+ * @return false to abort the operation
+ */
+typedef bool (*FidoP256CombYield)(void* context);
+
+/**
+ * @brief Check that a scalar is in [1, n - 1]
+ */
+bool fido_p256_comb_scalar_is_valid(const uint8_t* scalar);
+
+/**
+ * @brief point = scalar * G, raw X || Y output
+ *
+ * @param yield optional, see FidoP256CombYield
+ * @return false if the scalar is not in [1, n - 1] or the yield callback aborted
+ */
+bool fido_p256_comb_mul_base(
+    const uint8_t* scalar,
+    uint8_t* point,
+    FidoP256CombYield yield,
+    void* context);
+
+/**
+ * @brief ECDSA nonce values for k: r = (k * G).x mod n, k_inv = k^-1 mod n
+ *
+ * @param yield optional, see FidoP256CombYield
+ * @return false if k is out of range, r is zero or the yield callback aborted
+ */
+bool fido_p256_comb_nonce(
+    const uint8_t* k,
+    uint8_t* r,
+    uint8_t* k_inv,
+    FidoP256CombYield yield,
+    void* context);
+
+/**
+ * @brief Parse a private key into its signing form (d * 2^256 mod n, 8 limbs)
+ *
+ * @return false if the key is not in [1, n - 1]
+ */
+bool fido_p256_comb_scalar_load(const uint8_t* private_key, uint32_t* loaded);
+
+/**
+ * @brief ECDSA s = k_inv * (e + r * d) mod n for a 32-byte hash e
+ *
+ * @param loaded private key from fido_p256_comb_scalar_load
+ * @return false if s is zero
+ */
+bool fido_p256_comb_ecdsa_s(
+    const uint32_t* loaded,
+    const uint8_t* hash,
+    const uint8_t* r,
+    const uint8_t* k_inv,
+    uint8_t* s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,176 @@
+#pragma once
+
+/*
+ * Generated by tools/gen_p256_comb.py - do not edit.
+ *
+ * Field elements are little-endian 32-bit limbs. Table entry j - 1 is
+ * the affine point sum(bit i of j ? 2^(i * SPACING) * G), with X and Y
+ * in the Montgomery domain mod p.
+ */
+
+#include <stdint.h>
+
+#define FIDO_P256_COMB_TEETH   5
+#define FIDO_P256_COMB_SPACING 52
+#define FIDO_P256_COMB_POINTS  31
+
+#define FIDO_P256_P_M0INV 0x00000001U // -p^-1 mod 2^32
+#define FIDO_P256_N_M0INV 0xEE00BC4FU // -n^-1 mod 2^32
+
+/** @brief Field prime p */
+static const uint32_t FIDO_P256_P[8] = {
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000,
+    0x00000000, 0x00000000, 0x00000001, 0xFFFFFFFF};
+
+/** @brief R^2 mod p, converts into the Montgomery domain */
+static const uint32_t FIDO_P256_P_R2[8] = {
+    0x00000003, 0x00000000, 0xFFFFFFFF, 0xFFFFFFFB,
+    0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFD, 0x00000004};
+
+/** @brief 1 in the Montgomery domain mod p */
+static const uint32_t FIDO_P256_P_ONE[8] = {
+    0x00000001, 0x00000000, 0x00000000, 0xFFFFFFFF,
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFE, 0x00000000};
+
+/** @brief Curve coefficient b, Montgomery form */
+static const uint32_t FIDO_P256_B_MONT[8] = {
+    0x29C4BDDF, 0xD89CDF62, 0x78843090, 0xACF005CD,
+    0xF7212ED6, 0xE5A220AB, 0x04874834, 0xDC30061D};
+
+/** @brief Group order n */
+static const uint32_t FIDO_P256_N[8] = {
+    0xFC632551, 0xF3B9CAC2, 0xA7179E84, 0xBCE6FAAD,
+    0xFFFFFFFF, 0xFFFFFFFF, 0x00000000, 0xFFFFFFFF};
+
+/** @brief R^2 mod n, converts into the Montgomery domain */
+static const uint32_t FIDO_P256_N_R2[8] = {
+    0xBE79EEA2, 0x83244C95, 0x49BD6FA6, 0x4699799C,
+    0x2B6BEC59, 0x2845B239, 0xF3D95620, 0x66E12D94};
+
+/** @brief Comb table for G, X then Y per entry */
+static const uint32_t FIDO_P256_COMB_TABLE[FIDO_P256_COMB_POINTS][16] = {
+    {0x18A9143C, 0x79E730D4, 0x5FEDB601, 0x75BA95FC,
+     0x77622510, 0x79FB732B, 0xA53755C6, 0x18905F76,
+     0xCE95560A, 0xDDF25357, 0xBA19E45C, 0x8B4AB8E4,
+     0xDD21F325, 0xD2E88688, 0x25885D85, 0x8571FF18},
+    {0xCECA9754, 0x83F49167, 0x4B7939A0, 0x426D2CF6,
+     0x723FD0BF, 0x2555E355, 0xC4F144E2, 0xA96E6D06,
+     0x87880E61, 0x4768A8DD, 0xE508E4D5, 0x15543815,
+     0xB1B65E15, 0x09D7E772, 0xAC302FA0, 0x63439DD6},
+    {0xA0BE5D0E, 0xF2675562, 0x4D1BB068, 0x4B524D25,
+     0xA9B75B8C, 0xBC2C5FF2, 0xD9A6F548, 0x4F326643,
+     0x1258835E, 0x50DD6844, 0x676090E0, 0x7D21BEEE,
+     0xF4A17B42, 0xB0B62C65, 0xB3CEC3B0, 0x60DFAE28},
+    {0xCF7D62D2, 0x20D3C982, 0x23BA8150, 0x1F36E29D,
+     0x92763F9E, 0x48AE0BF0, 0x1D3A7007, 0x7A527E6B,
+     0x581A85E3, 0xB4A89097, 0xDC158BE5, 0x1F1A520F,
+     0x167D726E, 0xF98DB37D, 0x1113E862, 0x8802786E},
+    {0xB113F918, 0x531E7B64, 0x920A681D, 0x26B5D70A,
+     0x24C37044, 0x04E52F8F, 0xBB7C375B, 0xBC7C9542,
+     0xF2E26375, 0xB63A044B, 0xE922A3D0, 0xD842A342,
+     0xA9292D57, 0x9EED2ECA, 0x49AC7832, 0xFE27D2C2},
+    {0xF24AAB7E, 0xEDBD7944, 0xCD1A1921, 0x56E51D9E,
+     0x962DAE55, 0x11C63188, 0x326ACD14, 0x37090565,
+     0xD71ED134, 0xC436E587, 0xAD89B461, 0x3D96AC3A,
+     0xDCB718BB, 0xCDF570BC, 0xDCFABDE2, 0xAAA490E9},
+    {0x0B639942, 0xB0AB5401, 0x19379664, 0xA6E12F57,
+     0x1D040ABC, 0xC535F8B4, 0xA75EEF24, 0xEF255C54,
+     0xAECEB0EA, 0xB236F734, 0x9D879E2F, 0x38FCC8C1,
+     0x180CACAB, 0x674D8FDC, 0xF624DF06, 0x0A18BAD4},
+    {0xCA8D9D1A, 0x488F1185, 0xD987DED2, 0xADF2C77D,
+     0x60C46124, 0x5F3039F0, 0x71E095F4, 0xE5D70B75,
+     0x6260E70F, 0x82D58650, 0xF750D105, 0x39D75EA7,
+     0x75BAC364, 0x8CF3D0B1, 0x21D01329, 0xF3A7564D},
+    {0x60530D0A, 0x83FC8091, 0x7BC23DC8, 0x58C24F52,
+     0xA653AF5A, 0xECDE2F1F, 0xB10E511E, 0xB2E2A374,
+     0x9BEBE1E4, 0xF0C54B32, 0xADE42270, 0x239C25DF,
+     0x9F22B433, 0xD866F55E, 0xED17EFD3, 0x1E513CA2},
+    {0x5BC98E0D, 0x66313DC8, 0x9A256888, 0xB13FE4E6,
+     0xECD6E280, 0x74816589, 0x5BA88474, 0xDEE13CDE,
+     0xC53BC78D, 0xAE4E1872, 0x2F08A464, 0x9B79904A,
+     0x9DA51935, 0xEF6E5CE2, 0x083C47EA, 0x9E58DF82},
+    {0xF5A32632, 0x4E066713, 0x4B36F498, 0x431F75D4,
+     0x70BD5F07, 0x40AE279F, 0x239EC23D, 0x252CDB93,
+     0x7312A246, 0xC18DDDF8, 0x23A9E561, 0x5B77673C,
+     0x1715FEDE, 0x020F09C3, 0xA580CFC5, 0xABEF6451},
+    {0xF2A0D962, 0x3C8BC3BF, 0x3405A8AA, 0x59F856EE,
+     0xB3DC5948, 0x2FB6590C, 0xED85740E, 0xC8AA740C,
+     0xE9AAFE19, 0xF8081CFB, 0x2534800D, 0xF7D2E1F3,
+     0x8D78D247, 0x355148C2, 0xD1557399, 0xAF0DC5A4},
+    {0xC7F68782, 0x34DFBFC4, 0x08AC2685, 0x2C6A80D6,
+     0x08D0255B, 0x5479E1BC, 0x9110C616, 0x42EB9DE0,
+     0x10B4ACBA, 0x97991DD8, 0x94D997C7, 0xF36ACC8F,
+     0x69DDC036, 0xD05AD78B, 0xE68B4243, 0x1AC7E528},
+    {0xE82C8E2A, 0xDD9F8A00, 0x21F80126, 0x104B85C6,
+     0x5B17A522, 0x1997228D, 0x923D0BD0, 0x706E5EC3,
+     0x1DC33622, 0x00C6AF27, 0x271F09E1, 0xB3BC76C8,
+     0xE36E325A, 0xEC1B7C0B, 0x68F12BFE, 0x128200E2},
+    {0xA8636D07, 0x8E86CB3D, 0x2BE46DA2, 0xC79C42AC,
+     0xAA01E0E1, 0xED70E08A, 0xE3B69272, 0x773579FC,
+     0x4D8464C3, 0xBC0FE555, 0xCF54E071, 0x9E87A057,
+     0x3913B1D3, 0xDA655B0A, 0x9A55DBA4, 0x052774D4},
+    {0xADF7CCCF, 0x75D9BC15, 0xDFA1E1B0, 0x81A3E5D6,
+     0x249BC17E, 0x8C39E444, 0x8EA7FD43, 0xF37DCCB2,
+     0x907FBA12, 0xDA654873, 0x4A372904, 0x35DAA6DA,
+     0x6283A6C5, 0x0564CFC6, 0x4A9395BF, 0xD09FA4F6},
+    {0xE37542CA, 0xB1F5C026, 0x72E01034, 0x0B860CF3,
+     0x025289F2, 0x3A7C10E4, 0x92901032, 0xD2197D5F,
+     0x267CA2F6, 0xFA06F835, 0xBF6E43AA, 0x8FCB9A29,
+     0x7ED9F8E7, 0x465F6C11, 0xE6077AAF, 0x8A50A5B3},
+    {0xD2B59E85, 0xAD76C703, 0x9204C53F, 0x0A230645,
+     0x4A9F1335, 0x9BBC0BC4, 0xD0A967E9, 0x71603515,
+     0xA0205375, 0x8B6D6D6E, 0x51AD76DE, 0x63104183,
+     0xAABBD0AC, 0x5ABFBC21, 0xC71F3060, 0x61FB45C3},
+    {0x1D323961, 0x579345DF, 0x94CD3BC4, 0x45B79EAD,
+     0x423668D2, 0x50B664BE, 0x42BC26EA, 0x19DD5B75,
+     0x3677AE8F, 0xC7C1FBAA, 0x5D033158, 0x7B2E711A,
+     0x8942AC93, 0x8AECB50A, 0x8A16718C, 0xE255438B},
+    {0x33396533, 0x80253642, 0x2C5AD150, 0x82CB33A7,
+     0x070CA168, 0x7C147998, 0x6AAC6636, 0x07791253,
+     0x7C78BE24, 0x160003AE, 0xA30EEABF, 0xBBA9FE68,
+     0x3073F0ED, 0x16C31C40, 0x789CAECA, 0xD329CD28},
+    {0x7972BCDF, 0x840DBCBF, 0xBD11900C, 0xB5C8444F,
+     0x16520CEE, 0x78B2B290, 0xBE88D914, 0xE19F13A3,
+     0x49D3C0DF, 0x052DDC89, 0xE0B4224B, 0xC9FC183C,
+     0xCF31E0BB, 0x2C8DD074, 0xA26B1441, 0x872C7B95},
+    {0x74C8A327, 0xED93585D, 0x06BE87CA, 0xF2FB7D08,
+     0x84E36244, 0x707D83CA, 0x3EFA6833, 0x037F499D,
+     0x99BF5DDE, 0xF3218D42, 0x69FF7CE3, 0xBE0A81C0,
+     0x9EB7D4C0, 0x068FBBEA, 0xE6938C78, 0xF4EF6609},
+    {0xCB22715E, 0x202E5C5A, 0x288F8243, 0x88E93D23,
+     0xDC7EACE6, 0xDF1D1F52, 0x373183F8, 0xC6B38B3B,
+     0x3EAC9C4B, 0x77798B7F, 0x6BFA9835, 0xA9D37DFF,
+     0xFAAC41C9, 0xAFF4A447, 0x0FCB6036, 0xF14FD13C},
+    {0x49CCC093, 0xEF5EE27D, 0x40D359A3, 0x7FF3263D,
+     0xC6D6C0EA, 0x885D1942, 0x28C97FEE, 0x925ABBA3,
+     0x5D95F52D, 0xD7383480, 0x4EB691DB, 0x6979981C,
+     0x553A29C6, 0x6544E8AE, 0x5043559F, 0x28324EF8},
+    {0x300C0E39, 0xD6C8E4B7, 0x3E37F58A, 0x37AD4A1A,
+     0xE5E8CDFB, 0x763330F5, 0x870EA133, 0x62BF8C2C,
+     0x763CCAC9, 0x03FBC63A, 0xFB1886C0, 0xC889D8A5,
+     0xBE49D9FE, 0xF0486DE5, 0x62C23338, 0xAF9A8778},
+    {0x76AA81B3, 0x8A43A2A1, 0x8A0CC3D2, 0x89602129,
+     0x821F6640, 0x49D311E8, 0x5C734AE4, 0x8035608F,
+     0x349ADC3B, 0xA7BE0561, 0x96A337B5, 0x328525B2,
+     0x6BCCF78A, 0x575413C3, 0x4854960F, 0x6C7292EC},
+    {0x3C2943FF, 0x121E6A71, 0x6374C47E, 0x0468565C,
+     0x2826F138, 0xD66FE993, 0x7748E3AC, 0x4E2CFAF1,
+     0x4708A6C8, 0xE9BAAA2C, 0x66FFB5B4, 0xA3845C8C,
+     0xB77C8FAC, 0xAD3E293E, 0x440A35E8, 0x00B5CFA9},
+    {0x63E06277, 0x3F55F58C, 0x64BA6E8C, 0x1A81DE8A,
+     0xF4CC043B, 0x85CFDC74, 0x048D26E0, 0x7CBEFB98,
+     0x82ABA891, 0x5BDE4B3C, 0x86DB6F46, 0x863D8F75,
+     0x845186C5, 0xC7AF5C1F, 0xCB527CEC, 0x41D7D404},
+    {0x83E1A246, 0x3B446994, 0xF6B819A2, 0x11C5CED4,
+     0xAFF79A46, 0xC79D4660, 0x5F22411A, 0x423BBDC1,
+     0xA964039D, 0x22652251, 0xE738657B, 0x808D6753,
+     0x4E909DC8, 0xC0CA19E3, 0x34AB0D07, 0x0E036E47},
+    {0x7A26F742, 0x233593E7, 0xFC0F14D9, 0xDDC1C79F,
+     0x2D359358, 0xB33C8980, 0x730AACFE, 0x51DF6155,
+     0x0F2C0B8D, 0xA9A6066C, 0x2E706F80, 0xB9212227,
+     0x96A5EFE9, 0x3994A532, 0x52316B12, 0xCF3D168B},
+    {0x27EAFCC0, 0xBE47DD50, 0xEC7E66DB, 0x23DF1041,
+     0x78A4DDDD, 0x18C977FF, 0x9D2D152E, 0xB51565D7,
+     0x78F4A4DE, 0x24F6A6D5, 0x7D86B2CA, 0xBBC15B20,
+     0x1D3B43CA, 0xA064D39C, 0x52200839, 0x55248667},
+};
@@ -0,0 +1,156 @@
+#include "fido_p256.h"
+
+#if FIDO_P256_BACKEND == FIDO_P256_BACKEND_MBEDTLS
+
+#include <furi.h>
+
+#include "fido_p256_comb.h"
+#include "fido_drbg.h"
+
+#include <mbedtls/ecdh.h>
+#include <mbedtls/ecp.h>
+
+#include <string.h>
+
+#define TAG "FidoP256"
+
+#define FIDO_P256_POINT_SIZE (1 + FIDO_P256_PUBLIC_KEY_SIZE) // 0x04 || X || Y
+
+struct FidoP256 {
+    mbedtls_ecp_group group;
+    FidoP256YieldCallback yield;
+    void* yield_context;
+};
+
+static int fido_p256_rng(void* context, unsigned char* dest, size_t size) {
+    UNUSED(context);
+    fido_drbg_fill(dest, size);
+    return 0;
+}
+
+FidoP256* fido_p256_alloc(void) {
+    FidoP256* p256 = malloc(sizeof(FidoP256));
+    mbedtls_ecp_group_init(&p256->group);
+    furi_check(mbedtls_ecp_group_load(&p256->group, MBEDTLS_ECP_DP_SECP256R1) == 0);
+    return p256;
+}
+
+void fido_p256_free(FidoP256* p256) {
+    if(!p256) return;
+    mbedtls_ecp_group_free(&p256->group);
+    free(p256);
+}
+
+void fido_p256_set_yield_callback(FidoP256* p256, FidoP256YieldCallback callback, void* context) {
+    furi_check(p256);
+    p256->yield = callback;
+    p256->yield_context = context;
+}
+
+const char* fido_p256_backend_name(void) {
+    return "mbedtls+comb";
+}
+
+/**
+ * @brief Draw a uniform scalar in [1, n - 1] by rejection sampling
+ */
+static void fido_p256_random_scalar(uint8_t* scalar) {
+    do {
+        fido_drbg_fill(scalar, FIDO_P256_PRIVATE_KEY_SIZE);
+    } while(!fido_p256_comb_scalar_is_valid(scalar));
+}
+
+bool fido_p256_keygen(FidoP256* p256, uint8_t* private_key, uint8_t* public_key) {
+    furi_check(p256);
+    fido_p256_random_scalar(private_key);
+    bool ok =
+        fido_p256_comb_mul_base(private_key, public_key, p256->yield, p256->yield_context);
+    if(!ok) {
+        FURI_LOG_W(TAG, "Key generation aborted");
+        memset(private_key, 0, FIDO_P256_PRIVATE_KEY_SIZE);
+    }
+    return ok;
+}
+
+bool fido_p256_public_key(FidoP256* p256, const uint8_t* private_key, uint8_t* public_key) {
+    furi_check(p256);
+    return fido_p256_comb_mul_base(private_key, public_key, p256->yield, p256->yield_context);
+}
+
+bool fido_p256_sign(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* hash,
+    uint8_t* signature) {
+    FidoP256Nonce nonce;
+    if(!fido_p256_nonce_generate(p256, &nonce)) return false;
+    return fido_p256_sign_with_nonce(p256, private_key, hash, &nonce, signature);
+}
+
+bool fido_p256_nonce_generate(FidoP256* p256, FidoP256Nonce* nonce) {
+    furi_check(p256);
+    uint8_t k[FIDO_P256_PRIVATE_KEY_SIZE];
+
+    // r == 0 has negligible probability, so a failure means the caller aborted
+    fido_p256_random_scalar(k);
+    bool ok = fido_p256_comb_nonce(k, nonce->r, nonce->k_inv, p256->yield, p256->yield_context);
+    if(!ok) memset(nonce, 0, sizeof(FidoP256Nonce));
+
+    memset(k, 0, sizeof(k));
+    return ok;
+}
+
+bool fido_p256_key_load(FidoP256* p256, const uint8_t* private_key, FidoP256Key* key) {
+    furi_check(p256);
+    return fido_p256_comb_scalar_load(private_key, key->words);
+}
+
+bool fido_p256_sign_with_key(
+    FidoP256* p256,
+    const FidoP256Key* key,
+    const uint8_t* hash,
+    FidoP256Nonce* nonce,
+    uint8_t* signature) {
+    furi_check(p256);
+    bool ok = fido_p256_comb_ecdsa_s(
+        key->words, hash, nonce->r, nonce->k_inv, signature + FIDO_P256_SIGNATURE_SIZE / 2);
+    if(ok) {
+        memcpy(signature, nonce->r, FIDO_P256_SIGNATURE_SIZE / 2);
+    } else {
+        FURI_LOG_E(TAG, "Signing with nonce failed");
+    }
+    memset(nonce, 0, sizeof(FidoP256Nonce));
+    return ok;
+}
+
+bool fido_p256_ecdh(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* peer_public_key,
+    uint8_t* shared_secret) {
+    furi_check(p256);
+    uint8_t point[FIDO_P256_POINT_SIZE];
+    point[0] = 0x04;
+    memcpy(point + 1, peer_public_key, FIDO_P256_PUBLIC_KEY_SIZE);
+
+    mbedtls_mpi d, z;
+    mbedtls_ecp_point Q;
+    mbedtls_mpi_init(&d);
+    mbedtls_mpi_init(&z);
+    mbedtls_ecp_point_init(&Q);
+
+    int ret = mbedtls_ecp_point_read_binary(&p256->group, &Q, point, sizeof(point));
+    if(ret == 0) ret = mbedtls_ecp_check_pubkey(&p256->group, &Q);
+    if(ret == 0) ret = mbedtls_mpi_read_binary(&d, private_key, FIDO_P256_PRIVATE_KEY_SIZE);
+    if(ret == 0) {
+        ret = mbedtls_ecdh_compute_shared(&p256->group, &z, &Q, &d, fido_p256_rng, NULL);
+    }
+    if(ret == 0) ret = mbedtls_mpi_write_binary(&z, shared_secret, FIDO_P256_SHARED_SECRET_SIZE);
+
+    mbedtls_ecp_point_free(&Q);
+    mbedtls_mpi_free(&z);
+    mbedtls_mpi_free(&d);
+    return ret == 0;
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include "fido_p256.h"
+
+#if FIDO_P256_BACKEND == FIDO_P256_BACKEND_UECC
+
+#include "fido_drbg.h"
+
+#include <furi.h>
+
+#include <uECC.h>
+#include <uECC_vli.h>
+
+#include <string.h>
+
+#if !uECC_ENABLE_VLI_API
+#error "The micro-ecc backend needs uECC_ENABLE_VLI_API=1 for precomputed nonces"
+#endif
+
+#define FIDO_P256_UECC_WORDS (FIDO_P256_PRIVATE_KEY_SIZE / uECC_WORD_SIZE)
+
+struct FidoP256 {
+    uECC_Curve curve;
+};
+
+static int fido_p256_rng(uint8_t* dest, unsigned size) {
+    fido_drbg_fill(dest, size);
+    return 1;
+}
+
+FidoP256* fido_p256_alloc(void) {
+    FidoP256* p256 = malloc(sizeof(FidoP256));
+    uECC_set_rng(fido_p256_rng);
+    p256->curve = uECC_secp256r1();
+    return p256;
+}
+
+void fido_p256_free(FidoP256* p256) {
+    if(!p256) return;
+    free(p256);
+}
+
+void fido_p256_set_yield_callback(FidoP256* p256, FidoP256YieldCallback callback, void* context) {
+    // micro-ecc has no hook between steps, operations always run in one piece
+    furi_check(p256);
+    UNUSED(callback);
+    UNUSED(context);
+}
+
+const char* fido_p256_backend_name(void) {
+    return "micro-ecc";
+}
+
+bool fido_p256_keygen(FidoP256* p256, uint8_t* private_key, uint8_t* public_key) {
+    furi_check(p256);
+    return uECC_make_key(public_key, private_key, p256->curve) == 1;
+}
+
+bool fido_p256_public_key(FidoP256* p256, const uint8_t* private_key, uint8_t* public_key) {
+    furi_check(p256);
+    return uECC_compute_public_key(private_key, public_key, p256->curve) == 1;
+}
+
+bool fido_p256_sign(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* hash,
+    uint8_t* signature) {
+    furi_check(p256);
+    return uECC_sign(private_key, hash, FIDO_P256_HASH_SIZE, signature, p256->curve) == 1;
+}
+
+/**
+ * @brief Reduce a value below 2^256 modulo n (n > 2^255, so one subtraction is enough)
+ */
+static void fido_p256_reduce_n(uECC_word_t* value, const uECC_word_t* n) {
+    if(uECC_vli_cmp(n, value, FIDO_P256_UECC_WORDS) != 1) {
+        uECC_vli_sub(value, value, n, FIDO_P256_UECC_WORDS);
+    }
+}
+
+bool fido_p256_nonce_generate(FidoP256* p256, FidoP256Nonce* nonce) {
+    furi_check(p256);
+    const uECC_word_t* n = uECC_curve_n(p256->curve);
+    uECC_word_t k[FIDO_P256_UECC_WORDS];
+    uECC_word_t point[FIDO_P256_UECC_WORDS * 2];
+
+    bool ok = uECC_generate_random_int(k, n, FIDO_P256_UECC_WORDS) == 1;
+    if(ok) {
+        uECC_point_mult(point, uECC_curve_G(p256->curve), k, p256->curve);
+        fido_p256_reduce_n(point, n);
+        ok = !uECC_vli_isZero(point, FIDO_P256_UECC_WORDS);
+    }
+    if(ok) {
+        uECC_vli_nativeToBytes(nonce->r, sizeof(nonce->r), point);
+        uECC_vli_modInv(k, k, n, FIDO_P256_UECC_WORDS);
+        uECC_vli_nativeToBytes(nonce->k_inv, sizeof(nonce->k_inv), k);
+    } else {
+        memset(nonce, 0, sizeof(FidoP256Nonce));
+    }
+
+    memset(k, 0, sizeof(k));
+    return ok;
+}
+
+bool fido_p256_key_load(FidoP256* p256, const uint8_t* private_key, FidoP256Key* key) {
+    furi_check(p256);
+    const uECC_word_t* n = uECC_curve_n(p256->curve);
+    uECC_word_t d[FIDO_P256_UECC_WORDS];
+
+    // The loaded form is the native-endian VLI, stored through memcpy so
+    // 64-bit uECC words need no extra alignment
+    uECC_vli_bytesToNative(d, private_key, FIDO_P256_PRIVATE_KEY_SIZE);
+    bool ok = !uECC_vli_isZero(d, FIDO_P256_UECC_WORDS) &&
+              uECC_vli_cmp(n, d, FIDO_P256_UECC_WORDS) == 1;
+    if(ok) memcpy(key->words, d, sizeof(key->words));
+
+    memset(d, 0, sizeof(d));
+    return ok;
+}
+
+bool fido_p256_sign_with_key(
+    FidoP256* p256,
+    const FidoP256Key* key,
+    const uint8_t* hash,
+    FidoP256Nonce* nonce,
+    uint8_t* signature) {
+    furi_check(p256);
+    const uECC_word_t* n = uECC_curve_n(p256->curve);
+    uECC_word_t d[FIDO_P256_UECC_WORDS];
+    uECC_word_t e[FIDO_P256_UECC_WORDS];
+    uECC_word_t r[FIDO_P256_UECC_WORDS];
+    uECC_word_t s[FIDO_P256_UECC_WORDS];
+
+    memcpy(d, key->words, sizeof(d));
+    uECC_vli_bytesToNative(e, hash, FIDO_P256_HASH_SIZE);
+    uECC_vli_bytesToNative(r, nonce->r, sizeof(nonce->r));
+    uECC_vli_bytesToNative(s, nonce->k_inv, sizeof(nonce->k_inv));
+    fido_p256_reduce_n(e, n);
+
+    // s = k^-1 * (e + r * d) mod n
+    uECC_vli_modMult(d, r, d, n, FIDO_P256_UECC_WORDS);
+    uECC_vli_modAdd(d, d, e, n, FIDO_P256_UECC_WORDS);
+    uECC_vli_modMult(s, s, d, n, FIDO_P256_UECC_WORDS);
+    bool ok = !uECC_vli_isZero(s, FIDO_P256_UECC_WORDS);
+    if(ok) {
+        memcpy(signature, nonce->r, sizeof(nonce->r));
+        uECC_vli_nativeToBytes(
+            signature + FIDO_P256_SIGNATURE_SIZE / 2, FIDO_P256_SIGNATURE_SIZE / 2, s);
+    }
+
+    memset(nonce, 0, sizeof(FidoP256Nonce));
+    memset(d, 0, sizeof(d));
+    memset(s, 0, sizeof(s));
+    return ok;
+}
+
+bool fido_p256_ecdh(
+    FidoP256* p256,
+    const uint8_t* private_key,
+    const uint8_t* peer_public_key,
+    uint8_t* shared_secret) {
+    furi_check(p256);
+    if(uECC_valid_public_key(peer_public_key, p256->curve) != 1) return false;
+    return uECC_shared_secret(peer_public_key, private_key, shared_secret, p256->curve) == 1;
+}
+
+#endif
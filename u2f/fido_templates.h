@@ -0,0 +1,50 @@
+#pragma once
+
+/*
+ * Generated by tools/gen_fido_templates.py - do not edit.
+ *
+ * Wire encodings of invariant responses and fragments, copied and
+ * patched by the handlers instead of being re-encoded per request.
+ */
+
+#include <stdint.h>
+
+#define FIDO2_GET_INFO_AAGUID_OFFSET 24
+
+/** @brief Complete getInfo response (status + map), AAGUID zeroed */
+static const uint8_t FIDO2_GET_INFO_TEMPLATE[106] = {
+    0x00, 0xA7, 0x01, 0x82, 0x68, 0x46, 0x49, 0x44, 0x4F, 0x5F, 0x32, 0x5F,
+    0x30, 0x66, 0x55, 0x32, 0x46, 0x5F, 0x56, 0x32, 0x02, 0x80, 0x03, 0x50,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x04, 0xA3, 0x62, 0x72, 0x6B, 0xF5, 0x62, 0x75,
+    0x70, 0xF5, 0x62, 0x75, 0x76, 0xF4, 0x05, 0x19, 0x04, 0xB0, 0x06, 0x80,
+    0x0A, 0x82, 0xA2, 0x63, 0x61, 0x6C, 0x67, 0x26, 0x64, 0x74, 0x79, 0x70,
+    0x65, 0x6A, 0x70, 0x75, 0x62, 0x6C, 0x69, 0x63, 0x2D, 0x6B, 0x65, 0x79,
+    0xA2, 0x63, 0x61, 0x6C, 0x67, 0x27, 0x64, 0x74, 0x79, 0x70, 0x65, 0x6A,
+    0x70, 0x75, 0x62, 0x6C, 0x69, 0x63, 0x2D, 0x6B, 0x65, 0x79,
+};
+
+/** @brief makeCredential status, map(3), fmt "packed" and the authData key */
+static const uint8_t FIDO2_MAKE_CREDENTIAL_PREFIX[11] = {
+    0x00, 0xA3, 0x01, 0x66, 0x70, 0x61, 0x63, 0x6B, 0x65, 0x64, 0x02,
+};
+
+/** @brief EC2/P-256 COSE key header up to the x coordinate bytes */
+static const uint8_t FIDO2_COSE_ES256_KEY_X_PREFIX[10] = {
+    0xA5, 0x01, 0x02, 0x03, 0x26, 0x20, 0x01, 0x21, 0x58, 0x20,
+};
+
+/** @brief EC2/P-256 COSE key header for the y coordinate bytes */
+static const uint8_t FIDO2_COSE_ES256_KEY_Y_PREFIX[3] = {
+    0x22, 0x58, 0x20,
+};
+
+/** @brief OKP/Ed25519 COSE key header up to the public key bytes */
+static const uint8_t FIDO2_COSE_EDDSA_KEY_X_PREFIX[10] = {
+    0xA4, 0x01, 0x01, 0x03, 0x27, 0x20, 0x06, 0x21, 0x58, 0x20,
+};
+
+/** @brief U2F_VERSION reply: version string followed by SW_NO_ERROR */
+static const uint8_t U2F_VERSION_RESPONSE[8] = {
+    0x55, 0x32, 0x46, 0x5F, 0x56, 0x32, 0x90, 0x00,
+};
@@ -250,6 +250,13 @@ bool u2f_scene_main_on_event(void* context, SceneManagerEvent event) {
         default:
             break;
         }
+    } else if(event.type == SceneManagerEventTypeTick) {
+        // The policy stops confirming at its expiry; take the badge down with it
+        if(app->lab_badge && !fido_lab_is_active(app->lab)) {
+            FURI_LOG_I(TAG, "Lab mode expired");
+            app->lab_badge = false;
+            u2f_view_set_lab_mode(app->u2f_view, false);
+        }
     }
 
     return consumed;
@@ -268,6 +275,11 @@ void u2f_scene_main_on_enter(void* context) {
     app->timer = furi_timer_alloc(u2f_scene_main_timer_callback, FuriTimerTypeOnce, app);
     app->usb_initialized = false;
 
+    app->lab = fido_lab_alloc();
+    app->lab_badge = fido_lab_is_active(app->lab);
+    u2f_view_set_lab_mode(app->u2f_view, app->lab_badge);
+    if(app->lab_badge) FURI_LOG_I(TAG, "Lab mode ACTIVE");
+
     if(app->fido_mode == FidoModeU2F) {
         FURI_LOG_I(TAG, "Initializing U2F (FIDO1) mode");
         debug_log("U2F mode selected");
@@ -276,6 +288,7 @@ void u2f_scene_main_on_enter(void* context) {
         app->u2f_ready = u2f_init(app->u2f_instance);
         if(app->u2f_ready == true) {
             u2f_set_event_callback(app->u2f_instance, u2f_scene_main_event_callback, app);
+            u2f_set_lab_policy(app->u2f_instance, app->lab);
             app->u2f_hid = u2f_hid_start(app->u2f_instance);
             app->usb_initialized = true;
             u2f_view_set_ok_callback(app->u2f_view, u2f_scene_main_ok_callback, app);
@@ -322,6 +335,7 @@ void u2f_scene_main_on_enter(void* context) {
                 // Get CTAP instance
                 Fido2Ctap* ctap = fido2_app_get_ctap((Fido2App*)app->fido2_instance);
                 if(ctap) {
+                    fido2_ctap_set_lab_policy(ctap, app->lab);
                     debug_log("Starting FIDO2 HID");
                     
                     app->fido2_hid = fido2_hid_start(ctap);
@@ -404,6 +418,12 @@ void u2f_scene_main_on_exit(void* context) {
         app->usb_initialized = false;
     }
 
+    // Workers are stopped, nothing references the policy anymore
+    fido_lab_free(app->lab);
+    app->lab = NULL;
+    app->lab_badge = false;
+    u2f_view_set_lab_mode(app->u2f_view, false);
+
     // Reset mode
     app->fido_mode = FidoModeNone;
     
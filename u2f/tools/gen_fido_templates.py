@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""
+Generate fido_templates.h: precomputed wire encodings for invariant
+FIDO2/U2F responses and fragments.
+
+Run from the app directory after changing any of the values below:
+
+    python3 tools/gen_fido_templates.py > fido_templates.h
+"""
+
+import struct
+
+# Keep in sync with fido2_ctap.c (supported_algorithms) and fido2_ctap.h
+CTAP2_OK = 0x00
+COSE_ALG_ES256 = -7
+COSE_ALG_EDDSA = -8
+SUPPORTED_ALGORITHMS = [COSE_ALG_ES256, COSE_ALG_EDDSA]
+MAX_MSG_SIZE = 1200
+AAGUID_SIZE = 16
+U2F_VERSION = b"U2F_V2"
+U2F_SW_NO_ERROR = b"\x90\x00"
+
+
+def head(major, value):
+    if value < 24:
+        return bytes([(major << 5) | value])
+    if value <= 0xFF:
+        return bytes([(major << 5) | 24, value])
+    if value <= 0xFFFF:
+        return bytes([(major << 5) | 25]) + struct.pack(">H", value)
+    return bytes([(major << 5) | 26]) + struct.pack(">I", value)
+
+
+def uint(v):
+    return head(0, v)
+
+
+def int_(v):
+    return head(0, v) if v >= 0 else head(1, -1 - v)
+
+
+def bstr_head(n):
+    return head(2, n)
+
+
+def text(s):
+    b = s.encode()
+    return head(3, len(b)) + b
+
+
+def array(n):
+    return head(4, n)
+
+
+def map_(n):
+    return head(5, n)
+
+
+def bool_(v):
+    return b"\xf5" if v else b"\xf4"
+
+
+def get_info():
+    """Returns (template, aaguid_offset)."""
+    out = bytes([CTAP2_OK]) + map_(7)
+    out += uint(0x01) + array(2) + text("FIDO_2_0") + text("U2F_V2")
+    out += uint(0x02) + array(0)
+    out += uint(0x03) + bstr_head(AAGUID_SIZE)
+    aaguid_offset = len(out)
+    out += bytes(AAGUID_SIZE)
+    out += uint(0x04) + map_(3)
+    out += text("rk") + bool_(True)
+    out += text("up") + bool_(True)
+    out += text("uv") + bool_(False)
+    out += uint(0x05) + uint(MAX_MSG_SIZE)
+    out += uint(0x06) + array(0)
+    out += uint(0x0A) + array(len(SUPPORTED_ALGORITHMS))
+    for alg in SUPPORTED_ALGORITHMS:
+        out += map_(2) + text("alg") + int_(alg) + text("type") + text("public-key")
+    return out, aaguid_offset
+
+
+def c_array(name, data, comment):
+    lines = ["/** @brief %s */" % comment]
+    lines.append("static const uint8_t %s[%d] = {" % (name, len(data)))
+    for i in range(0, len(data), 12):
+        chunk = ", ".join("0x%02X" % b for b in data[i:i + 12])
+        lines.append("    %s," % chunk)
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    info, aaguid_offset = get_info()
+
+    templates = [
+        c_array(
+            "FIDO2_GET_INFO_TEMPLATE",
+            info,
+            "Complete getInfo response (status + map), AAGUID zeroed",
+        ),
+        c_array(
+            "FIDO2_MAKE_CREDENTIAL_PREFIX",
+            bytes([CTAP2_OK]) + map_(3) + uint(1) + text("packed") + uint(2),
+            "makeCredential status, map(3), fmt \"packed\" and the authData key",
+        ),
+        c_array(
+            "FIDO2_COSE_ES256_KEY_X_PREFIX",
+            map_(5) + uint(1) + uint(2) + uint(3) + int_(COSE_ALG_ES256) + int_(-1) +
+            uint(1) + int_(-2) + bstr_head(32),
+            "EC2/P-256 COSE key header up to the x coordinate bytes",
+        ),
+        c_array(
+            "FIDO2_COSE_ES256_KEY_Y_PREFIX",
+            int_(-3) + bstr_head(32),
+            "EC2/P-256 COSE key header for the y coordinate bytes",
+        ),
+        c_array(
+            "FIDO2_COSE_EDDSA_KEY_X_PREFIX",
+            map_(4) + uint(1) + uint(1) + uint(3) + int_(COSE_ALG_EDDSA) + int_(-1) +
+            uint(6) + int_(-2) + bstr_head(32),
+            "OKP/Ed25519 COSE key header up to the public key bytes",
+        ),
+        c_array(
+            "U2F_VERSION_RESPONSE",
+            U2F_VERSION + U2F_SW_NO_ERROR,
+            "U2F_VERSION reply: version string followed by SW_NO_ERROR",
+        ),
+    ]
+
+    print("#pragma once")
+    print("")
+    print("/*")
+    print(" * Generated by tools/gen_fido_templates.py - do not edit.")
+    print(" *")
+    print(" * Wire encodings of invariant responses and fragments, copied and")
+    print(" * patched by the handlers instead of being re-encoded per request.")
+    print(" */")
+    print("")
+    print("#include <stdint.h>")
+    print("")
+    print("#define FIDO2_GET_INFO_AAGUID_OFFSET %d" % aaguid_offset)
+    print("")
+    print("\n\n".join(templates))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""
+Generate fido_p256_comb_table.h: P-256 constants and the fixed-base comb
+table for the generator G used by fido_p256_comb.c.
+
+Run from the app directory after changing FIDO_P256_COMB_TEETH:
+
+    python3 tools/gen_p256_comb.py > fido_p256_comb_table.h
+"""
+
+# Comb teeth: the table holds 2^TEETH - 1 points and a base multiplication
+# takes ceil(256 / TEETH) doublings and additions
+FIDO_P256_COMB_TEETH = 5
+
+P = 2**256 - 2**224 + 2**192 + 2**96 - 1
+N = 0xFFFFFFFF00000000FFFFFFFFFFFFFFFFBCE6FAADA7179E84F3B9CAC2FC632551
+B = 0x5AC635D8AA3A93E7B3EBBD55769886BC651D06B0CC53B0F63BCE3C3E27D2604B
+GX = 0x6B17D1F2E12C4247F8BCE6E563A440F277037D812DEB33A0F4A13945D898C296
+GY = 0x4FE342E2FE1A7F9B8EE7EB4A7C0F9E162BCE33576B315ECECBB6406837BF51F5
+R = 2**256
+
+
+def point_add(p1, p2):
+    """Affine addition, None is the point at infinity."""
+    if p1 is None:
+        return p2
+    if p2 is None:
+        return p1
+    x1, y1 = p1
+    x2, y2 = p2
+    if x1 == x2:
+        if (y1 + y2) % P == 0:
+            return None
+        lam = (3 * x1 * x1 - 3) * pow(2 * y1, -1, P) % P
+    else:
+        lam = (y2 - y1) * pow(x2 - x1, -1, P) % P
+    x3 = (lam * lam - x1 - x2) % P
+    return (x3, (lam * (x1 - x3) - y1) % P)
+
+
+def point_mul(k, point):
+    result = None
+    while k:
+        if k & 1:
+            result = point_add(result, point)
+        point = point_add(point, point)
+        k >>= 1
+    return result
+
+
+def limbs(value):
+    """Little-endian 32-bit limbs."""
+    return ["0x%08X" % ((value >> (32 * i)) & 0xFFFFFFFF) for i in range(8)]
+
+
+def c_limbs(name, value, comment):
+    l = limbs(value)
+    return "/** @brief %s */\nstatic const uint32_t %s[8] = {\n    %s,\n    %s};" % (
+        comment, name, ", ".join(l[:4]), ", ".join(l[4:]))
+
+
+def main():
+    spacing = -(-256 // FIDO_P256_COMB_TEETH)
+    tooth = [point_mul(2**(i * spacing), (GX, GY)) for i in range(FIDO_P256_COMB_TEETH)]
+
+    rows = []
+    for index in range(1, 2**FIDO_P256_COMB_TEETH):
+        point = None
+        for i in range(FIDO_P256_COMB_TEETH):
+            if index >> i & 1:
+                point = point_add(point, tooth[i])
+        x, y = point
+        lx = limbs(x * R % P)
+        ly = limbs(y * R % P)
+        rows.append("    {%s,\n     %s,\n     %s,\n     %s}," % (
+            ", ".join(lx[:4]), ", ".join(lx[4:]), ", ".join(ly[:4]), ", ".join(ly[4:])))
+
+    constants = [
+        c_limbs("FIDO_P256_P", P, "Field prime p"),
+        c_limbs("FIDO_P256_P_R2", R * R % P, "R^2 mod p, converts into the Montgomery domain"),
+        c_limbs("FIDO_P256_P_ONE", R % P, "1 in the Montgomery domain mod p"),
+        c_limbs("FIDO_P256_B_MONT", B * R % P, "Curve coefficient b, Montgomery form"),
+        c_limbs("FIDO_P256_N", N, "Group order n"),
+        c_limbs("FIDO_P256_N_R2", R * R % N, "R^2 mod n, converts into the Montgomery domain"),
+    ]
+
+    print("#pragma once")
+    print("")
+    print("/*")
+    print(" * Generated by tools/gen_p256_comb.py - do not edit.")
+    print(" *")
+    print(" * Field elements are little-endian 32-bit limbs. Table entry j - 1 is")
+    print(" * the affine point sum(bit i of j ? 2^(i * SPACING) * G), with X and Y")
+    print(" * in the Montgomery domain mod p.")
+    print(" */")
+    print("")
+    print("#include <stdint.h>")
+    print("")
+    print("#define FIDO_P256_COMB_TEETH   %d" % FIDO_P256_COMB_TEETH)
+    print("#define FIDO_P256_COMB_SPACING %d" % spacing)
+    print("#define FIDO_P256_COMB_POINTS  %d" % (2**FIDO_P256_COMB_TEETH - 1))
+    print("")
+    print("#define FIDO_P256_P_M0INV 0x%08XU // -p^-1 mod 2^32" % (-pow(P, -1, 2**32) % 2**32))
+    print("#define FIDO_P256_N_M0INV 0x%08XU // -n^-1 mod 2^32" % (-pow(N, -1, 2**32) % 2**32))
+    print("")
+    print("\n\n".join(constants))
+    print("")
+    print("/** @brief Comb table for G, X then Y per entry */")
+    print("static const uint32_t FIDO_P256_COMB_TABLE[FIDO_P256_COMB_POINTS][16] = {")
+    print("\n".join(rows))
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
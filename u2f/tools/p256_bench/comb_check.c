@@ -0,0 +1,230 @@
+/**
+ * @brief Cross-check of the comb path's Montgomery arithmetic
+ *
+ * Builds fido_p256_comb.c into this file to reach its static helpers and
+ * compares, on random operands and edge values, for both p and n:
+ * - mul_add_add against the portable C form
+ * - mont_mul and mont_sqr against a bit-serial Montgomery reference that
+ *   uses no multiplication at all
+ *
+ * On the host both sides of the first check are the C form. To test the
+ * UMAAL path, cross-compile for ARM with it forced on and run under qemu:
+ *
+ *   cc -O2 -I. tools/p256_bench/comb_check.c -o comb_check
+ *
+ *   arm-linux-gnueabihf-gcc -O2 -static -march=armv7-a -mthumb \
+ *       -DFIDO_P256_COMB_UMAAL=1 -I. tools/p256_bench/comb_check.c -o comb_check_arm
+ *   qemu-arm ./comb_check_arm
+ *
+ * An optional argument sets the number of random rounds (default 100000).
+ *
+ * It then prints Cortex-M4 cycle estimates for each comb operation, for
+ * both forms of mul_add_add. qemu does not model cycles, so they come from
+ * counting multiply-accumulate steps and pricing each one: two loads and a
+ * store around either one UMAAL or UMULL plus two add-with-carry pairs.
+ * Additions, subtractions and selects are left out, so the totals are a
+ * lower bound; the ratio between the columns is what matters.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned long check_steps;
+#define FIDO_P256_COMB_COUNT_STEP() (check_steps++)
+
+#include "fido_p256_comb.c"
+
+#define CHECK_DEFAULT_ROUNDS 100000
+
+#define CHECK_M4_CYCLES_MEMORY 3 // LDR, LDR, STR around each step
+#define CHECK_M4_CYCLES_UMAAL  1
+#define CHECK_M4_CYCLES_C      5
+
+static uint64_t check_state = 0x243F6A8885A308D3ULL;
+
+static uint32_t check_random(void) {
+    // xorshift64*, plenty for operand coverage and reproducible
+    check_state ^= check_state >> 12;
+    check_state ^= check_state << 25;
+    check_state ^= check_state >> 27;
+    return (uint32_t)((check_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+/**
+ * @brief Random limb value, biased towards carry-heavy all-ones and zero limbs
+ */
+static uint32_t check_limb(void) {
+    switch(check_random() & 7) {
+    case 0:
+        return 0;
+    case 1:
+        return 0xFFFFFFFF;
+    default:
+        return check_random();
+    }
+}
+
+static bool check_below(const uint32_t* a, const uint32_t* m) {
+    uint32_t scratch[FIDO_P256_LIMBS];
+    return fe_sub_raw(scratch, a, m) != 0;
+}
+
+/**
+ * @brief Random field element below m, or one of 0, 1, m - 1
+ */
+static void check_operand(uint32_t* a, const uint32_t* m) {
+    uint32_t pick = check_random() & 15;
+    if(pick < 3) {
+        memset(a, 0, sizeof(uint32_t) * FIDO_P256_LIMBS);
+        if(pick == 1) a[0] = 1;
+        if(pick == 2) fe_sub_raw(a, m, fido_p256_one);
+        return;
+    }
+    do {
+        for(size_t i = 0; i < FIDO_P256_LIMBS; i++) {
+            a[i] = check_limb();
+        }
+    } while(!check_below(a, m));
+}
+
+/**
+ * @brief r = a * b * 2^-256 mod m, one bit of b at a time
+ */
+static void check_mont_ref(uint32_t* r, const uint32_t* a, const uint32_t* b, const uint32_t* m) {
+    uint32_t acc[FIDO_P256_LIMBS] = {0};
+    uint32_t top = 0; // bits above acc; acc stays below 2m between steps
+    for(size_t bit = 0; bit < 32 * FIDO_P256_LIMBS; bit++) {
+        if((b[bit / 32] >> (bit % 32)) & 1) top += fe_add_raw(acc, acc, a);
+        if(acc[0] & 1) top += fe_add_raw(acc, acc, m);
+        for(size_t i = 0; i < FIDO_P256_LIMBS - 1; i++) {
+            acc[i] = (acc[i] >> 1) | (acc[i + 1] << 31);
+        }
+        acc[FIDO_P256_LIMBS - 1] = (acc[FIDO_P256_LIMBS - 1] >> 1) | (top << 31);
+        top >>= 1;
+    }
+    uint32_t reduced[FIDO_P256_LIMBS];
+    if(fe_sub_raw(reduced, acc, m) == top) memcpy(acc, reduced, sizeof(acc));
+    memcpy(r, acc, sizeof(acc));
+}
+
+static bool check_mul_add_add(void) {
+    uint32_t lo = check_limb();
+    uint32_t hi = check_limb();
+    uint32_t a = check_limb();
+    uint32_t b = check_limb();
+    uint32_t ref_lo = lo;
+    uint32_t ref_hi = hi;
+    mul_add_add(&lo, &hi, a, b);
+    mul_add_add_c(&ref_lo, &ref_hi, a, b);
+    if(lo == ref_lo && hi == ref_hi) return true;
+    fprintf(stderr, "mul_add_add mismatch: a=%08x b=%08x\n", (unsigned)a, (unsigned)b);
+    return false;
+}
+
+static void check_print(const char* name, const uint32_t* a) {
+    fprintf(stderr, "  %s=", name);
+    for(size_t i = FIDO_P256_LIMBS; i > 0; i--) {
+        fprintf(stderr, "%08x", (unsigned)a[i - 1]);
+    }
+    fprintf(stderr, "\n");
+}
+
+static bool check_modulus(const char* name, const uint32_t* m, uint32_t m0inv) {
+    uint32_t a[FIDO_P256_LIMBS], b[FIDO_P256_LIMBS];
+    uint32_t ref[FIDO_P256_LIMBS], out[FIDO_P256_LIMBS];
+
+    check_operand(a, m);
+    check_operand(b, m);
+
+    check_mont_ref(ref, a, b, m);
+    mont_mul(out, a, b, m, m0inv);
+    if(memcmp(out, ref, sizeof(ref)) != 0) {
+        fprintf(stderr, "mont_mul mismatch mod %s\n", name);
+        check_print("a", a);
+        check_print("b", b);
+        return false;
+    }
+
+    check_mont_ref(ref, a, a, m);
+    mont_sqr(out, a, m, m0inv);
+    if(memcmp(out, ref, sizeof(ref)) != 0) {
+        fprintf(stderr, "mont_sqr mismatch mod %s\n", name);
+        check_print("a", a);
+        return false;
+    }
+    return true;
+}
+
+static void check_estimate(const char* name, unsigned long steps) {
+    printf(
+        "%-18s %8lu %10lu %10lu\n",
+        name,
+        steps,
+        steps * (CHECK_M4_CYCLES_MEMORY + CHECK_M4_CYCLES_UMAAL),
+        steps * (CHECK_M4_CYCLES_MEMORY + CHECK_M4_CYCLES_C));
+}
+
+/**
+ * @brief Count the multiply-accumulate steps of each operation and print estimates
+ */
+static void check_estimates(void) {
+    uint32_t a[FIDO_P256_LIMBS], b[FIDO_P256_LIMBS], out[FIDO_P256_LIMBS];
+    FidoP256Point point;
+    uint8_t scalar[32], result[64];
+
+    check_operand(a, FIDO_P256_P);
+    check_operand(b, FIDO_P256_P);
+    memcpy(point.x, a, sizeof(a));
+    memcpy(point.y, b, sizeof(b));
+    memcpy(point.z, FIDO_P256_P_ONE, sizeof(point.z));
+    for(size_t i = 0; i < sizeof(scalar); i++) {
+        scalar[i] = (uint8_t)(i * 11 + 3);
+    }
+
+    printf("%-18s %8s %10s %10s\n", "operation", "steps", "UMAAL cyc", "C cyc");
+
+    check_steps = 0;
+    mont_mul(out, a, b, FIDO_P256_P, FIDO_P256_P_M0INV);
+    check_estimate("mont_mul", check_steps);
+
+    check_steps = 0;
+    mont_sqr(out, a, FIDO_P256_P, FIDO_P256_P_M0INV);
+    check_estimate("mont_sqr", check_steps);
+
+    check_steps = 0;
+    point_double(&point, &point);
+    check_estimate("point_double", check_steps);
+
+    check_steps = 0;
+    point_add_affine(&point, &point, a, b);
+    check_estimate("point_add_affine", check_steps);
+
+    check_steps = 0;
+    mont_inv(out, a, FIDO_P256_P, FIDO_P256_P_M0INV, FIDO_P256_P_ONE, NULL, NULL);
+    check_estimate("mont_inv", check_steps);
+
+    check_steps = 0;
+    fido_p256_comb_mul_base(scalar, result, NULL, NULL);
+    check_estimate("mul_base", check_steps);
+
+    check_steps = 0;
+    fido_p256_comb_nonce(scalar, result, result + 32, NULL, NULL);
+    check_estimate("nonce", check_steps);
+}
+
+int main(int argc, char** argv) {
+    unsigned long rounds = argc > 1 ? strtoul(argv[1], NULL, 0) : CHECK_DEFAULT_ROUNDS;
+
+    for(unsigned long round = 0; round < rounds; round++) {
+        if(!check_mul_add_add()) return 1;
+        if(!check_modulus("p", FIDO_P256_P, FIDO_P256_P_M0INV)) return 1;
+        if(!check_modulus("n", FIDO_P256_N, FIDO_P256_N_M0INV)) return 1;
+    }
+
+    printf(
+        "%lu rounds ok, mul_add_add %s\n",
+        rounds,
+        FIDO_P256_COMB_UMAAL ? "via UMAAL" : "in C");
+
+    check_estimates();
+    return 0;
+}
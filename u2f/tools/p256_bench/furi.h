@@ -0,0 +1,58 @@
+#pragma once
+
+// Minimal host stand-ins for the furi pieces used by the P-256 backends
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define UNUSED(x) (void)(x)
+
+#define furi_check(x) \
+    do {              \
+        if(!(x)) {    \
+            abort();  \
+        }             \
+    } while(0)
+
+#define FURI_LOG_E(tag, fmt, ...) fprintf(stderr, "[E][%s] " fmt "\n", tag, ##__VA_ARGS__)
+#define FURI_LOG_W(tag, fmt, ...) fprintf(stderr, "[W][%s] " fmt "\n", tag, ##__VA_ARGS__)
+#define FURI_LOG_I(tag, fmt, ...)
+#define FURI_LOG_D(tag, fmt, ...)
+
+typedef pthread_mutex_t FuriMutex;
+
+typedef enum {
+    FuriMutexTypeNormal,
+} FuriMutexType;
+
+typedef enum {
+    FuriStatusOk = 0,
+} FuriStatus;
+
+#define FuriWaitForever 0xFFFFFFFFU
+
+static inline FuriMutex* furi_mutex_alloc(FuriMutexType type) {
+    UNUSED(type);
+    FuriMutex* mutex = malloc(sizeof(FuriMutex));
+    pthread_mutex_init(mutex, NULL);
+    return mutex;
+}
+
+static inline void furi_mutex_free(FuriMutex* mutex) {
+    pthread_mutex_destroy(mutex);
+    free(mutex);
+}
+
+static inline FuriStatus furi_mutex_acquire(FuriMutex* mutex, uint32_t timeout) {
+    UNUSED(timeout);
+    pthread_mutex_lock(mutex);
+    return FuriStatusOk;
+}
+
+static inline FuriStatus furi_mutex_release(FuriMutex* mutex) {
+    pthread_mutex_unlock(mutex);
+    return FuriStatusOk;
+}
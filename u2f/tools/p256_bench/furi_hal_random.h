@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static inline void furi_hal_random_fill_buf(uint8_t* buf, uint32_t len) {
+    FILE* urandom = fopen("/dev/urandom", "rb");
+    if(!urandom || fread(buf, 1, len, urandom) != len) abort();
+    fclose(urandom);
+}
@@ -0,0 +1,290 @@
+/**
+ * @brief Host benchmark for the P-256 provider backends
+ *
+ * Reports ops/s and peak stack use of every fido_p256 operation for the
+ * backend it is built with, plus Ed25519 keygen and sign for comparison.
+ * Run from the u2f directory:
+ *
+ *   cc -O2 -Itools/p256_bench -I. tools/p256_bench/p256_bench.c fido_p256.c \
+ *       fido_p256_mbedtls.c fido_p256_comb.c fido2_ed25519.c fido_drbg.c fido_hmac.c \
+ *       -lmbedcrypto -lpthread -o p256_bench_mbedtls
+ *
+ *   cc -O2 -Itools/p256_bench -I. -I$UECC -DFIDO_P256_BACKEND=FIDO_P256_BACKEND_UECC \
+ *       -DuECC_SUPPORTS_secp160r1=0 -DuECC_SUPPORTS_secp192r1=0 \
+ *       -DuECC_SUPPORTS_secp224r1=0 -DuECC_SUPPORTS_secp256k1=0 \
+ *       tools/p256_bench/p256_bench.c fido_p256.c fido_p256_uecc.c $UECC/uECC.c \
+ *       fido2_ed25519.c fido_drbg.c fido_hmac.c -lmbedcrypto -lpthread -o p256_bench_uecc
+ *
+ * Pass a hex seed (e.g. ./p256_bench_mbedtls 00112233) to run on a
+ * deterministic DRBG, so repeated runs use identical keys and nonces.
+ *
+ * Host numbers rank the backends; absolute cycles and stack depth on the
+ * Cortex-M4 differ, so confirm the winner on the device before switching.
+ */
+#include "fido_p256.h"
+#include "fido_drbg.h"
+#include "fido2_ed25519.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MIN_SECONDS 1.0
+#define BENCH_MAX_SECONDS 10.0 // wall time, bounds ops with a slow prepare
+#define BENCH_STACK_SIZE  (64 * 1024)
+#define BENCH_STACK_PAINT 0xA5
+
+typedef struct {
+    FidoP256* p256;
+    uint8_t private_key[FIDO_P256_PRIVATE_KEY_SIZE];
+    uint8_t public_key[FIDO_P256_PUBLIC_KEY_SIZE];
+    uint8_t peer_public_key[FIDO_P256_PUBLIC_KEY_SIZE];
+    uint8_t hash[FIDO_P256_HASH_SIZE];
+    uint8_t output_key[FIDO_P256_PRIVATE_KEY_SIZE];
+    uint8_t output[FIDO_P256_DER_SIGNATURE_MAX_SIZE];
+    FidoP256Nonce nonce;
+    uint8_t ed25519_seed[FIDO2_ED25519_SEED_SIZE];
+    uint8_t ed25519_public_key[FIDO2_ED25519_PUBLIC_KEY_SIZE];
+} BenchState;
+
+typedef bool (*BenchOp)(BenchState* state);
+
+static bool bench_noop(BenchState* state) {
+    return state != NULL;
+}
+
+static bool bench_random(BenchState* state) {
+    fido_drbg_fill(state->output, FIDO_P256_PRIVATE_KEY_SIZE);
+    return true;
+}
+
+static bool bench_keygen(BenchState* state) {
+    return fido_p256_keygen(state->p256, state->output_key, state->output);
+}
+
+static bool bench_public_key(BenchState* state) {
+    return fido_p256_public_key(state->p256, state->private_key, state->output);
+}
+
+static bool bench_sign(BenchState* state) {
+    return fido_p256_sign(state->p256, state->private_key, state->hash, state->output);
+}
+
+static bool bench_sign_der(BenchState* state) {
+    return fido_p256_sign_der(state->p256, state->private_key, state->hash, state->output) > 0;
+}
+
+static bool bench_nonce_generate(BenchState* state) {
+    FidoP256Nonce nonce;
+    return fido_p256_nonce_generate(state->p256, &nonce);
+}
+
+static bool bench_prepare_nonce(BenchState* state) {
+    return fido_p256_nonce_generate(state->p256, &state->nonce);
+}
+
+static bool bench_sign_with_nonce(BenchState* state) {
+    return fido_p256_sign_with_nonce(
+        state->p256, state->private_key, state->hash, &state->nonce, state->output);
+}
+
+static bool bench_ecdh(BenchState* state) {
+    return fido_p256_ecdh(state->p256, state->private_key, state->peer_public_key, state->output);
+}
+
+static bool bench_ed25519_keygen(BenchState* state) {
+    // Same steps as an Ed25519 makeCredential: random seed, then derive
+    fido_drbg_fill(state->output_key, FIDO2_ED25519_SEED_SIZE);
+    fido2_ed25519_public_key(state->output_key, state->output);
+    return true;
+}
+
+static bool bench_ed25519_sign(BenchState* state) {
+    fido2_ed25519_sign(
+        state->ed25519_seed,
+        state->ed25519_public_key,
+        state->hash,
+        sizeof(state->hash),
+        NULL,
+        0,
+        state->output);
+    return true;
+}
+
+// prepare runs untimed before every op, e.g. idle-time work on the device
+static const struct {
+    const char* name;
+    BenchOp op;
+    BenchOp prepare;
+} bench_ops[] = {
+    {"random32", bench_random, NULL},
+    {"keygen", bench_keygen, NULL},
+    {"public_key", bench_public_key, NULL},
+    {"sign", bench_sign, NULL},
+    {"sign_der", bench_sign_der, NULL},
+    {"nonce_gen", bench_nonce_generate, NULL},
+    {"sign_nonce", bench_sign_with_nonce, bench_prepare_nonce},
+    {"ecdh", bench_ecdh, NULL},
+    {"ed25519_key", bench_ed25519_keygen, NULL},
+    {"ed25519_sign", bench_ed25519_sign, NULL},
+};
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    BenchOp op;
+    BenchState* state;
+    bool ok;
+} BenchThreadArgs;
+
+static void* bench_thread(void* context) {
+    BenchThreadArgs* args = context;
+    args->ok = args->op(args->state);
+    return NULL;
+}
+
+/**
+ * @brief Run one operation on a painted stack and return the bytes it touched
+ *
+ * Includes thread start-up and TLS, which bench_noop measures for subtraction.
+ */
+static size_t bench_stack_use(BenchOp op, BenchState* state) {
+    uint8_t* stack = aligned_alloc(4096, BENCH_STACK_SIZE);
+    if(!stack) abort();
+    memset(stack, BENCH_STACK_PAINT, BENCH_STACK_SIZE);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, BENCH_STACK_SIZE);
+
+    BenchThreadArgs args = {.op = op, .state = state, .ok = false};
+    pthread_t thread;
+    if(pthread_create(&thread, &attr, bench_thread, &args) != 0) abort();
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    // The stack grows down: the lowest overwritten byte marks the peak
+    size_t untouched = 0;
+    while(untouched < BENCH_STACK_SIZE && stack[untouched] == BENCH_STACK_PAINT) {
+        untouched++;
+    }
+    free(stack);
+
+    if(!args.ok) {
+        fprintf(stderr, "operation failed on the stack probe\n");
+        exit(1);
+    }
+    return BENCH_STACK_SIZE - untouched;
+}
+
+static bool bench_self_test(BenchState* state) {
+    // ECDH must agree in both directions, and keygen must match public_key
+    uint8_t other_private[FIDO_P256_PRIVATE_KEY_SIZE];
+    uint8_t other_public[FIDO_P256_PUBLIC_KEY_SIZE];
+    uint8_t check[FIDO_P256_PUBLIC_KEY_SIZE];
+    uint8_t secret_a[FIDO_P256_SHARED_SECRET_SIZE];
+    uint8_t secret_b[FIDO_P256_SHARED_SECRET_SIZE];
+
+    if(!fido_p256_keygen(state->p256, other_private, other_public)) return false;
+    if(!fido_p256_public_key(state->p256, other_private, check)) return false;
+    if(memcmp(check, other_public, sizeof(check)) != 0) return false;
+
+    if(!fido_p256_ecdh(state->p256, state->private_key, other_public, secret_a)) return false;
+    if(!fido_p256_ecdh(state->p256, other_private, state->public_key, secret_b)) return false;
+    if(memcmp(secret_a, secret_b, sizeof(secret_a)) != 0) return false;
+
+    // Points off the curve must be rejected
+    other_public[FIDO_P256_PUBLIC_KEY_SIZE - 1] ^= 1;
+    return !fido_p256_ecdh(state->p256, state->private_key, other_public, secret_a);
+}
+
+/**
+ * @brief Seed the DRBG from a hex string, or from the system RNG if NULL
+ */
+static bool bench_seed(const char* hex) {
+    if(!hex) {
+        fido_drbg_init();
+        return true;
+    }
+
+    uint8_t seed[FIDO_DRBG_SEED_SIZE];
+    size_t len = 0;
+    while(len < sizeof(seed) && hex[0] && hex[1]) {
+        unsigned int byte;
+        if(sscanf(hex, "%2x", &byte) != 1) return false;
+        seed[len++] = (uint8_t)byte;
+        hex += 2;
+    }
+    if(len == 0 || hex[0]) return false;
+    fido_drbg_init_deterministic(seed, len);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if(!bench_seed(argc > 1 ? argv[1] : NULL)) {
+        fprintf(stderr, "usage: %s [hex seed]\n", argv[0]);
+        return 1;
+    }
+
+    BenchState state;
+    memset(&state, 0, sizeof(state));
+    state.p256 = fido_p256_alloc();
+
+    uint8_t peer_private[FIDO_P256_PRIVATE_KEY_SIZE];
+    if(!fido_p256_keygen(state.p256, state.private_key, state.public_key) ||
+       !fido_p256_keygen(state.p256, peer_private, state.peer_public_key)) {
+        fprintf(stderr, "key generation failed\n");
+        return 1;
+    }
+    for(size_t i = 0; i < sizeof(state.hash); i++) {
+        state.hash[i] = (uint8_t)(i * 7 + 1);
+    }
+    fido_drbg_fill(state.ed25519_seed, sizeof(state.ed25519_seed));
+    fido2_ed25519_public_key(state.ed25519_seed, state.ed25519_public_key);
+
+    if(!bench_self_test(&state)) {
+        fprintf(stderr, "%s: self test failed\n", fido_p256_backend_name());
+        return 1;
+    }
+
+    size_t stack_baseline = bench_stack_use(bench_noop, &state);
+
+    printf("backend: %s\n", fido_p256_backend_name());
+    printf("%-12s %10s %12s %10s\n", "operation", "ops/s", "us/op", "stack B");
+    for(size_t i = 0; i < sizeof(bench_ops) / sizeof(bench_ops[0]); i++) {
+        BenchOp prepare = bench_ops[i].prepare;
+        if(prepare && !prepare(&state)) return 1;
+        size_t stack_used = bench_stack_use(bench_ops[i].op, &state) - stack_baseline;
+
+        size_t iterations = 0;
+        double elapsed = 0;
+        double wall_start = bench_now();
+        do {
+            if(prepare && !prepare(&state)) return 1;
+            double start = bench_now();
+            if(!bench_ops[i].op(&state)) {
+                fprintf(stderr, "%s failed\n", bench_ops[i].name);
+                return 1;
+            }
+            elapsed += bench_now() - start;
+            iterations++;
+        } while(elapsed < BENCH_MIN_SECONDS && bench_now() - wall_start < BENCH_MAX_SECONDS);
+
+        printf(
+            "%-12s %10.1f %12.1f %10zu\n",
+            bench_ops[i].name,
+            iterations / elapsed,
+            elapsed * 1e6 / iterations,
+            stack_used);
+    }
+
+    fido_p256_free(state.p256);
+    fido_drbg_deinit();
+    return 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// FlipperFormat on the host storage stand-in (see host_flipper_format.c),
+// enough to migrate text credential files and to write them for the bench
+
+#include <furi.h>
+#include <storage/storage.h>
+
+typedef struct FlipperFormat FlipperFormat;
+
+FlipperFormat* flipper_format_file_alloc(Storage* storage);
+void flipper_format_free(FlipperFormat* flipper_format);
+
+bool flipper_format_file_open_existing(FlipperFormat* flipper_format, const char* path);
+bool flipper_format_file_open_always(FlipperFormat* flipper_format, const char* path);
+
+bool flipper_format_read_header(
+    FlipperFormat* flipper_format,
+    FuriString* filetype,
+    uint32_t* version);
+bool flipper_format_get_value_count(
+    FlipperFormat* flipper_format,
+    const char* key,
+    uint32_t* count);
+bool flipper_format_read_uint32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    uint32_t* data,
+    const uint16_t data_size);
+bool flipper_format_read_int32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    int32_t* data,
+    const uint16_t data_size);
+bool flipper_format_read_hex(
+    FlipperFormat* flipper_format,
+    const char* key,
+    uint8_t* data,
+    const uint16_t data_size);
+bool flipper_format_read_string(FlipperFormat* flipper_format, const char* key, FuriString* data);
+
+bool flipper_format_write_header_cstr(
+    FlipperFormat* flipper_format,
+    const char* filetype,
+    const uint32_t version);
+bool flipper_format_write_uint32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const uint32_t* data,
+    const uint16_t data_size);
+bool flipper_format_write_int32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const int32_t* data,
+    const uint16_t data_size);
+bool flipper_format_write_hex(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const uint8_t* data,
+    const uint16_t data_size);
+bool flipper_format_write_string_cstr(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const char* data);
@@ -0,0 +1,25 @@
+#pragma once
+
+// Host stand-ins for the furi pieces used by the credential store, on top
+// of the ones the P-256 backends need
+
+#include "../p256_bench/furi.h"
+
+#include <string.h>
+
+#define EXT_PATH(path) "/ext/" path
+#define COUNT_OF(x)    (sizeof(x) / sizeof((x)[0]))
+
+#define furi_crash(message) abort()
+
+uint32_t furi_get_tick(void);
+
+void* furi_record_open(const char* name);
+void furi_record_close(const char* name);
+
+typedef struct FuriString FuriString;
+
+FuriString* furi_string_alloc(void);
+void furi_string_free(FuriString* string);
+const char* furi_string_get_cstr(const FuriString* string);
+void furi_string_set_str(FuriString* string, const char* cstr);
@@ -0,0 +1,25 @@
+#pragma once
+
+// Crypto stand-ins: the enclave unique key is a fixed host key, AES runs in
+// mbedtls instead of the AES1 peripheral
+
+#include <furi.h>
+#include <furi_hal_random.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FURI_HAL_CRYPTO_ENCLAVE_UNIQUE_KEY_SLOT 11
+
+bool furi_hal_crypto_enclave_ensure_key(uint8_t key_slot);
+bool furi_hal_crypto_enclave_load_key(uint8_t key_slot, const uint8_t* iv);
+bool furi_hal_crypto_enclave_unload_key(uint8_t key_slot);
+bool furi_hal_crypto_encrypt(const uint8_t* input, uint8_t* output, size_t size);
+bool furi_hal_crypto_decrypt(const uint8_t* input, uint8_t* output, size_t size);
+bool furi_hal_crypto_ctr(
+    const uint8_t* key,
+    const uint8_t* iv,
+    const uint8_t* input,
+    uint8_t* output,
+    size_t length);
@@ -0,0 +1,280 @@
+#include <flipper_format/flipper_format.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Like flipper_format_file_alloc on the device, this sits on an unbuffered
+ * file stream: keys and values are parsed one storage read per character,
+ * and every key, value, separator and line end is its own storage write.
+ * The storage counters then match what the device does for a text file.
+ * Keys are only searched forward from the current position.
+ */
+
+#define HOST_FF_KEY_SIZE   64
+#define HOST_FF_VALUE_SIZE 16
+
+struct FlipperFormat {
+    File* file;
+};
+
+typedef enum {
+    HostFfHex,
+    HostFfUint32,
+    HostFfInt32,
+} HostFfType;
+
+FlipperFormat* flipper_format_file_alloc(Storage* storage) {
+    FlipperFormat* flipper_format = malloc(sizeof(FlipperFormat));
+    flipper_format->file = storage_file_alloc(storage);
+    return flipper_format;
+}
+
+void flipper_format_free(FlipperFormat* flipper_format) {
+    storage_file_free(flipper_format->file);
+    free(flipper_format);
+}
+
+bool flipper_format_file_open_existing(FlipperFormat* flipper_format, const char* path) {
+    return storage_file_open(flipper_format->file, path, FSAM_READ_WRITE, FSOM_OPEN_EXISTING);
+}
+
+bool flipper_format_file_open_always(FlipperFormat* flipper_format, const char* path) {
+    return storage_file_open(flipper_format->file, path, FSAM_READ_WRITE, FSOM_CREATE_ALWAYS);
+}
+
+static bool host_ff_getc(FlipperFormat* flipper_format, char* c) {
+    return storage_file_read(flipper_format->file, c, 1) == 1;
+}
+
+/**
+ * @brief Move past "key: " of the next line with that key
+ */
+static bool host_ff_seek_to_key(FlipperFormat* flipper_format, const char* key) {
+    char line_key[HOST_FF_KEY_SIZE];
+    char c;
+    while(true) {
+        size_t len = 0;
+        bool too_long = false;
+        do {
+            if(!host_ff_getc(flipper_format, &c)) return false;
+            if(c == ':' || c == '\n') break;
+            if(len < sizeof(line_key) - 1) {
+                line_key[len++] = c;
+            } else {
+                too_long = true;
+            }
+        } while(true);
+        line_key[len] = '\0';
+
+        if(c == ':' && !too_long && strcmp(line_key, key) == 0) {
+            return host_ff_getc(flipper_format, &c) && c == ' ';
+        }
+        while(c != '\n') {
+            if(!host_ff_getc(flipper_format, &c)) return false;
+        }
+    }
+}
+
+/**
+ * @brief Read the next space-separated value of the current line
+ *
+ * @param[out] last true if the value ends the line
+ */
+static bool host_ff_read_value(FlipperFormat* flipper_format, char* value, bool* last) {
+    size_t len = 0;
+    char c;
+    *last = true;
+    while(host_ff_getc(flipper_format, &c) && c != '\n') {
+        if(c == '\r') continue;
+        if(c == ' ') {
+            if(len == 0) continue;
+            *last = false;
+            break;
+        }
+        if(len == HOST_FF_VALUE_SIZE - 1) return false;
+        value[len++] = c;
+    }
+    value[len] = '\0';
+    return len > 0;
+}
+
+static bool host_ff_read_values(
+    FlipperFormat* flipper_format,
+    const char* key,
+    HostFfType type,
+    void* data,
+    uint16_t data_size) {
+    if(!host_ff_seek_to_key(flipper_format, key)) return false;
+
+    char value[HOST_FF_VALUE_SIZE];
+    for(uint16_t i = 0; i < data_size; i++) {
+        bool last;
+        if(!host_ff_read_value(flipper_format, value, &last)) return false;
+
+        char* end;
+        switch(type) {
+        case HostFfHex: {
+            unsigned long byte = strtoul(value, &end, 16);
+            if(strlen(value) != 2 || *end) return false;
+            ((uint8_t*)data)[i] = (uint8_t)byte;
+            break;
+        }
+        case HostFfUint32:
+            ((uint32_t*)data)[i] = (uint32_t)strtoul(value, &end, 10);
+            if(*end) return false;
+            break;
+        case HostFfInt32:
+            ((int32_t*)data)[i] = (int32_t)strtol(value, &end, 10);
+            if(*end) return false;
+            break;
+        }
+        // As on the device, a line with fewer values than asked for fails
+        if(last && i != data_size - 1) return false;
+    }
+    return true;
+}
+
+bool flipper_format_read_string(FlipperFormat* flipper_format, const char* key, FuriString* data) {
+    if(!host_ff_seek_to_key(flipper_format, key)) return false;
+
+    size_t size = 32;
+    size_t len = 0;
+    char* line = malloc(size);
+    char c;
+    while(host_ff_getc(flipper_format, &c) && c != '\n') {
+        if(c == '\r') continue;
+        if(len == size - 1) {
+            size *= 2;
+            line = realloc(line, size);
+        }
+        line[len++] = c;
+    }
+    line[len] = '\0';
+    furi_string_set_str(data, line);
+    free(line);
+    return true;
+}
+
+bool flipper_format_read_header(
+    FlipperFormat* flipper_format,
+    FuriString* filetype,
+    uint32_t* version) {
+    return flipper_format_read_string(flipper_format, "Filetype", filetype) &&
+           flipper_format_read_uint32(flipper_format, "Version", version, 1);
+}
+
+bool flipper_format_get_value_count(
+    FlipperFormat* flipper_format,
+    const char* key,
+    uint32_t* count) {
+    // Counts without moving: the position is restored afterwards
+    uint64_t position = storage_file_tell(flipper_format->file);
+    bool found = host_ff_seek_to_key(flipper_format, key);
+    *count = 0;
+    if(found) {
+        char value[HOST_FF_VALUE_SIZE];
+        bool last = false;
+        while(!last && host_ff_read_value(flipper_format, value, &last)) {
+            (*count)++;
+        }
+    }
+    return storage_file_seek(flipper_format->file, position, true) && found;
+}
+
+bool flipper_format_read_uint32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    uint32_t* data,
+    const uint16_t data_size) {
+    return host_ff_read_values(flipper_format, key, HostFfUint32, data, data_size);
+}
+
+bool flipper_format_read_int32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    int32_t* data,
+    const uint16_t data_size) {
+    return host_ff_read_values(flipper_format, key, HostFfInt32, data, data_size);
+}
+
+bool flipper_format_read_hex(
+    FlipperFormat* flipper_format,
+    const char* key,
+    uint8_t* data,
+    const uint16_t data_size) {
+    return host_ff_read_values(flipper_format, key, HostFfHex, data, data_size);
+}
+
+static bool host_ff_write(FlipperFormat* flipper_format, const char* text) {
+    size_t len = strlen(text);
+    return storage_file_write(flipper_format->file, text, len) == len;
+}
+
+static bool host_ff_write_values(
+    FlipperFormat* flipper_format,
+    const char* key,
+    HostFfType type,
+    const void* data,
+    uint16_t data_size) {
+    if(!host_ff_write(flipper_format, key) || !host_ff_write(flipper_format, ": ")) return false;
+
+    char value[HOST_FF_VALUE_SIZE];
+    for(uint16_t i = 0; i < data_size; i++) {
+        switch(type) {
+        case HostFfHex:
+            snprintf(value, sizeof(value), "%02X", ((const uint8_t*)data)[i]);
+            break;
+        case HostFfUint32:
+            snprintf(value, sizeof(value), "%" PRIu32, ((const uint32_t*)data)[i]);
+            break;
+        case HostFfInt32:
+            snprintf(value, sizeof(value), "%" PRId32, ((const int32_t*)data)[i]);
+            break;
+        }
+        if(!host_ff_write(flipper_format, value)) return false;
+        if(i != data_size - 1 && !host_ff_write(flipper_format, " ")) return false;
+    }
+    return host_ff_write(flipper_format, "\n");
+}
+
+bool flipper_format_write_string_cstr(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const char* data) {
+    return host_ff_write(flipper_format, key) && host_ff_write(flipper_format, ": ") &&
+           host_ff_write(flipper_format, data) && host_ff_write(flipper_format, "\n");
+}
+
+bool flipper_format_write_header_cstr(
+    FlipperFormat* flipper_format,
+    const char* filetype,
+    const uint32_t version) {
+    return flipper_format_write_string_cstr(flipper_format, "Filetype", filetype) &&
+           flipper_format_write_uint32(flipper_format, "Version", &version, 1);
+}
+
+bool flipper_format_write_uint32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const uint32_t* data,
+    const uint16_t data_size) {
+    return host_ff_write_values(flipper_format, key, HostFfUint32, data, data_size);
+}
+
+bool flipper_format_write_int32(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const int32_t* data,
+    const uint16_t data_size) {
+    return host_ff_write_values(flipper_format, key, HostFfInt32, data, data_size);
+}
+
+bool flipper_format_write_hex(
+    FlipperFormat* flipper_format,
+    const char* key,
+    const uint8_t* data,
+    const uint16_t data_size) {
+    return host_ff_write_values(flipper_format, key, HostFfHex, data, data_size);
+}
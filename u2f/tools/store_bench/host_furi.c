@@ -0,0 +1,252 @@
+#include "host_furi.h"
+
+#include <furi.h>
+#include <furi_hal.h>
+#include <storage/storage.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <mbedtls/aes.h>
+
+HostStorageStats host_storage_stats;
+
+static char host_root[PATH_MAX];
+
+struct File {
+    int fd;
+};
+
+struct FuriString {
+    char* data;
+};
+
+void host_storage_set_root(const char* root) {
+    snprintf(host_root, sizeof(host_root), "%s", root);
+    mkdir(host_root, 0700);
+}
+
+static const char* host_path(const char* path, char* buffer) {
+    const char* prefix = EXT_PATH("");
+    if(strncmp(path, prefix, strlen(prefix)) == 0) path += strlen(prefix);
+    snprintf(buffer, PATH_MAX, "%s/%s", host_root, path);
+
+    // Create the parent directory, as the SD card already has it
+    char* slash = strrchr(buffer, '/');
+    if(slash) {
+        *slash = '\0';
+        mkdir(buffer, 0700);
+        *slash = '/';
+    }
+    return buffer;
+}
+
+uint32_t furi_get_tick(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void* furi_record_open(const char* name) {
+    UNUSED(name);
+    return host_root;
+}
+
+void furi_record_close(const char* name) {
+    UNUSED(name);
+}
+
+FuriString* furi_string_alloc(void) {
+    FuriString* string = malloc(sizeof(FuriString));
+    string->data = calloc(1, 1);
+    return string;
+}
+
+void furi_string_free(FuriString* string) {
+    free(string->data);
+    free(string);
+}
+
+const char* furi_string_get_cstr(const FuriString* string) {
+    return string->data;
+}
+
+void furi_string_set_str(FuriString* string, const char* cstr) {
+    free(string->data);
+    string->data = strdup(cstr);
+}
+
+File* storage_file_alloc(Storage* storage) {
+    UNUSED(storage);
+    File* file = malloc(sizeof(File));
+    file->fd = -1;
+    return file;
+}
+
+void storage_file_free(File* file) {
+    storage_file_close(file);
+    free(file);
+}
+
+bool storage_file_open(File* file, const char* path, FS_AccessMode access, FS_OpenMode mode) {
+    int flags = access == FSAM_READ_WRITE ? O_RDWR : access == FSAM_WRITE ? O_WRONLY : O_RDONLY;
+    if(mode == FSOM_OPEN_ALWAYS) flags |= O_CREAT;
+    if(mode == FSOM_OPEN_APPEND) flags |= O_CREAT | O_APPEND;
+    if(mode == FSOM_CREATE_NEW) flags |= O_CREAT | O_EXCL;
+    if(mode == FSOM_CREATE_ALWAYS) flags |= O_CREAT | O_TRUNC;
+
+    char buffer[PATH_MAX];
+    file->fd = open(host_path(path, buffer), flags, 0600);
+    host_storage_stats.opens++;
+    return file->fd >= 0;
+}
+
+bool storage_file_close(File* file) {
+    if(file->fd < 0) return false;
+    close(file->fd);
+    file->fd = -1;
+    return true;
+}
+
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read) {
+    ssize_t read_bytes = read(file->fd, buff, bytes_to_read);
+    host_storage_stats.reads++;
+    if(read_bytes < 0) return 0;
+    host_storage_stats.bytes_read += read_bytes;
+    return read_bytes;
+}
+
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write) {
+    ssize_t written = write(file->fd, buff, bytes_to_write);
+    host_storage_stats.writes++;
+    if(written < 0) return 0;
+    host_storage_stats.bytes_written += written;
+    return written;
+}
+
+bool storage_file_seek(File* file, uint32_t offset, bool from_start) {
+    return lseek(file->fd, offset, from_start ? SEEK_SET : SEEK_CUR) >= 0;
+}
+
+uint64_t storage_file_tell(File* file) {
+    off_t position = lseek(file->fd, 0, SEEK_CUR);
+    return position < 0 ? 0 : (uint64_t)position;
+}
+
+uint64_t storage_file_size(File* file) {
+    struct stat st;
+    return fstat(file->fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+bool storage_file_sync(File* file) {
+    // Counted, not performed: a host fsync says nothing about an SD card
+    host_storage_stats.syncs++;
+    return file->fd >= 0;
+}
+
+bool storage_simply_remove(Storage* storage, const char* path) {
+    UNUSED(storage);
+    char buffer[PATH_MAX];
+    return unlink(host_path(path, buffer)) == 0 || errno == ENOENT;
+}
+
+bool storage_dir_exists(Storage* storage, const char* path) {
+    UNUSED(storage);
+    char buffer[PATH_MAX];
+    struct stat st;
+    return stat(host_path(path, buffer), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+FS_Error storage_common_stat(Storage* storage, const char* path, FileInfo* fileinfo) {
+    UNUSED(storage);
+    char buffer[PATH_MAX];
+    struct stat st;
+    if(stat(host_path(path, buffer), &st) != 0) return FSE_NOT_EXIST;
+    if(fileinfo) {
+        fileinfo->flags = 0;
+        fileinfo->size = st.st_size;
+    }
+    return FSE_OK;
+}
+
+FS_Error storage_common_rename(Storage* storage, const char* old_path, const char* new_path) {
+    UNUSED(storage);
+    char old_buffer[PATH_MAX];
+    char new_buffer[PATH_MAX];
+    return rename(host_path(old_path, old_buffer), host_path(new_path, new_buffer)) == 0 ?
+               FSE_OK :
+               FSE_INTERNAL;
+}
+
+// A fixed stand-in for the unique key of the secure enclave
+static const uint8_t host_unique_key[32] = {
+    0x48, 0x6f, 0x73, 0x74, 0x20, 0x75, 0x6e, 0x69, 0x71, 0x75, 0x65, 0x20, 0x6b, 0x65, 0x79, 0x21,
+    0x4e, 0x6f, 0x74, 0x20, 0x61, 0x20, 0x73, 0x65, 0x63, 0x72, 0x65, 0x74, 0x20, 0x6b, 0x65, 0x79,
+};
+static uint8_t host_key_iv[16];
+static bool host_key_loaded;
+
+bool furi_hal_crypto_enclave_ensure_key(uint8_t key_slot) {
+    return key_slot == FURI_HAL_CRYPTO_ENCLAVE_UNIQUE_KEY_SLOT;
+}
+
+bool furi_hal_crypto_enclave_load_key(uint8_t key_slot, const uint8_t* iv) {
+    furi_check(!host_key_loaded);
+    if(key_slot != FURI_HAL_CRYPTO_ENCLAVE_UNIQUE_KEY_SLOT) return false;
+    memcpy(host_key_iv, iv, sizeof(host_key_iv));
+    host_key_loaded = true;
+    return true;
+}
+
+bool furi_hal_crypto_enclave_unload_key(uint8_t key_slot) {
+    UNUSED(key_slot);
+    furi_check(host_key_loaded);
+    host_key_loaded = false;
+    return true;
+}
+
+static bool host_cbc(const uint8_t* input, uint8_t* output, size_t size, int mode) {
+    furi_check(host_key_loaded);
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    int ret = mode == MBEDTLS_AES_ENCRYPT ?
+                  mbedtls_aes_setkey_enc(&aes, host_unique_key, 256) :
+                  mbedtls_aes_setkey_dec(&aes, host_unique_key, 256);
+    // The peripheral chains blocks across calls, like the iv here
+    if(ret == 0) ret = mbedtls_aes_crypt_cbc(&aes, mode, size, host_key_iv, input, output);
+    mbedtls_aes_free(&aes);
+    return ret == 0;
+}
+
+bool furi_hal_crypto_encrypt(const uint8_t* input, uint8_t* output, size_t size) {
+    return host_cbc(input, output, size, MBEDTLS_AES_ENCRYPT);
+}
+
+bool furi_hal_crypto_decrypt(const uint8_t* input, uint8_t* output, size_t size) {
+    return host_cbc(input, output, size, MBEDTLS_AES_DECRYPT);
+}
+
+bool furi_hal_crypto_ctr(
+    const uint8_t* key,
+    const uint8_t* iv,
+    const uint8_t* input,
+    uint8_t* output,
+    size_t length) {
+    uint8_t counter[16];
+    uint8_t stream[16];
+    size_t offset = 0;
+    memcpy(counter, iv, sizeof(counter));
+
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    bool success = mbedtls_aes_setkey_enc(&aes, key, 256) == 0 &&
+                   mbedtls_aes_crypt_ctr(&aes, length, &offset, counter, stream, input, output) ==
+                       0;
+    mbedtls_aes_free(&aes);
+    return success;
+}
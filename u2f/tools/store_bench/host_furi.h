@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Storage calls made since the last reset
+ *
+ * On the device every open, read and sync is an SD card transaction, so
+ * these counts say more about on-device cost than host timings do.
+ */
+typedef struct {
+    uint32_t opens;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t syncs;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+} HostStorageStats;
+
+extern HostStorageStats host_storage_stats;
+
+/**
+ * @brief Map /ext/ to a host directory, which is created if missing
+ */
+void host_storage_set_root(const char* root);
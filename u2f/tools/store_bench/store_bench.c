@@ -0,0 +1,296 @@
+/**
+ * @brief Host benchmark for loading and saving the FIDO2 credential store
+ *
+ * Fills stores of several sizes with synthetic credentials, then times
+ * load, lookups, journal appends and save on a host directory standing in
+ * for the SD card. text_save and text_load do the same for the FlipperFormat
+ * text file of earlier versions: text_save writes it the way its save did,
+ * text_load migrates it to a page file, so its reads are those of the old
+ * load and its writes build the page file. Run from the u2f directory:
+ *
+ *   cc -O2 -Itools/store_bench -Itools/p256_bench -I. tools/store_bench/store_bench.c \
+ *       tools/store_bench/host_furi.c tools/store_bench/host_flipper_format.c fido2_data.c \
+ *       fido2_credential.c fido2_page_store.c fido2_vault.c fido2_crc32.c fido2_ed25519.c \
+ *       fido_keypair_pool.c fido_nonce_pool.c fido_p256.c fido_p256_mbedtls.c \
+ *       fido_p256_comb.c fido_drbg.c fido_hmac.c \
+ *       -lmbedcrypto -lpthread -o store_bench
+ *
+ *   ./store_bench [directory]
+ *
+ * The directory (default /tmp/store_bench) is wiped before every store
+ * size. Besides host time, each operation reports the storage calls it
+ * made: on the device each open, read and sync is an SD transaction and
+ * costs milliseconds, so compare those counts, not the host times, when
+ * judging a format change.
+ */
+#include "fido2_credential_i.h"
+#include "fido2_data.h"
+#include "fido_drbg.h"
+#include "host_furi.h"
+
+#include <furi.h>
+#include <storage/storage.h>
+#include <flipper_format/flipper_format.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MIN_SECONDS 0.5
+#define BENCH_DEFAULT_DIR "/tmp/store_bench"
+
+// Text file as the FlipperFormat save of earlier versions wrote it
+#define BENCH_TEXT_FILE_TYPE "Flipper FIDO2 Credential File"
+#define BENCH_TEXT_VERSION   1
+
+static const size_t bench_sizes[] = {10, 100, FIDO2_MAX_CREDENTIALS};
+
+typedef struct {
+    Fido2CredentialStore* store;
+    Fido2Credential* records; // the fill, all in RAM as earlier versions kept it
+    size_t count;
+    size_t next; // rotates lookups over the whole store
+} BenchState;
+
+typedef bool (*BenchOp)(BenchState* state);
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_rp_id(size_t index, char* rp_id) {
+    snprintf(rp_id, FIDO2_RP_ID_MAX_SIZE, "rp%u.example.com", (unsigned)index);
+}
+
+static void bench_credential(size_t index, Fido2Credential* cred) {
+    memset(cred, 0, sizeof(Fido2Credential));
+    fido_drbg_fill(cred->credential_id, sizeof(cred->credential_id));
+    fido_drbg_fill(cred->private_key, sizeof(cred->private_key));
+    fido_drbg_fill(cred->public_key_x, sizeof(cred->public_key_x));
+    fido_drbg_fill(cred->public_key_y, sizeof(cred->public_key_y));
+    bench_rp_id(index, cred->rp_id);
+    cred->user_id_len = 16;
+    fido_drbg_fill(cred->user_id, cred->user_id_len);
+    snprintf(cred->user_name, sizeof(cred->user_name), "user%u", (unsigned)index);
+    snprintf(cred->user_display_name, sizeof(cred->user_display_name), "User %u", (unsigned)index);
+    cred->sign_count = index;
+    cred->algorithm = -7; // ES256
+}
+
+static bool bench_load(BenchState* state) {
+    fido2_credential_store_free(state->store);
+    state->store = fido2_credential_store_alloc();
+    return fido2_data_load_credentials(state->store) &&
+           fido2_credential_count(state->store) == state->count;
+}
+
+static bool bench_load_scan(BenchState* state) {
+    // Without the page index, every page header is read
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_simply_remove(storage, FIDO2_PAGE_INDEX_FILE);
+    furi_record_close(RECORD_STORAGE);
+    return bench_load(state);
+}
+
+static bool bench_find_rp(BenchState* state) {
+    char rp_id[FIDO2_RP_ID_MAX_SIZE];
+    bench_rp_id(state->next, rp_id);
+    state->next = (state->next + 7) % state->count;
+    return fido2_credential_find_by_rp(state->store, rp_id) != NULL;
+}
+
+static bool bench_find_miss(BenchState* state) {
+    return fido2_credential_find_by_rp(state->store, "unknown.example.com") == NULL;
+}
+
+static bool bench_log_counter(BenchState* state) {
+    char rp_id[FIDO2_RP_ID_MAX_SIZE];
+    bench_rp_id(state->next, rp_id);
+    Fido2Credential* cred = fido2_credential_find_by_rp(state->store, rp_id);
+    if(!cred) return false;
+    cred->sign_count += FIDO2_SIGN_COUNT_LEASE;
+    cred->sign_count_ceiling = cred->sign_count;
+    return fido2_data_log_counter(state->store, cred);
+}
+
+static bool bench_save(BenchState* state) {
+    // What compaction does: one changed page plus the journal behind it
+    return bench_log_counter(state) && fido2_data_save_credentials(state->store);
+}
+
+static bool bench_text_save(BenchState* state) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    FlipperFormat* flipper_format = flipper_format_file_alloc(storage);
+    uint32_t count = state->count;
+    bool success =
+        flipper_format_file_open_always(flipper_format, FIDO2_CRED_LEGACY_FILE) &&
+        flipper_format_write_header_cstr(
+            flipper_format, BENCH_TEXT_FILE_TYPE, BENCH_TEXT_VERSION) &&
+        flipper_format_write_uint32(flipper_format, "Count", &count, 1);
+
+    char key[32];
+    for(uint32_t i = 0; i < count && success; i++) {
+        Fido2Credential* cred = &state->records[i];
+        uint32_t len = cred->user_id_len;
+        snprintf(key, sizeof(key), "CredID_%u", (unsigned)i);
+        success = flipper_format_write_hex(flipper_format, key, cred->credential_id, 32);
+        snprintf(key, sizeof(key), "PrivKey_%u", (unsigned)i);
+        success = success && flipper_format_write_hex(flipper_format, key, cred->private_key, 32);
+        snprintf(key, sizeof(key), "PubKeyX_%u", (unsigned)i);
+        success = success && flipper_format_write_hex(flipper_format, key, cred->public_key_x, 32);
+        snprintf(key, sizeof(key), "PubKeyY_%u", (unsigned)i);
+        success = success && flipper_format_write_hex(flipper_format, key, cred->public_key_y, 32);
+        snprintf(key, sizeof(key), "RPID_%u", (unsigned)i);
+        success = success && flipper_format_write_string_cstr(flipper_format, key, cred->rp_id);
+        snprintf(key, sizeof(key), "UserID_%u", (unsigned)i);
+        success = success && flipper_format_write_hex(flipper_format, key, cred->user_id, len);
+        snprintf(key, sizeof(key), "UserIDLen_%u", (unsigned)i);
+        success = success && flipper_format_write_uint32(flipper_format, key, &len, 1);
+        snprintf(key, sizeof(key), "UserName_%u", (unsigned)i);
+        success = success &&
+                  flipper_format_write_string_cstr(flipper_format, key, cred->user_name);
+        snprintf(key, sizeof(key), "UserDisplay_%u", (unsigned)i);
+        success = success &&
+                  flipper_format_write_string_cstr(flipper_format, key, cred->user_display_name);
+        snprintf(key, sizeof(key), "SignCount_%u", (unsigned)i);
+        success = success &&
+                  flipper_format_write_uint32(flipper_format, key, &cred->sign_count, 1);
+    }
+
+    flipper_format_free(flipper_format);
+    furi_record_close(RECORD_STORAGE);
+    return success;
+}
+
+static bool bench_prepare_text_load(BenchState* state) {
+    // Only the text file, as on a card last written by an earlier version
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_simply_remove(storage, FIDO2_PAGE_FILE);
+    storage_simply_remove(storage, FIDO2_PAGE_INDEX_FILE);
+    storage_simply_remove(storage, FIDO2_PAGE_TEMP_FILE);
+    storage_simply_remove(storage, FIDO2_CRED_JOURNAL_FILE);
+    furi_record_close(RECORD_STORAGE);
+    return bench_text_save(state);
+}
+
+static bool bench_text_load(BenchState* state) {
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    bool migrated = bench_load(state) &&
+                    storage_common_stat(storage, FIDO2_CRED_LEGACY_FILE, NULL) != FSE_OK;
+    furi_record_close(RECORD_STORAGE);
+    return migrated;
+}
+
+// prepare runs untimed and uncounted before every op
+static const struct {
+    const char* name;
+    BenchOp op;
+    BenchOp prepare;
+} bench_ops[] = {
+    {"load", bench_load, NULL},
+    {"load_scan", bench_load_scan, NULL},
+    {"find_rp", bench_find_rp, NULL},
+    {"find_miss", bench_find_miss, NULL},
+    {"log_counter", bench_log_counter, NULL},
+    {"save", bench_save, NULL},
+    {"text_save", bench_text_save, NULL},
+    {"text_load", bench_text_load, bench_prepare_text_load},
+};
+
+static bool bench_fill(BenchState* state, const char* dir, size_t count) {
+    char command[256];
+    snprintf(command, sizeof(command), "rm -rf '%s'", dir);
+    if(system(command) != 0) return false;
+    host_storage_set_root(dir);
+
+    state->count = count;
+    state->next = 0;
+    state->store = fido2_credential_store_alloc();
+    state->records = calloc(count, sizeof(Fido2Credential));
+    if(!fido2_data_load_credentials(state->store)) return false;
+
+    for(size_t i = 0; i < count; i++) {
+        bench_credential(i, &state->records[i]);
+        if(!fido2_credential_import(state->store, &state->records[i])) return false;
+    }
+    return fido2_data_save_credentials(state->store);
+}
+
+static void bench_run(BenchState* state, size_t index) {
+    BenchOp op = bench_ops[index].op;
+    BenchOp prepare = bench_ops[index].prepare;
+    HostStorageStats total = {0};
+    size_t iterations = 0;
+    double elapsed = 0;
+    do {
+        if(prepare && !prepare(state)) {
+            fprintf(stderr, "%s: prepare failed\n", bench_ops[index].name);
+            exit(1);
+        }
+        HostStorageStats before = host_storage_stats;
+        double start = bench_now();
+        if(!op(state)) {
+            fprintf(
+                stderr,
+                "%s failed at %u credentials\n",
+                bench_ops[index].name,
+                (unsigned)state->count);
+            exit(1);
+        }
+        elapsed += bench_now() - start;
+        total.opens += host_storage_stats.opens - before.opens;
+        total.reads += host_storage_stats.reads - before.reads;
+        total.writes += host_storage_stats.writes - before.writes;
+        total.syncs += host_storage_stats.syncs - before.syncs;
+        total.bytes_read += host_storage_stats.bytes_read - before.bytes_read;
+        total.bytes_written += host_storage_stats.bytes_written - before.bytes_written;
+        iterations++;
+    } while(elapsed < BENCH_MIN_SECONDS);
+
+    printf(
+        "%6u %-12s %10.1f %7.1f %7.1f %7.1f %6.1f %9.0f %9.0f\n",
+        (unsigned)state->count,
+        bench_ops[index].name,
+        elapsed * 1e6 / iterations,
+        (double)total.opens / iterations,
+        (double)total.reads / iterations,
+        (double)total.writes / iterations,
+        (double)total.syncs / iterations,
+        (double)total.bytes_read / iterations,
+        (double)total.bytes_written / iterations);
+}
+
+int main(int argc, char** argv) {
+    const char* dir = argc > 1 ? argv[1] : BENCH_DEFAULT_DIR;
+    fido_drbg_init();
+
+    printf(
+        "%6s %-12s %10s %7s %7s %7s %6s %9s %9s\n",
+        "creds",
+        "operation",
+        "us/op",
+        "opens",
+        "reads",
+        "writes",
+        "syncs",
+        "B read",
+        "B written");
+    for(size_t size = 0; size < COUNT_OF(bench_sizes); size++) {
+        BenchState state;
+        if(!bench_fill(&state, dir, bench_sizes[size])) {
+            fprintf(stderr, "could not fill a store of %u\n", (unsigned)bench_sizes[size]);
+            return 1;
+        }
+        for(size_t i = 0; i < COUNT_OF(bench_ops); i++) {
+            bench_run(&state, i);
+        }
+        fido2_credential_store_free(state.store);
+        memset(state.records, 0, state.count * sizeof(Fido2Credential));
+        free(state.records);
+    }
+
+    fido_drbg_deinit();
+    return 0;
+}
@@ -1,14 +1,16 @@
 #include "u2f.h"
 #include "u2f_data.h"
+#include "fido_templates.h"
+#include "fido_p256.h"
+#include "fido_nonce_pool.h"
+#include "fido_hmac.h"
+#include "u2f_handle_cache.h"
+#include "fido_drbg.h"
 
 #include <furi.h>
 #include <furi_hal.h>
-#include <furi_hal_random.h>
 
 #include <mbedtls/sha256.h>
-#include <mbedtls/md.h>
-#include <mbedtls/ecdsa.h>
-#include <mbedtls/error.h>
 
 #define TAG "U2f"
 
@@ -48,6 +50,9 @@ typedef struct {
     uint8_t hash[U2F_HASH_SIZE];
     uint8_t nonce[U2F_NONCE_SIZE];
 } FURI_PACKED U2fKeyHandle;
+_Static_assert(
+    sizeof(U2fKeyHandle) - 1 == U2F_HANDLE_CACHE_HANDLE_SIZE,
+    "U2fKeyHandle size mismatch");
 
 typedef struct {
     uint8_t cla;
@@ -83,7 +88,8 @@ typedef struct {
     uint8_t signature[];
 } FURI_PACKED U2fAuthResp;
 
-static const uint8_t ver_str[] = {"U2F_V2"};
+// Counter values handed out per persisted lease; cnt.u2f always holds the ceiling
+#define U2F_COUNTER_LEASE 32
 
 static const uint8_t state_no_error[] = {0x90, 0x00};
 static const uint8_t state_not_supported[] = {0x6D, 0x00};
@@ -92,19 +98,40 @@ static const uint8_t state_wrong_data[] = {0x6A, 0x80};
 
 struct U2fData {
     uint8_t device_key[U2F_EC_KEY_SIZE];
+    FidoHmacKey device_hmac; // device_key midstates, set up once in u2f_init
     uint8_t cert_key[U2F_EC_KEY_SIZE];
     uint32_t counter;
+    uint32_t counter_ceiling; // highest value covered by the persisted lease
     bool ready;
     bool user_present;
     U2fEvtCallback callback;
     void* context;
-    mbedtls_ecp_group group;
+    FidoLab* lab; // optional test-lab auto-presence policy, not owned
+    FidoP256* p256;
+    FidoNoncePool* nonce_pool;
+    U2fHandleCache* handle_cache; // handles verified by recent check-only requests
+    FidoP256YieldCallback yield; // only installed during precomputation
+    void* yield_context;
 };
 
-static int u2f_uecc_random_cb(void* context, uint8_t* dest, unsigned size) {
-    UNUSED(context);
-    furi_hal_random_fill_buf(dest, size);
-    return 0;
+/**
+ * @brief Make sure the next counter value is covered by a persisted lease
+ *
+ * Persists counter + U2F_COUNTER_LEASE once every U2F_COUNTER_LEASE
+ * authentications instead of after each one. After a crash the counter
+ * resumes from the stored ceiling, so it never goes backwards.
+ */
+static bool u2f_counter_reserve(U2fData* U2F) {
+    if(U2F->counter < U2F->counter_ceiling) return true;
+
+    uint32_t ceiling = U2F->counter + U2F_COUNTER_LEASE;
+    if(u2f_data_cnt_write(ceiling) == false) {
+        FURI_LOG_E(TAG, "Counter lease write failed");
+        return false;
+    }
+    U2F->counter_ceiling = ceiling;
+    FURI_LOG_D(TAG, "Counter lease up to %lu", ceiling);
+    return true;
 }
 
 U2fData* u2f_alloc(void) {
@@ -113,7 +140,10 @@ U2fData* u2f_alloc(void) {
 
 void u2f_free(U2fData* U2F) {
     furi_assert(U2F);
-    mbedtls_ecp_group_free(&U2F->group);
+    u2f_handle_cache_free(U2F->handle_cache);
+    fido_nonce_pool_free(U2F->nonce_pool);
+    fido_p256_free(U2F->p256);
+    fido_hmac_key_wipe(&U2F->device_hmac);
     free(U2F);
 }
 
@@ -135,6 +165,7 @@ bool u2f_init(U2fData* U2F) {
             return false;
         }
     }
+    fido_hmac_key_init(&U2F->device_hmac, U2F->device_key, sizeof(U2F->device_key));
     if(u2f_data_cnt_read(&U2F->counter) == false) {
         FURI_LOG_W(TAG, "Counter loading error, resetting counter");
         U2F->counter = 0;
@@ -143,14 +174,34 @@ bool u2f_init(U2fData* U2F) {
             return false;
         }
     }
+    // The stored value is a lease ceiling that may already have been served
+    U2F->counter_ceiling = U2F->counter;
 
-    mbedtls_ecp_group_init(&U2F->group);
-    mbedtls_ecp_group_load(&U2F->group, MBEDTLS_ECP_DP_SECP256R1);
+    if(U2F->p256 == NULL) {
+        U2F->p256 = fido_p256_alloc();
+        U2F->nonce_pool = fido_nonce_pool_alloc(U2F->p256);
+        U2F->handle_cache = u2f_handle_cache_alloc();
+    } else {
+        // The device key may have been regenerated
+        u2f_handle_cache_clear(U2F->handle_cache);
+    }
 
     U2F->ready = true;
     return true;
 }
 
+bool u2f_precompute(U2fData* U2F) {
+    furi_assert(U2F);
+    if(U2F->nonce_pool == NULL) return false;
+    // Requests must not fail halfway, so the yield callback is scoped to the refill
+    fido_p256_set_yield_callback(U2F->p256, U2F->yield, U2F->yield_context);
+    bool refilled = fido_nonce_pool_refill(U2F->nonce_pool);
+    fido_p256_set_yield_callback(U2F->p256, NULL, NULL);
+    // Keep getting called while cached handles are waiting to expire
+    bool cache_live = u2f_handle_cache_expire(U2F->handle_cache);
+    return refilled || cache_live;
+}
+
 void u2f_set_event_callback(U2fData* U2F, U2fEvtCallback callback, void* context) {
     furi_assert(U2F);
     furi_assert(callback);
@@ -158,79 +209,29 @@ void u2f_set_event_callback(U2fData* U2F, U2fEvtCallback callback, void* context
     U2F->context = context;
 }
 
-void u2f_confirm_user_present(U2fData* U2F) {
-    U2F->user_present = true;
+void u2f_set_yield_callback(U2fData* U2F, FidoP256YieldCallback callback, void* context) {
+    furi_assert(U2F);
+    U2F->yield = callback;
+    U2F->yield_context = context;
 }
 
-static uint8_t u2f_der_encode_int(uint8_t* der, uint8_t* val, uint8_t val_len) {
-    der[0] = 0x02; // Integer
-
-    uint8_t len = 2;
-    // Omit leading zeros
-    while(val[0] == 0 && val_len > 0) {
-        ++val;
-        --val_len;
-    }
-
-    // Check if integer is negative
-    if(val[0] > 0x7f) der[len++] = 0;
-
-    memcpy(der + len, val, val_len);
-    len += val_len;
-
-    der[1] = len - 2;
-    return len;
+void u2f_set_lab_policy(U2fData* U2F, FidoLab* lab) {
+    furi_assert(U2F);
+    U2F->lab = lab;
 }
 
-static uint8_t u2f_der_encode_signature(uint8_t* der, uint8_t* sig) {
-    der[0] = 0x30;
-
-    uint8_t len = 2;
-    len += u2f_der_encode_int(der + len, sig, U2F_HASH_SIZE);
-    len += u2f_der_encode_int(der + len, sig + U2F_HASH_SIZE, U2F_HASH_SIZE);
-
-    der[1] = len - 2;
-    return len;
+void u2f_confirm_user_present(U2fData* U2F) {
+    U2F->user_present = true;
 }
 
-static void
-    u2f_ecc_sign(mbedtls_ecp_group* grp, const uint8_t* key, uint8_t* hash, uint8_t* signature) {
-    mbedtls_mpi r, s, d;
-
-    mbedtls_mpi_init(&r);
-    mbedtls_mpi_init(&s);
-    mbedtls_mpi_init(&d);
-
-    MCHECK(mbedtls_mpi_read_binary(&d, key, U2F_EC_KEY_SIZE));
-    MCHECK(mbedtls_ecdsa_sign(grp, &r, &s, &d, hash, U2F_HASH_SIZE, u2f_uecc_random_cb, NULL));
-    MCHECK(mbedtls_mpi_write_binary(&r, signature, U2F_EC_BIGNUM_SIZE));
-    MCHECK(mbedtls_mpi_write_binary(&s, signature + U2F_EC_BIGNUM_SIZE, U2F_EC_BIGNUM_SIZE));
-
-    mbedtls_mpi_free(&r);
-    mbedtls_mpi_free(&s);
-    mbedtls_mpi_free(&d);
+static void u2f_ecc_sign(U2fData* U2F, const uint8_t* key, uint8_t* hash, uint8_t* signature) {
+    furi_check(fido_nonce_pool_sign(U2F->nonce_pool, key, hash, signature));
 }
 
-static void u2f_ecc_compute_public_key(
-    mbedtls_ecp_group* grp,
-    const uint8_t* private_key,
-    U2fPubKey* public_key) {
-    mbedtls_ecp_point Q;
-    mbedtls_mpi d;
-    size_t olen;
-
-    mbedtls_ecp_point_init(&Q);
-    mbedtls_mpi_init(&d);
-
-    MCHECK(mbedtls_mpi_read_binary(&d, private_key, U2F_EC_KEY_SIZE));
-    MCHECK(mbedtls_ecp_mul(grp, &Q, &d, &grp->G, u2f_uecc_random_cb, NULL));
-    MCHECK(mbedtls_ecp_check_privkey(grp, &d));
-
-    MCHECK(mbedtls_ecp_point_write_binary(
-        grp, &Q, MBEDTLS_ECP_PF_UNCOMPRESSED, &olen, (unsigned char*)public_key, sizeof(U2fPubKey)));
-
-    mbedtls_ecp_point_free(&Q);
-    mbedtls_mpi_free(&d);
+static void
+    u2f_ecc_compute_public_key(U2fData* U2F, const uint8_t* private_key, U2fPubKey* public_key) {
+    public_key->format = 0x04; // Uncompressed point
+    furi_check(fido_p256_public_key(U2F->p256, private_key, public_key->xy));
 }
 
 ///////////////////////////////////////////
@@ -251,7 +252,12 @@ static uint16_t u2f_register(U2fData* U2F, uint8_t* buf) {
         return 2;
     }
 
-    if(U2F->callback != NULL) U2F->callback(U2fNotifyRegister, U2F->context);
+    if(fido_lab_auto_presence(U2F->lab, req->app_id)) {
+        // Lab mode: presence confirmed by policy, no UI prompt
+        U2F->user_present = true;
+    } else if(U2F->callback != NULL) {
+        U2F->callback(U2fNotifyRegister, U2F->context);
+    }
     if(U2F->user_present == false) {
         memcpy(&buf[0], state_user_missing, 2);
         return 2;
@@ -261,31 +267,26 @@ static uint16_t u2f_register(U2fData* U2F, uint8_t* buf) {
     handle.len = U2F_HASH_SIZE * 2;
 
     // Generate random nonce
-    furi_hal_random_fill_buf(handle.nonce, 32);
+    fido_drbg_fill(handle.nonce, 32);
 
     {
-        mbedtls_md_context_t hmac_ctx;
-        mbedtls_md_init(&hmac_ctx);
-        MCHECK(mbedtls_md_setup(&hmac_ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1));
-        MCHECK(mbedtls_md_hmac_starts(&hmac_ctx, U2F->device_key, sizeof(U2F->device_key)));
+        FidoHmac hmac;
 
         // Generate private key
-        MCHECK(mbedtls_md_hmac_update(&hmac_ctx, req->app_id, sizeof(req->app_id)));
-        MCHECK(mbedtls_md_hmac_update(&hmac_ctx, handle.nonce, sizeof(handle.nonce)));
-        MCHECK(mbedtls_md_hmac_finish(&hmac_ctx, private));
-
-        MCHECK(mbedtls_md_hmac_reset(&hmac_ctx));
+        fido_hmac_start(&hmac, &U2F->device_hmac);
+        fido_hmac_update(&hmac, req->app_id, sizeof(req->app_id));
+        fido_hmac_update(&hmac, handle.nonce, sizeof(handle.nonce));
+        fido_hmac_finish(&hmac, private);
 
         // Generate private key handle
-        MCHECK(mbedtls_md_hmac_update(&hmac_ctx, private, sizeof(private)));
-        MCHECK(mbedtls_md_hmac_update(&hmac_ctx, req->app_id, sizeof(req->app_id)));
-        MCHECK(mbedtls_md_hmac_finish(&hmac_ctx, handle.hash));
-
-        mbedtls_md_free(&hmac_ctx);
+        fido_hmac_start(&hmac, &U2F->device_hmac);
+        fido_hmac_update(&hmac, private, sizeof(private));
+        fido_hmac_update(&hmac, req->app_id, sizeof(req->app_id));
+        fido_hmac_finish(&hmac, handle.hash);
     }
 
     // Generate public key
-    u2f_ecc_compute_public_key(&U2F->group, private, &pub_key);
+    u2f_ecc_compute_public_key(U2F, private, &pub_key);
 
     // Generate signature
     {
@@ -307,14 +308,14 @@ static uint16_t u2f_register(U2fData* U2F, uint8_t* buf) {
     }
 
     // Sign hash
-    u2f_ecc_sign(&U2F->group, U2F->cert_key, hash, signature);
+    u2f_ecc_sign(U2F, U2F->cert_key, hash, signature);
 
     // Encode response message
     resp->reserved = 0x05;
     memcpy(&(resp->pub_key), &pub_key, sizeof(U2fPubKey));
     memcpy(&(resp->key_handle), &handle, sizeof(U2fKeyHandle));
     uint32_t cert_len = u2f_data_cert_load(resp->cert);
-    uint8_t signature_len = u2f_der_encode_signature(resp->cert + cert_len, signature);
+    uint8_t signature_len = fido_p256_der_encode(resp->cert + cert_len, signature);
     memcpy(resp->cert + cert_len + signature_len, state_no_error, 2);
 
     return sizeof(U2fRegisterResp) + cert_len + signature_len + 2;
@@ -341,7 +342,12 @@ static uint16_t u2f_authenticate(U2fData* U2F, uint8_t* buf) {
         return 2;
     }
 
-    if(U2F->callback != NULL) U2F->callback(U2fNotifyAuth, U2F->context);
+    if(req->p1 != U2fCheckOnly && fido_lab_auto_presence(U2F->lab, req->app_id)) {
+        // Lab mode: presence confirmed by policy, no UI prompt
+        U2F->user_present = true;
+    } else if(U2F->callback != NULL) {
+        U2F->callback(U2fNotifyAuth, U2F->context);
+    }
     if(U2F->user_present == true) {
         flags |= 1;
     } else {
@@ -352,6 +358,38 @@ static uint16_t u2f_authenticate(U2fData* U2F, uint8_t* buf) {
     }
     U2F->user_present = false;
 
+    // Validate the handle before hashing, so check-only probes never hash
+    if(!u2f_handle_cache_lookup(
+           U2F->handle_cache, req->app_id, req->key_handle.hash, priv_key)) {
+        FidoHmac hmac;
+
+        // Recover private key
+        fido_hmac_start(&hmac, &U2F->device_hmac);
+        fido_hmac_update(&hmac, req->app_id, sizeof(req->app_id));
+        fido_hmac_update(&hmac, req->key_handle.nonce, sizeof(req->key_handle.nonce));
+        fido_hmac_finish(&hmac, priv_key);
+
+        // Generate and verify private key handle
+        fido_hmac_start(&hmac, &U2F->device_hmac);
+        fido_hmac_update(&hmac, priv_key, sizeof(priv_key));
+        fido_hmac_update(&hmac, req->app_id, sizeof(req->app_id));
+        fido_hmac_finish(&hmac, mac_control);
+
+        if(memcmp(req->key_handle.hash, mac_control, sizeof(mac_control)) != 0) {
+            FURI_LOG_W(TAG, "Wrong handle!");
+            memset(priv_key, 0, sizeof(priv_key));
+            memcpy(&buf[0], state_wrong_data, 2);
+            return 2;
+        }
+        u2f_handle_cache_insert(U2F->handle_cache, req->app_id, req->key_handle.hash, priv_key);
+    }
+
+    if(req->p1 == U2fCheckOnly) { // Check-only: don't need to send full response
+        memset(priv_key, 0, sizeof(priv_key));
+        memcpy(&buf[0], state_user_missing, 2);
+        return 2;
+    }
+
     // The 4 byte counter is represented in big endian. Increment it before use
     be_u2f_counter = u2f_to_big_endian(U2F->counter + 1);
 
@@ -371,50 +409,25 @@ static uint16_t u2f_authenticate(U2fData* U2F, uint8_t* buf) {
         mbedtls_sha256_free(&sha_ctx);
     }
 
-    {
-        mbedtls_md_context_t hmac_ctx;
-        mbedtls_md_init(&hmac_ctx);
-        MCHECK(mbedtls_md_setup(&hmac_ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1));
-        MCHECK(mbedtls_md_hmac_starts(&hmac_ctx, U2F->device_key, sizeof(U2F->device_key)));
-
-        // Recover private key
-        MCHECK(mbedtls_md_hmac_update(&hmac_ctx, req->app_id, sizeof(req->app_id)));
-        MCHECK(mbedtls_md_hmac_update(
-            &hmac_ctx, req->key_handle.nonce, sizeof(req->key_handle.nonce)));
-        MCHECK(mbedtls_md_hmac_finish(&hmac_ctx, priv_key));
-
-        MCHECK(mbedtls_md_hmac_reset(&hmac_ctx));
-
-        // Generate and verify private key handle
-        MCHECK(mbedtls_md_hmac_update(&hmac_ctx, priv_key, sizeof(priv_key)));
-        MCHECK(mbedtls_md_hmac_update(&hmac_ctx, req->app_id, sizeof(req->app_id)));
-        MCHECK(mbedtls_md_hmac_finish(&hmac_ctx, mac_control));
-
-        mbedtls_md_free(&hmac_ctx);
-    }
-
-    if(memcmp(req->key_handle.hash, mac_control, sizeof(mac_control)) != 0) {
-        FURI_LOG_W(TAG, "Wrong handle!");
+    // The counter value must be covered by a persisted lease before it is released
+    if(u2f_counter_reserve(U2F) == false) {
+        if(U2F->callback != NULL) U2F->callback(U2fNotifyError, U2F->context);
+        memset(priv_key, 0, sizeof(priv_key));
         memcpy(&buf[0], state_wrong_data, 2);
         return 2;
     }
 
-    if(req->p1 == U2fCheckOnly) { // Check-only: don't need to send full response
-        memcpy(&buf[0], state_user_missing, 2);
-        return 2;
-    }
-
     // Sign hash
-    u2f_ecc_sign(&U2F->group, priv_key, hash, signature);
+    u2f_ecc_sign(U2F, priv_key, hash, signature);
+    memset(priv_key, 0, sizeof(priv_key));
 
     resp->user_present = flags;
     resp->counter = be_u2f_counter;
-    uint8_t signature_len = u2f_der_encode_signature(resp->signature, signature);
+    uint8_t signature_len = fido_p256_der_encode(resp->signature, signature);
     memcpy(resp->signature + signature_len, state_no_error, 2);
 
     U2F->counter++;
     FURI_LOG_D(TAG, "Counter: %lu", U2F->counter);
-    u2f_data_cnt_write(U2F->counter);
 
     if(U2F->callback != NULL) U2F->callback(U2fNotifyAuthSuccess, U2F->context);
 
@@ -432,9 +445,8 @@ uint16_t u2f_msg_parse(U2fData* U2F, uint8_t* buf, uint16_t len) {
         return u2f_authenticate(U2F, buf);
 
     } else if(buf[1] == U2F_CMD_VERSION) { // Get U2F version string
-        memcpy(&buf[0], ver_str, 6);
-        memcpy(&buf[6], state_no_error, 2);
-        return 8;
+        memcpy(&buf[0], U2F_VERSION_RESPONSE, sizeof(U2F_VERSION_RESPONSE));
+        return sizeof(U2F_VERSION_RESPONSE);
     } else {
         memcpy(&buf[0], state_not_supported, 2);
         return 2;
@@ -5,6 +5,8 @@ extern "C" {
 #endif
 
 #include <furi.h>
+#include "fido_lab.h"
+#include "fido_p256.h"
 
 typedef enum {
     U2fNotifyRegister,
@@ -28,6 +30,8 @@ void u2f_free(U2fData* instance);
 
 void u2f_set_event_callback(U2fData* instance, U2fEvtCallback callback, void* context);
 
+void u2f_set_lab_policy(U2fData* instance, FidoLab* lab);
+
 void u2f_confirm_user_present(U2fData* instance);
 
 uint16_t u2f_msg_parse(U2fData* instance, uint8_t* buf, uint16_t len);
@@ -36,6 +40,24 @@ void u2f_wink(U2fData* instance);
 
 void u2f_set_state(U2fData* instance, uint8_t state);
 
+/**
+ * @brief Do one step of idle-time precomputation (e.g. an ECDSA nonce)
+ *
+ * Called by the HID worker while no request is pending. Also zeroizes
+ * expired key handle cache entries.
+ *
+ * @return true if work was done and there may be more
+ */
+bool u2f_precompute(U2fData* instance);
+
+/**
+ * @brief Yield between slices of idle-time precomputation
+ *
+ * Returning false drops the step in progress so a new request is served
+ * right away. Request processing itself always runs to completion.
+ */
+void u2f_set_yield_callback(U2fData* instance, FidoP256YieldCallback callback, void* context);
+
 #ifdef __cplusplus
 }
 #endif
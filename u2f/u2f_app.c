@@ -2,6 +2,7 @@
 #include "u2f_data.h"
 #include "fido2_app.h"
 #include "fido2_hid.h"
+#include "fido_drbg.h"
 #include <furi.h>
 #include <furi_hal.h>
 #include <storage/storage.h>
@@ -28,6 +29,9 @@ static void u2f_app_tick_event_callback(void* context) {
 
 U2fApp* u2f_app_alloc(void) {
     U2fApp* app = malloc(sizeof(U2fApp));
+
+    // Shared random source for U2F, FIDO2 and the storage layer
+    fido_drbg_init();
     
     // Initialize thread safety
     app->data_mutex = furi_mutex_alloc(FuriMutexTypeNormal);
@@ -146,6 +150,7 @@ void u2f_app_free(U2fApp* app) {
     furi_mutex_free(app->data_mutex);
 
     free(app);
+    fido_drbg_deinit();
     
     FURI_LOG_I(TAG, "U2F app freed");
 }
@@ -16,6 +16,7 @@
 #include "views/u2f_view.h"
 #include "u2f_hid.h"
 #include "u2f.h"
+#include "fido_lab.h"
 
 typedef enum {
     U2fAppErrorNoFiles,
@@ -67,6 +68,10 @@ struct U2fApp {
     // FIDO2 components
     void* fido2_instance;
     void* fido2_hid;
+
+    // Test-lab auto-presence policy, shared by both modes
+    FidoLab* lab;
+    bool lab_badge; // LAB shown on the main view, cleared once the policy expires
     
     // State management
     GpioCustomEvent event_cur;
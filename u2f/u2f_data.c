@@ -2,7 +2,7 @@
 #include "u2f_data.h"
 #include <furi_hal.h>
 #include <storage/storage.h>
-#include <furi_hal_random.h>
+#include "fido_drbg.h"
 #include <flipper_format/flipper_format.h>
 
 #define TAG "U2f"
@@ -27,6 +27,14 @@
 
 #define U2F_COUNTER_CONTROL_VAL 0xAA5500FF
 
+/**
+ * The counter is kept in two slots written alternately, so a torn write
+ * only ever damages the older value. The counter only goes up, so the
+ * highest valid slot is the newest one.
+ */
+static const char* const u2f_data_cnt_files[] = {U2F_CNT_FILE, U2F_CNT_FILE_B};
+static uint8_t u2f_data_cnt_slot; // slot holding the newest counter
+
 typedef struct {
     uint32_t counter;
     uint8_t random_salt[24];
@@ -50,7 +58,10 @@ bool u2f_data_check(bool cert_only) {
         storage_file_close(file);
         if(!storage_file_open(file, U2F_KEY_FILE, FSAM_READ, FSOM_OPEN_EXISTING)) break;
         storage_file_close(file);
-        if(!storage_file_open(file, U2F_CNT_FILE, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+        if(!storage_file_open(file, U2F_CNT_FILE, FSAM_READ, FSOM_OPEN_EXISTING)) {
+            storage_file_close(file);
+            if(!storage_file_open(file, U2F_CNT_FILE_B, FSAM_READ, FSOM_OPEN_EXISTING)) break;
+        }
         state = true;
     } while(0);
 
@@ -129,7 +140,7 @@ static bool u2f_data_cert_key_encrypt(uint8_t* cert_key) {
     FURI_LOG_I(TAG, "Encrypting user cert key");
 
     // Generate random IV
-    furi_hal_random_fill_buf(iv, 16);
+    fido_drbg_fill(iv, 16);
 
     if(!furi_hal_crypto_enclave_load_key(U2F_DATA_FILE_ENCRYPTION_KEY_SLOT_UNIQUE, iv)) {
         FURI_LOG_E(TAG, "Unable to load encryption key");
@@ -316,8 +327,8 @@ bool u2f_data_key_generate(uint8_t* device_key) {
     uint8_t key_encrypted[48];
 
     // Generate random IV and key
-    furi_hal_random_fill_buf(iv, 16);
-    furi_hal_random_fill_buf(key, 32);
+    fido_drbg_fill(iv, 16);
+    fido_drbg_fill(key, 32);
 
     if(!furi_hal_crypto_enclave_load_key(U2F_DATA_FILE_ENCRYPTION_KEY_SLOT_UNIQUE, iv)) {
         FURI_LOG_E(TAG, "Unable to load encryption key");
@@ -351,11 +362,13 @@ bool u2f_data_key_generate(uint8_t* device_key) {
     return state;
 }
 
-bool u2f_data_cnt_read(uint32_t* cnt_val) {
-    furi_assert(cnt_val);
-
+/**
+ * @brief Read one counter slot
+ *
+ * @param old_counter set if the slot is from the version with the endianness bug
+ */
+static bool u2f_data_cnt_read_slot(uint8_t slot, uint32_t* cnt_val, bool* old_counter) {
     bool state = false;
-    bool old_counter = false;
     uint8_t iv[16];
     U2fCounterData cnt;
     uint8_t cnt_encr[48];
@@ -367,7 +380,7 @@ bool u2f_data_cnt_read(uint32_t* cnt_val) {
     Storage* storage = furi_record_open(RECORD_STORAGE);
     FlipperFormat* flipper_format = flipper_format_file_alloc(storage);
 
-    if(flipper_format_file_open_existing(flipper_format, U2F_CNT_FILE)) {
+    if(flipper_format_file_open_existing(flipper_format, u2f_data_cnt_files[slot])) {
         do {
             if(!flipper_format_read_header(flipper_format, filetype, &version)) {
                 FURI_LOG_E(TAG, "Missing or incorrect header");
@@ -380,7 +393,7 @@ bool u2f_data_cnt_read(uint32_t* cnt_val) {
             if(version == U2F_COUNTER_VERSION_OLD) {
                 // Counter is from previous U2F app version with endianness bug
                 FURI_LOG_W(TAG, "Counter from old version");
-                old_counter = true;
+                *old_counter = true;
             } else if(version != U2F_COUNTER_VERSION) {
                 FURI_LOG_E(TAG, "Version mismatch");
                 break;
@@ -414,15 +427,35 @@ bool u2f_data_cnt_read(uint32_t* cnt_val) {
     furi_record_close(RECORD_STORAGE);
     furi_string_free(filetype);
 
-    if(old_counter && state) {
-        // Change counter endianness and rewrite counter file
-        *cnt_val = __REV(cnt.counter);
-        state = u2f_data_cnt_write(*cnt_val);
-    }
+    if(*old_counter && state) *cnt_val = __REV(cnt.counter);
 
     return state;
 }
 
+bool u2f_data_cnt_read(uint32_t* cnt_val) {
+    furi_assert(cnt_val);
+
+    bool found = false;
+    bool found_old = false;
+    for(uint8_t slot = 0; slot < COUNT_OF(u2f_data_cnt_files); slot++) {
+        uint32_t value = 0;
+        bool old_counter = false;
+        if(!u2f_data_cnt_read_slot(slot, &value, &old_counter)) continue;
+        if(!found || value > *cnt_val) {
+            *cnt_val = value;
+            found_old = old_counter;
+            u2f_data_cnt_slot = slot;
+            found = true;
+        }
+    }
+
+    if(found && found_old) {
+        // Counter from the version with the endianness bug, rewrite it
+        return u2f_data_cnt_write(*cnt_val);
+    }
+    return found;
+}
+
 bool u2f_data_cnt_write(uint32_t cnt_val) {
     bool state = false;
     uint8_t iv[16];
@@ -430,8 +463,8 @@ bool u2f_data_cnt_write(uint32_t cnt_val) {
     uint8_t cnt_encr[48];
 
     // Generate random IV and key
-    furi_hal_random_fill_buf(iv, 16);
-    furi_hal_random_fill_buf(cnt.random_salt, 24);
+    fido_drbg_fill(iv, 16);
+    fido_drbg_fill(cnt.random_salt, 24);
     cnt.control = U2F_COUNTER_CONTROL_VAL;
     cnt.counter = cnt_val;
 
@@ -446,10 +479,12 @@ bool u2f_data_cnt_write(uint32_t cnt_val) {
     }
     furi_hal_crypto_enclave_unload_key(U2F_DATA_FILE_ENCRYPTION_KEY_SLOT_UNIQUE);
 
+    // Leave the newest value alone until the new one is completely written
+    uint8_t slot = u2f_data_cnt_slot ^ 1;
     Storage* storage = furi_record_open(RECORD_STORAGE);
     FlipperFormat* flipper_format = flipper_format_file_alloc(storage);
 
-    if(flipper_format_file_open_always(flipper_format, U2F_CNT_FILE)) {
+    if(flipper_format_file_open_always(flipper_format, u2f_data_cnt_files[slot])) {
         do {
             if(!flipper_format_write_header_cstr(
                    flipper_format, U2F_COUNTER_FILE_TYPE, U2F_COUNTER_VERSION))
@@ -463,5 +498,6 @@ bool u2f_data_cnt_write(uint32_t cnt_val) {
     flipper_format_free(flipper_format);
     furi_record_close(RECORD_STORAGE);
 
+    if(state) u2f_data_cnt_slot = slot;
     return state;
 }
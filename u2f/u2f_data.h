@@ -10,7 +10,8 @@ extern "C" {
 #define U2F_CERT_FILE     U2F_DATA_FOLDER "assets/cert.der"
 #define U2F_CERT_KEY_FILE U2F_DATA_FOLDER "assets/cert_key.u2f"
 #define U2F_KEY_FILE      U2F_DATA_FOLDER "key.u2f"
-#define U2F_CNT_FILE      U2F_DATA_FOLDER "cnt.u2f"
+#define U2F_CNT_FILE      U2F_DATA_FOLDER "cnt.u2f" // counter slot A
+#define U2F_CNT_FILE_B    U2F_DATA_FOLDER "cnt_b.u2f" // counter slot B
 
 bool u2f_data_check(bool cert_only);
 bool u2f_data_cert_check(void);
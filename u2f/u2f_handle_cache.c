@@ -0,0 +1,127 @@
+#include "u2f_handle_cache.h"
+
+#include <furi.h>
+
+#include <string.h>
+
+#define TAG "U2fHandleCache"
+
+typedef struct {
+    uint8_t app_id[U2F_HANDLE_CACHE_ID_SIZE];
+    uint8_t handle[U2F_HANDLE_CACHE_HANDLE_SIZE];
+    uint8_t private_key[U2F_HANDLE_CACHE_KEY_SIZE];
+    uint32_t created; // tick of the verification, bounds the lifetime
+    uint32_t used; // tick of the last hit, for LRU eviction
+    bool valid;
+} U2fHandleCacheEntry;
+
+struct U2fHandleCache {
+    U2fHandleCacheEntry entries[U2F_HANDLE_CACHE_SIZE];
+    uint32_t hits;
+    uint32_t misses;
+};
+
+/**
+ * @brief Compare without an early exit, so timing does not reveal cached bytes
+ */
+static bool u2f_handle_cache_equal(const uint8_t* a, const uint8_t* b, size_t len) {
+    uint8_t diff = 0;
+    for(size_t i = 0; i < len; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static bool u2f_handle_cache_expired(const U2fHandleCacheEntry* entry, uint32_t now) {
+    return now - entry->created >= furi_ms_to_ticks(U2F_HANDLE_CACHE_TTL_MS);
+}
+
+U2fHandleCache* u2f_handle_cache_alloc(void) {
+    U2fHandleCache* cache = malloc(sizeof(U2fHandleCache));
+    memset(cache, 0, sizeof(U2fHandleCache));
+    return cache;
+}
+
+void u2f_handle_cache_free(U2fHandleCache* cache) {
+    if(!cache) return;
+    FURI_LOG_I(TAG, "%lu hits, %lu misses", cache->hits, cache->misses);
+    memset(cache, 0, sizeof(U2fHandleCache));
+    free(cache);
+}
+
+bool u2f_handle_cache_lookup(
+    U2fHandleCache* cache,
+    const uint8_t* app_id,
+    const uint8_t* handle,
+    uint8_t* private_key) {
+    furi_check(cache);
+    uint32_t now = furi_get_tick();
+
+    for(size_t i = 0; i < U2F_HANDLE_CACHE_SIZE; i++) {
+        U2fHandleCacheEntry* entry = &cache->entries[i];
+        if(!entry->valid) continue;
+        if(u2f_handle_cache_expired(entry, now)) {
+            memset(entry, 0, sizeof(U2fHandleCacheEntry));
+            continue;
+        }
+        if(u2f_handle_cache_equal(entry->app_id, app_id, sizeof(entry->app_id)) &&
+           u2f_handle_cache_equal(entry->handle, handle, sizeof(entry->handle))) {
+            memcpy(private_key, entry->private_key, sizeof(entry->private_key));
+            entry->used = now;
+            cache->hits++;
+            return true;
+        }
+    }
+
+    cache->misses++;
+    return false;
+}
+
+void u2f_handle_cache_insert(
+    U2fHandleCache* cache,
+    const uint8_t* app_id,
+    const uint8_t* handle,
+    const uint8_t* private_key) {
+    furi_check(cache);
+    uint32_t now = furi_get_tick();
+
+    // Reuse a free slot, otherwise evict the least recently used entry
+    U2fHandleCacheEntry* slot = &cache->entries[0];
+    for(size_t i = 0; i < U2F_HANDLE_CACHE_SIZE; i++) {
+        U2fHandleCacheEntry* entry = &cache->entries[i];
+        if(!entry->valid) {
+            slot = entry;
+            break;
+        }
+        if(now - entry->used > now - slot->used) slot = entry;
+    }
+
+    memcpy(slot->app_id, app_id, sizeof(slot->app_id));
+    memcpy(slot->handle, handle, sizeof(slot->handle));
+    memcpy(slot->private_key, private_key, sizeof(slot->private_key));
+    slot->created = now;
+    slot->used = now;
+    slot->valid = true;
+}
+
+bool u2f_handle_cache_expire(U2fHandleCache* cache) {
+    furi_check(cache);
+    uint32_t now = furi_get_tick();
+    bool live = false;
+
+    for(size_t i = 0; i < U2F_HANDLE_CACHE_SIZE; i++) {
+        U2fHandleCacheEntry* entry = &cache->entries[i];
+        if(!entry->valid) continue;
+        if(u2f_handle_cache_expired(entry, now)) {
+            memset(entry, 0, sizeof(U2fHandleCacheEntry));
+        } else {
+            live = true;
+        }
+    }
+    return live;
+}
+
+void u2f_handle_cache_clear(U2fHandleCache* cache) {
+    furi_check(cache);
+    memset(cache->entries, 0, sizeof(cache->entries));
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Short-lived cache of verified U2F key handles
+ *
+ * Browsers probe every handle of an allow list with a check-only request,
+ * then send an enforce request for the one that matched. Caching the
+ * private key derived for a verified (app_id, handle) pair lets the second
+ * request skip the unwrap and the control MAC.
+ *
+ * Entries are least-recently-used evicted and zeroized once they are
+ * U2F_HANDLE_CACHE_TTL_MS old. Not thread safe: use from the worker only.
+ */
+#define U2F_HANDLE_CACHE_SIZE   4
+#define U2F_HANDLE_CACHE_TTL_MS 5000
+
+#define U2F_HANDLE_CACHE_ID_SIZE     32 // app_id is already a SHA-256
+#define U2F_HANDLE_CACHE_HANDLE_SIZE 64 // key handle MAC || nonce
+#define U2F_HANDLE_CACHE_KEY_SIZE    32
+
+typedef struct U2fHandleCache U2fHandleCache;
+
+U2fHandleCache* u2f_handle_cache_alloc(void);
+
+/**
+ * @brief Zeroize all entries and free the cache
+ */
+void u2f_handle_cache_free(U2fHandleCache* cache);
+
+/**
+ * @brief Look up a verified handle
+ *
+ * @param private_key receives the derived key on a hit
+ * @return true on a hit
+ */
+bool u2f_handle_cache_lookup(
+    U2fHandleCache* cache,
+    const uint8_t* app_id,
+    const uint8_t* handle,
+    uint8_t* private_key);
+
+/**
+ * @brief Remember a handle that passed the control MAC check
+ */
+void u2f_handle_cache_insert(
+    U2fHandleCache* cache,
+    const uint8_t* app_id,
+    const uint8_t* handle,
+    const uint8_t* private_key);
+
+/**
+ * @brief Zeroize expired entries
+ *
+ * @return true if live entries remain, i.e. another call will be needed
+ */
+bool u2f_handle_cache_expire(U2fHandleCache* cache);
+
+/**
+ * @brief Zeroize all entries
+ */
+void u2f_handle_cache_clear(U2fHandleCache* cache);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,7 @@
 #include <furi.h>
 #include "u2f_hid.h"
 #include "u2f.h"
+#include "fido_drbg.h"
 #include <furi_hal.h>
 #include <gui/gui.h>
 #include <input/input.h>
@@ -38,6 +39,8 @@
 
 #define U2F_HID_BROADCAST_CID 0xFFFFFFFF
 
+#define U2F_HID_IDLE_TIMEOUT_MS 20 // Quiet time before idle precomputation steps
+
 typedef enum {
     WorkerEvtReserved = (1 << 0),
     WorkerEvtStop = (1 << 1),
@@ -164,7 +167,7 @@ static bool u2f_hid_parse_request(U2fHid* u2f_hid) {
            (u2f_hid->lock == true))
             return false;
         u2f_hid->packet.len = 17;
-        uint32_t random_cid = furi_hal_random_get();
+        uint32_t random_cid = fido_drbg_get();
         memcpy(&(u2f_hid->packet.payload[8]), &random_cid, sizeof(uint32_t)); //-V1086
         u2f_hid->packet.payload[12] = 2; // Protocol version
         u2f_hid->packet.payload[13] = 1; // Device version major
@@ -183,6 +186,14 @@ static bool u2f_hid_parse_request(U2fHid* u2f_hid) {
     return true;
 }
 
+/**
+ * @brief Drop the idle precomputation step in progress once there is work to do
+ */
+static bool u2f_hid_yield_callback(void* context) {
+    UNUSED(context);
+    return !(furi_thread_flags_get() & (WorkerEvtStop | WorkerEvtRequest));
+}
+
 static int32_t u2f_hid_worker(void* context) {
     U2fHid* u2f_hid = context;
     uint8_t packet_buf[HID_U2F_PACKET_LEN];
@@ -196,13 +207,21 @@ static int32_t u2f_hid_worker(void* context) {
         furi_timer_alloc(u2f_hid_lock_timeout_callback, FuriTimerTypeOnce, u2f_hid);
 
     furi_hal_hid_u2f_set_callback(u2f_hid_event_callback, u2f_hid);
+    u2f_set_yield_callback(u2f_hid->u2f_instance, u2f_hid_yield_callback, u2f_hid);
 
+    bool precompute_pending = true;
     while(1) {
         uint32_t flags = furi_thread_flags_wait(
             WorkerEvtStop | WorkerEvtConnect | WorkerEvtDisconnect | WorkerEvtRequest,
             FuriFlagWaitAny,
-            FuriWaitForever);
+            precompute_pending ? U2F_HID_IDLE_TIMEOUT_MS : FuriWaitForever);
+        if(flags == (uint32_t)FuriFlagErrorTimeout) {
+            // Idle: refill precomputed values one step at a time
+            precompute_pending = u2f_precompute(u2f_hid->u2f_instance);
+            continue;
+        }
         furi_check(!(flags & FuriFlagError));
+        precompute_pending = true;
         if(flags & WorkerEvtStop) break;
         if(flags & WorkerEvtConnect) {
             u2f_set_state(u2f_hid->u2f_instance, 1);
@@ -284,6 +303,7 @@ static int32_t u2f_hid_worker(void* context) {
     furi_timer_stop(u2f_hid->lock_timer);
     furi_timer_free(u2f_hid->lock_timer);
 
+    u2f_set_yield_callback(u2f_hid->u2f_instance, NULL, NULL);
     furi_hal_hid_u2f_set_callback(NULL, NULL);
     furi_hal_usb_set_config(usb_mode_prev, NULL);
     FURI_LOG_D(WORKER_TAG, "End");
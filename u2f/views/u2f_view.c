@@ -11,6 +11,7 @@ struct U2fView {
 
 typedef struct {
     U2fViewMsg display_msg;
+    bool lab_mode;
 } U2fModel;
 
 static void u2f_view_draw_callback(Canvas* canvas, void* _model) {
@@ -45,6 +46,14 @@ static void u2f_view_draw_callback(Canvas* canvas, void* _model) {
         canvas_draw_icon(canvas, 22, 15, &I_Connected_62x31);
         canvas_draw_str_aligned(canvas, 128 / 2, 3, AlignCenter, AlignTop, "FIDO2 Ready - Connect to device");
     }
+
+    if(model->lab_mode) {
+        // Presence is auto-confirmed: keep it impossible to miss
+        canvas_draw_rbox(canvas, 0, 52, 21, 12, 2);
+        canvas_invert_color(canvas);
+        canvas_draw_str(canvas, 3, 61, "LAB");
+        canvas_invert_color(canvas);
+    }
 }
 
 static bool u2f_view_input_callback(InputEvent* event, void* context) {
@@ -101,4 +110,8 @@ void u2f_view_set_ok_callback(U2fView* u2f, U2fOkCallback callback, void* contex
 
 void u2f_view_set_state(U2fView* u2f, U2fViewMsg msg) {
     with_view_model(u2f->view, U2fModel * model, { model->display_msg = msg; }, true);
+}
+
+void u2f_view_set_lab_mode(U2fView* u2f, bool lab_mode) {
+    with_view_model(u2f->view, U2fModel * model, { model->lab_mode = lab_mode; }, true);
 }
\ No newline at end of file
@@ -23,4 +23,6 @@ View* u2f_view_get_view(U2fView* u2f);
 
 void u2f_view_set_ok_callback(U2fView* u2f, U2fOkCallback callback, void* context);
 
-void u2f_view_set_state(U2fView* u2f, U2fViewMsg msg);
\ No newline at end of file
+void u2f_view_set_state(U2fView* u2f, U2fViewMsg msg);
+
+void u2f_view_set_lab_mode(U2fView* u2f, bool lab_mode);
\ No newline at end of file